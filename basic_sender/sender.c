@@ -1,8 +1,17 @@
 /*
- * gst_sender_gemini.c
- * build : sender % gcc gst_sender.c -o gst_sender `pkg-config --cflags --libs gstreamer-1.0 gstreamer-base-1.0 gstreamer-app-1.0 glib-2.0` -lm
- * PCM test : gst-launch-1.0 udpsrc port=5000 ! "application/x-rtp,media=(string)audio,clock-rate=(int)48000,encoding-name=(string)L16,encoding-params=(string)2,channels=(int)2,payload=(int)96" ! rtpL16depay ! audioconvert ! autoaudiosink
- * AC3 test : gst-launch-1.0 udpsrc port=5000 ! "application/x-rtp,media=(string)audio,clock-rate=(int)48000,encoding-name=(string)AC3" ! rtpac3depay ! ac3parse ! avdec_ac3 ! audioconvert ! autoaudiosink
+ * sender.c
+ * build : sender % gcc -Wall -Wextra sender.c ../common/producer_pool.c ../common/feed_producer.c ../common/synth_source.c ../common/ac3_frame.c ../common/egress.c ../common/thread_topology.c ../common/pipeline_trace.c ../common/ring_logger.c ../common/rtp_continuity.c ../common/codec_registry.c ../common/pcap_capture.c ../common/latency_profile.c ../common/rtcp_feedback.c -o sender `pkg-config --cflags --libs gio-2.0 gstreamer-1.0 gstreamer-base-1.0 gstreamer-app-1.0 gstreamer-rtp-1.0 glib-2.0` -lm
+ * run : ./sender [--incremental]   (--incremental swaps only the codec segment on a format change)
+ *       ./sender --ac3-passthrough  (AC3 periods feed already-encoded AC3 frames: ac3parse ! rtpac3pay, no avenc_ac3)
+ *       ./sender --batched-egress   (RTP packets leave through sendmmsg/UDP GSO batches instead of one sendto each)
+ *       ./sender --feed-latency=10  (each push carries at most 10 ms of audio; default 20, fractions such as 2.5 allowed)
+ *       ./sender --latency-profile=low  (5 ms chunks, low-delay Opus, unsynced sink; stamps capture times for ./receiver)
+ *       ./sender --pcm-codec=opus   (codec for PCM periods: l16 (default), l24, opus, aac, ...; --list-codecs)
+ *       ./sender --pcap=/tmp/egress.pcap  (every sent RTP packet is captured; replay with fancy_sender/pcap_replay)
+ *       ./sender --topology=throughput  (queues between capture/convert/encode/send; also: low-latency, single)
+ *       PIPELINE_TRACE=/tmp/trace.json ./sender  (per-element latency/throughput histograms dumped as JSON)
+ * PCM test : gst-launch-1.0 udpsrc port=5000 ! "application/x-rtp,media=(string)audio,clock-rate=(int)48000,encoding-name=(string)L16,encoding-params=(string)2,channels=(int)2,payload=(int)98" ! rtpL16depay ! audioconvert ! autoaudiosink
+ * AC3 test : gst-launch-1.0 udpsrc port=5000 ! "application/x-rtp,media=(string)audio,clock-rate=(int)48000,encoding-name=(string)AC3,payload=(int)97" ! rtpac3depay ! ac3parse ! avdec_ac3 ! audioconvert ! autoaudiosink
 */
 
 
@@ -10,18 +19,34 @@
 #include <glib.h>
 #include <stdio.h>
 #include <string.h>
-#include <math.h> // For sin() in PCM data generation for demonstration
 
 // REQUIRED for appsrc functions and macros
 #include <gst/app/gstappsrc.h>
 
+// Phase-continuous test-signal generator
+#include "../common/synth_source.h"
+
+// Bounded producer thread: generates chunks into a lock-free ring and pushes them only
+// between appsrc's need-data and enough-data, so memory stays bounded by the ring plus
+// appsrc max-bytes even when the encoder falls behind.
+#include "../common/feed_producer.h"
+
+// End-to-end latency profile. "low" shrinks every stage together: producer chunks, appsrc
+// latency, Opus frame size and payloader ptime, egress sink syncing and the batching budget.
+// It also stamps each packet with its capture time so ./receiver can report glass-to-glass
+// latency. AC3 keeps its fixed 32 ms frames; only the surrounding stages shrink.
+#include "../common/latency_profile.h"
+
+// Thread topology: depending on the profile chosen with --topology, queues split
+// capture / conversion / encoding / network send onto their own streaming threads.
+// With the default "single" profile no queue is inserted.
+#include "../common/thread_topology.h"
+
 // Global GStreamer elements and state variables
 GstElement *pipeline = NULL;      // The main GStreamer pipeline
 GstElement *appsrc = NULL;        // Source element to push data into the pipeline
 GstElement *audioconvert = NULL;  // Converts audio formats (e.g., S16LE to float)
 GstElement *audioresample = NULL; // Resamples audio to a different rate
-GstElement *encoder = NULL;       // Encoder for specific formats (e.g., AC3) or passthrough element
-GstElement *rtppayloader = NULL;  // Converts raw audio/encoded data into RTP packets
 GstElement *udpsink = NULL;       // Sends data over UDP
 
 GstBus *bus = NULL;               // GStreamer bus for receiving messages
@@ -33,6 +58,66 @@ gboolean is_pcm_format = FALSE;
 // Global GMainLoop instance so it can be accessed from configure_pipeline
 GMainLoop *main_loop = NULL;
 
+// Incremental reconfiguration mode (--incremental): appsrc, audioconvert, audioresample
+// and udpsink live for the whole process; only the codec segment between them is swapped.
+gboolean incremental_mode = FALSE;
+GstElement *codec_segment = NULL; // Bin holding encoder/parse/payloader (from the codec registry)
+
+// AC3 passthrough mode (--ac3-passthrough): the AC3 input is already compressed, so the
+// pipeline only frames and payloads it (appsrc -> ac3parse -> rtpac3pay -> udpsink).
+gboolean ac3_passthrough = FALSE;
+
+// RTP egress (../common/egress.c): a plain udpsink, or an appsink feeding a shared
+// sendmmsg/GSO batcher (--batched-egress). Either way the element is kept in `udpsink`.
+typedef enum { EGRESS_UDPSINK, EGRESS_BATCHED } EgressMode;
+void egress_configure(EgressMode mode, guint batch, guint budget_us);
+GstElement *egress_make_sink(guint port);
+void egress_report(void);
+void egress_shutdown(void);
+#define EGRESS_BATCH 64              // Max packets per sendmmsg call
+#define EGRESS_LATENCY_BUDGET_US 1000 // Max time a packet waits for its batch
+
+// Per-element tracing (../common/pipeline_trace.c). Only active when the PIPELINE_TRACE
+// environment variable is set; otherwise pipeline_trace_attach() installs nothing.
+gboolean pipeline_trace_init(void);
+void pipeline_trace_attach(GstElement *bin, const gchar *label);
+void pipeline_trace_shutdown(void);
+
+// Asynchronous logger (../common/ring_logger.c) used by the shared modules for prints made
+// on streaming threads; shutting it down flushes whatever they still have queued.
+void ring_logger_shutdown(void);
+
+// One RTP session for the whole process (../common/rtp_continuity.c): every egress sink gets a
+// probe that rewrites SSRC, sequence number and timestamp, so a rebuilt pipeline or swapped codec
+// segment continues the same stream instead of starting a new one. Each codec keeps its own
+// payload type so receivers can pick the depayloader from the header alone. A switch to a codec
+// with a different RTP clock rate (E-AC3 through rtpgstpay runs at 90 kHz) starts a new SSRC.
+typedef struct _RtpContinuity RtpContinuity;
+RtpContinuity *rtp_continuity_new(void);
+guint32 rtp_continuity_get_ssrc(RtpContinuity *c);
+void rtp_continuity_attach(RtpContinuity *c, GstElement *sink);
+RtpContinuity *rtp_session = NULL;
+
+// Egress capture (../common/pcap_capture.c): with --pcap=FILE every packet handed to an egress
+// sink is appended to a pcap file, across pipeline rebuilds, for replay with pcap_replay.
+gboolean pcap_capture_open(const gchar *path);
+void pcap_capture_attach(GstElement *sink);
+void pcap_capture_close(void);
+
+// Shared codec registry (../common/codec_registry.c): one descriptor per codec with its element
+// factories resolved and its caps built once, so a switch only instantiates elements. The codec
+// for PCM periods is chosen with --pcm-codec (default L16); AC3 periods use "ac3" or, with
+// --ac3-passthrough, "ac3-passthrough".
+typedef struct _CodecDescriptor CodecDescriptor;
+void codec_registry_init(void);
+void codec_registry_dump(void);
+const CodecDescriptor *codec_registry_lookup(const gchar *name);
+GstElement *codec_registry_make_segment(const CodecDescriptor *codec);
+const gchar *codec_get_label(const CodecDescriptor *codec);
+gboolean codec_has_encoded_input(const CodecDescriptor *codec);
+GstCaps *codec_get_input_caps(const CodecDescriptor *codec);
+const gchar *pcm_codec_name = "l16"; // --pcm-codec=NAME
+
 // Structure to hold current audio data parameters for generation
 typedef struct _CurrentAudioDataParams {
     char format[10];  // "PCM" or "AC3"
@@ -42,17 +127,106 @@ typedef struct _CurrentAudioDataParams {
 } CurrentAudioDataParams;
 
 CurrentAudioDataParams current_audio_data_params; // Global instance to store current format parameters
+// Guards current_audio_data_params and is_pcm_format: the feed producer thread reads them,
+// the main loop (and the incremental swap's IDLE probe) rewrites them
+G_LOCK_DEFINE_STATIC(audio_format);
+
+#define FEED_LATENCY_MS 20           // Default upper bound on the audio carried by one push
+#define FEED_RING_SLOTS 8            // Chunks the producer may generate ahead of appsrc
+FeedProducer *feed_producer = NULL;  // Producer attached to the current appsrc
+guint feed_latency_us = FEED_LATENCY_MS * 1000; // --feed-latency=MS, or the latency profile's chunk
+
+#define AC3_FRAME_DURATION (32 * GST_MSECOND) // 1536 samples at 48 kHz
+
+SynthSource *feed_synth = NULL;      // 440 Hz sine for fill_feed_chunk(); keeps its phase across buffers
+SynthSource *feed_ac3_synth = NULL;  // Compressed AC3 frames for passthrough mode
 
 // --- Function Prototypes ---
-static void start_feed(GstElement *appsrc, guint size, gpointer user_data);
-static void stop_feed(GstElement *appsrc, gpointer user_data);
+static gsize fill_feed_chunk(guint8 *data, gsize max_size, GstClockTime max_duration,
+                             GstClockTime *duration, gpointer user_data);
+static void start_feed_producer(void);
+static const CodecDescriptor *codec_for_format(const char *audio_format);
 static void configure_pipeline(const char *audio_format);
+static void build_persistent_pipeline(const char *audio_format);
+static void swap_codec_segment(const char *audio_format);
 // Removed 'static' keyword from declaration
 void handle_audio_format_change(const char *new_format); 
+void init_audio_data_params(const char *format);
+void teardown_pipeline(void);
 static gboolean bus_call(GstBus *bus, GstMessage *msg, gpointer data);
 static gboolean simulate_audio_data_feed(gpointer user_data); // Renamed for clarity
 
 
+/**
+ * @brief Sets the PCM generation parameters for the given format.
+ * Both formats are fed as 48 kHz stereo S16LE; AC3 is encoded inside the pipeline.
+ *
+ * @param format The audio format name ("PCM" or "AC3").
+ */
+void init_audio_data_params(const char *format) {
+    G_LOCK(audio_format);
+    g_strlcpy(current_audio_data_params.format, format, sizeof(current_audio_data_params.format));
+    current_audio_data_params.sample_rate = 48000;
+    current_audio_data_params.channels = 2;
+    current_audio_data_params.depth = 16;
+    G_UNLOCK(audio_format);
+}
+
+/**
+ * @brief Publishes whether PCM is being sent, which also selects what the feed producer generates.
+ * Called from the main loop and from the incremental swap's IDLE probe.
+ *
+ * @param is_pcm TRUE for PCM, FALSE for AC3.
+ */
+static void set_pcm_format(gboolean is_pcm) {
+    G_LOCK(audio_format);
+    is_pcm_format = is_pcm;
+    G_UNLOCK(audio_format);
+}
+
+/**
+ * @brief Sets the current pipeline to NULL, releases it and removes its bus watch.
+ * All global element pointers are reset so a new pipeline can be configured.
+ */
+void teardown_pipeline(void) {
+    if (!pipeline) return;
+
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    feed_producer_stop(feed_producer); // appsrc's streaming thread has stopped by now
+    feed_producer = NULL;
+    gst_object_unref(pipeline);
+    pipeline = NULL; // Reset global pointers to NULL
+    appsrc = NULL;
+    audioconvert = NULL;
+    audioresample = NULL;
+    udpsink = NULL;
+    codec_segment = NULL;
+    // Remove the existing bus watch to prevent callbacks on the old pipeline
+    if (bus_watch_id) {
+        g_source_remove(bus_watch_id);
+        bus_watch_id = 0;
+    }
+}
+
+/**
+ * @brief Attaches the process-wide RTP session to a newly created egress sink.
+ * The session is created on first use, so programs linking this file without main() get it too.
+ * The latency stamp and pcap capture probes go after the rewrite, so the file holds the packets
+ * exactly as sent. The sink's sync settings follow the latency profile.
+ *
+ * @param sink The egress sink (udpsink or batched appsink).
+ */
+static void attach_rtp_session(GstElement *sink) {
+    if (!rtp_session) {
+        rtp_session = rtp_continuity_new();
+        g_print("RTP session SSRC 0x%08x (kept across format switches at the same RTP clock rate)\n", rtp_continuity_get_ssrc(rtp_session));
+    }
+    rtp_continuity_attach(rtp_session, sink);
+    latency_profile_stamp(sink);
+    pcap_capture_attach(sink);
+    latency_profile_tune_element(sink);
+}
+
 /**
  * @brief Configures (creates or re-creates) the GStreamer pipeline based on the audio format.
  * This is the core logic for dynamic pipeline switching.
@@ -62,24 +236,10 @@ static gboolean simulate_audio_data_feed(gpointer user_data); // Renamed for cla
 static void configure_pipeline(const char *audio_format) {
     g_print("Configuring pipeline for %s format.\n", audio_format);
 
-    // If a pipeline already exists, set it to NULL state and unreference it
-    // This effectively tears down the old pipeline and its elements.
+    // If a pipeline already exists, tear down the old pipeline and its elements.
     if (pipeline) {
         g_print("Cleaning up existing pipeline...\n");
-        gst_element_set_state(pipeline, GST_STATE_NULL);
-        gst_object_unref(pipeline);
-        pipeline = NULL; // Reset global pointers to NULL
-        appsrc = NULL;
-        audioconvert = NULL;
-        audioresample = NULL;
-        encoder = NULL;
-        rtppayloader = NULL;
-        udpsink = NULL;
-        // Remove the existing bus watch to prevent callbacks on the old pipeline
-        if (bus_watch_id) {
-            g_source_remove(bus_watch_id);
-            bus_watch_id = 0;
-        }
+        teardown_pipeline();
     }
 
     // Create a new GStreamer pipeline
@@ -99,116 +259,64 @@ static void configure_pipeline(const char *audio_format) {
     g_object_set(G_OBJECT(appsrc), "is-live", TRUE, NULL);       // Treat as a live source
     g_object_set(G_OBJECT(appsrc), "format", GST_FORMAT_TIME, NULL); // Use time-based format
     g_object_set(G_OBJECT(appsrc), "do-timestamp", TRUE, NULL);  // Automatically add timestamps to buffers
+    latency_profile_tune_appsrc(appsrc, feed_latency_us);        // Low-latency profile: report one chunk
 
-    // Connect "need-data" and "enough-data" signals to appsrc
-    g_signal_connect(appsrc, "need-data", G_CALLBACK(start_feed), NULL);
-    g_signal_connect(appsrc, "enough-data", G_CALLBACK(stop_feed), NULL);
+    // The producer thread follows appsrc's "need-data"/"enough-data" signals,
+    // so the format it generates is published first
+    set_pcm_format(g_strcmp0(audio_format, "PCM") == 0);
+    start_feed_producer();
 
-    // Create the udpsink element
-    udpsink = gst_element_factory_make("udpsink", "my-udpsink");
+    // Create the egress sink (udpsink, or batched appsink) sending to localhost on port 5000
+    udpsink = egress_make_sink(5000);
     if (!udpsink) {
-        g_printerr("Failed to create udpsink element.\n");
+        g_printerr("Failed to create egress sink element.\n");
         goto error_exit;
     }
-    // Configure udpsink to send to localhost on port 5000
-    g_object_set(G_OBJECT(udpsink), "host", "127.0.0.1", "port", 5000, NULL);
-
-    // Dynamically create and link elements based on the audio format
-    if (g_strcmp0(audio_format, "PCM") == 0) {
-        is_pcm_format = TRUE; // Update global format flag
-        g_print("Configuring PCM pipeline: appsrc -> audioconvert -> audioresample -> rtpL16pay -> udpsink\n");
-
-        // Set PCM CAPS on appsrc
-        GstCaps *appsrc_caps = gst_caps_new_simple("audio/x-raw",
-                                          "format", G_TYPE_STRING, "S16LE",
-                                          "rate", G_TYPE_INT, current_audio_data_params.sample_rate,
-                                          "channels", G_TYPE_INT, current_audio_data_params.channels,
-                                          "layout", G_TYPE_STRING, "interleaved",
-                                          NULL);
-        g_object_set(G_OBJECT(appsrc), "caps", appsrc_caps, NULL);
-        gst_caps_unref(appsrc_caps);
-
-        // Create audioconvert (for format conversion if needed)
-        audioconvert = gst_element_factory_make("audioconvert", "my-audioconvert");
-        if (!audioconvert) { g_printerr("Failed to create audioconvert.\n"); goto error_exit; }
-        // Create audioresample (for sample rate conversion if needed)
-        audioresample = gst_element_factory_make("audioresample", "my-audioresample");
-        if (!audioresample) { g_printerr("Failed to create audioresample.\n"); goto error_exit; }
-        // Create rtpL16pay (RTP payload for raw 16-bit linear PCM)
-        encoder = gst_element_factory_make("rtpL16pay", "my-rtppay");
-        if (!encoder) { g_printerr("Failed to create rtpL16pay.\n"); goto error_exit; }
-        rtppayloader = encoder; // rtpL16pay acts as the payloader
-
-        // Add all elements to the pipeline bin
-        gst_bin_add_many(GST_BIN(pipeline), appsrc, audioconvert, audioresample, rtppayloader, udpsink, NULL);
-        // Link the elements in sequence
-        if (!gst_element_link_many(appsrc, audioconvert, audioresample, rtppayloader, udpsink, NULL)) {
-            g_printerr("Failed to link PCM pipeline elements.\n");
+    attach_rtp_session(udpsink);
+
+    // The codec part (encoder/parser/payloader) comes from the shared codec registry
+    const CodecDescriptor *codec = codec_for_format(audio_format);
+    if (!codec) goto error_exit;
+    codec_segment = codec_registry_make_segment(codec);
+    if (!codec_segment) { g_printerr("Failed to create %s codec segment.\n", codec_get_label(codec)); goto error_exit; }
+
+    // appsrc caps are prebuilt by the registry (48 kHz stereo S16LE, or the compressed format)
+    g_object_set(G_OBJECT(appsrc), "caps", codec_get_input_caps(codec), NULL);
+
+    if (codec_has_encoded_input(codec)) {
+        // The input is already compressed, so it is only re-framed and payloaded (no decode/encode)
+        g_print("Configuring %s pipeline: appsrc -> [%s segment] -> udpsink\n", audio_format, codec_get_label(codec));
+        gst_bin_add_many(GST_BIN(pipeline), appsrc, codec_segment, udpsink, NULL);
+        if (!thread_topology_link(GST_BIN(pipeline), appsrc, codec_segment, STAGE_CONVERT) ||
+            !thread_topology_link(GST_BIN(pipeline), codec_segment, udpsink, STAGE_SEND)) {
+            g_printerr("Failed to link %s pipeline elements.\n", codec_get_label(codec));
             goto error_exit;
         }
+    } else {
+        g_print("Configuring %s pipeline: appsrc -> audioconvert -> audioresample -> [%s segment] -> udpsink\n",
+                audio_format, codec_get_label(codec));
 
-    } else if (g_strcmp0(audio_format, "AC3") == 0) {
-        is_pcm_format = FALSE; // Update global format flag
-        g_print("Configuring AC3 pipeline: appsrc -> audioconvert -> audioresample -> avenc_ac3 -> ac3parse -> rtpac3pay -> udpsink\n");
-
-        // For AC3, we'll feed PCM data to appsrc and encode it to AC3
-        GstCaps *appsrc_caps = gst_caps_new_simple("audio/x-raw",
-                                          "format", G_TYPE_STRING, "S16LE",
-                                          "rate", G_TYPE_INT, current_audio_data_params.sample_rate,
-                                          "channels", G_TYPE_INT, current_audio_data_params.channels,
-                                          "layout", G_TYPE_STRING, "interleaved",
-                                          NULL);
-        g_object_set(G_OBJECT(appsrc), "caps", appsrc_caps, NULL);
-        gst_caps_unref(appsrc_caps);
-
-        // Create audioconvert and audioresample for format preparation
+        // Create audioconvert and audioresample (format / sample rate conversion if needed)
         audioconvert = gst_element_factory_make("audioconvert", "my-audioconvert");
         if (!audioconvert) { g_printerr("Failed to create audioconvert.\n"); goto error_exit; }
-        
         audioresample = gst_element_factory_make("audioresample", "my-audioresample");
         if (!audioresample) { g_printerr("Failed to create audioresample.\n"); goto error_exit; }
 
-        // Create AC3 encoder
-        GstElement *ac3encoder = gst_element_factory_make("avenc_ac3", "my-ac3encoder");
-        if (!ac3encoder) { 
-            g_printerr("Failed to create avenc_ac3. Trying lamemp3enc as fallback.\n"); 
-            // Fallback to MP3 if AC3 encoder is not available
-            ac3encoder = gst_element_factory_make("lamemp3enc", "my-mp3encoder");
-            if (!ac3encoder) {
-                g_printerr("Failed to create any audio encoder.\n");
-                goto error_exit;
-            }
-        }
-        encoder = ac3encoder;
-
-        // Create ac3parse (parses AC3 stream and adds proper headers)
-        GstElement *ac3parse = gst_element_factory_make("ac3parse", "my-ac3parse");
-        if (!ac3parse) { g_printerr("Failed to create ac3parse.\n"); goto error_exit; }
-
-        // Create rtpac3pay (RTP payload for AC3 encoded audio)
-        rtppayloader = gst_element_factory_make("rtpac3pay", "my-rtpac3pay");
-        if (!rtppayloader) { 
-            g_printerr("Failed to create rtpac3pay. Using rtpmpapay as fallback.\n"); 
-            rtppayloader = gst_element_factory_make("rtpmpapay", "my-rtpmpapay");
-            if (!rtppayloader) {
-                g_printerr("Failed to create RTP payloader.\n");
-                goto error_exit;
-            }
-        }
-
-        // Add elements to the pipeline bin
-        gst_bin_add_many(GST_BIN(pipeline), appsrc, audioconvert, audioresample, encoder, ac3parse, rtppayloader, udpsink, NULL);
-        
-        // Link the elements
-        if (!gst_element_link_many(appsrc, audioconvert, audioresample, encoder, ac3parse, rtppayloader, udpsink, NULL)) {
-            g_printerr("Failed to link AC3 pipeline elements.\n");
+        // Add all elements to the pipeline bin and link them
+        // (stage-boundary queues are inserted according to the thread topology)
+        gst_bin_add_many(GST_BIN(pipeline), appsrc, audioconvert, audioresample, codec_segment, udpsink, NULL);
+        if (!thread_topology_link(GST_BIN(pipeline), appsrc, audioconvert, STAGE_CONVERT) ||
+            !gst_element_link(audioconvert, audioresample) ||
+            !thread_topology_link(GST_BIN(pipeline), audioresample, codec_segment, STAGE_ENCODE) ||
+            !thread_topology_link(GST_BIN(pipeline), codec_segment, udpsink, STAGE_SEND)) {
+            g_printerr("Failed to link %s pipeline elements.\n", codec_get_label(codec));
             goto error_exit;
         }
-    } else {
-        g_printerr("Unsupported audio format: %s\n", audio_format);
-        goto error_exit;
     }
 
+    // Per-element tracing, aggregated per format (no-op unless PIPELINE_TRACE is set)
+    pipeline_trace_attach(pipeline, audio_format);
+
     // Set the pipeline to PLAYING state. This makes it ready to process data.
     GstStateChangeReturn ret = gst_element_set_state(pipeline, GST_STATE_PLAYING);
     if (ret == GST_STATE_CHANGE_FAILURE) {
@@ -244,6 +352,8 @@ static void configure_pipeline(const char *audio_format) {
 error_exit:
     if (pipeline) {
         gst_element_set_state(pipeline, GST_STATE_NULL); // Set to NULL state to release resources
+        feed_producer_stop(feed_producer);
+        feed_producer = NULL;
         gst_object_unref(pipeline); // Unreference the pipeline
         pipeline = NULL; // Reset global pipeline pointer
     }
@@ -256,67 +366,290 @@ error_exit:
 
 
 /**
- * @brief Callback for appsrc's "need-data" signal.
- * This function generates and pushes audio data to appsrc when it needs more.
+ * @brief Maps a sender format name to its codec registry entry.
+ * PCM periods use --pcm-codec (L16 by default); AC3 periods are encoded with avenc_ac3,
+ * or only re-framed when the input is already AC3 (--ac3-passthrough).
  *
- * @param appsrc The GstAppSrc element.
- * @param size The amount of data (in bytes) appsrc ideally needs.
- * @param user_data User data (not used in this case, but could be for context).
+ * @param audio_format The audio format ("PCM" or "AC3").
+ * @return const CodecDescriptor* The codec, or NULL if unknown or not installed.
  */
-static void start_feed(GstElement *appsrc, guint size, gpointer user_data) {
-    GstBuffer *buffer;
-    GstFlowReturn ret;
-    guint8 *data_buffer;
-    guint data_size;
+static const CodecDescriptor *codec_for_format(const char *audio_format) {
+    if (g_strcmp0(audio_format, "PCM") == 0) return codec_registry_lookup(pcm_codec_name);
+    if (g_strcmp0(audio_format, "AC3") == 0) return codec_registry_lookup(ac3_passthrough ? "ac3-passthrough" : "ac3");
+    g_printerr("Unsupported audio format: %s\n", audio_format);
+    return NULL;
+}
 
-    // Generate PCM data for both PCM and AC3 formats
-    // For AC3, the PCM data will be encoded by avenc_ac3 in the pipeline
-    
-    // Generate 0.1 seconds of PCM data
-    data_size = current_audio_data_params.sample_rate * current_audio_data_params.channels * (current_audio_data_params.depth / 8) / 10;
-    data_buffer = g_malloc(data_size);
-    if (!data_buffer) {
-        g_printerr("Memory allocation failed for PCM data in start_feed.\n");
-        gst_app_src_end_of_stream(GST_APP_SRC(appsrc));
-        return;
+/**
+ * @brief Creates the codec segment (encoder/parse/payloader) for a format.
+ * The registry wraps it in a bin with "sink" and "src" ghost pads so it can be
+ * linked between the persistent audioresample and udpsink.
+ *
+ * @param audio_format The desired audio format ("PCM" or "AC3").
+ * @return GstElement* The new segment bin, or NULL on failure.
+ */
+static GstElement *create_codec_segment(const char *audio_format) {
+    const CodecDescriptor *codec = codec_for_format(audio_format);
+
+    return codec ? codec_registry_make_segment(codec) : NULL;
+}
+
+/**
+ * @brief Builds the long-lived pipeline used by incremental mode:
+ * appsrc -> audioconvert -> audioresample -> [codec segment] -> udpsink
+ * (plus the stage-boundary queues of the selected thread topology).
+ * Only the codec segment is ever replaced afterwards (see swap_codec_segment()).
+ *
+ * @param audio_format The initial audio format ("PCM" or "AC3").
+ */
+static void build_persistent_pipeline(const char *audio_format) {
+    g_print("Building persistent pipeline (incremental mode) for %s format.\n", audio_format);
+
+    pipeline = gst_pipeline_new("audio-sender-pipeline");
+    appsrc = gst_element_factory_make("appsrc", "my-appsrc");
+    audioconvert = gst_element_factory_make("audioconvert", "my-audioconvert");
+    audioresample = gst_element_factory_make("audioresample", "my-audioresample");
+    udpsink = egress_make_sink(5000);
+    codec_segment = create_codec_segment(audio_format);
+    if (!pipeline || !appsrc || !audioconvert || !audioresample || !udpsink || !codec_segment) {
+        g_printerr("Failed to create persistent pipeline elements.\n");
+        goto error_exit;
     }
-    
-    // Fill with a simple sine wave (440 Hz) for demonstration
-    for (int i = 0; i < data_size / (current_audio_data_params.depth / 8); ++i) {
-        ((gint16*)data_buffer)[i] = (gint16)(32000 * sin(2 * G_PI * 440 * (double)i / (current_audio_data_params.sample_rate * current_audio_data_params.channels)));
+    set_pcm_format(g_strcmp0(audio_format, "PCM") == 0);
+    attach_rtp_session(udpsink);
+
+    // Same appsrc setup as configure_pipeline(); PCM is fed for both formats
+    g_object_set(G_OBJECT(appsrc), "is-live", TRUE, "format", GST_FORMAT_TIME, "do-timestamp", TRUE, NULL);
+    latency_profile_tune_appsrc(appsrc, feed_latency_us);
+    g_object_set(G_OBJECT(appsrc), "caps", codec_get_input_caps(codec_for_format("PCM")), NULL);
+    start_feed_producer();
+
+    gst_bin_add_many(GST_BIN(pipeline), appsrc, audioconvert, audioresample, codec_segment, udpsink, NULL);
+    if (!thread_topology_link(GST_BIN(pipeline), appsrc, audioconvert, STAGE_CONVERT) ||
+        !gst_element_link(audioconvert, audioresample) ||
+        !thread_topology_link(GST_BIN(pipeline), audioresample, codec_segment, STAGE_ENCODE) ||
+        !thread_topology_link(GST_BIN(pipeline), codec_segment, udpsink, STAGE_SEND)) {
+        g_printerr("Failed to link persistent pipeline.\n");
+        goto error_exit;
     }
 
-    buffer = gst_buffer_new_and_alloc(data_size);
-    gst_buffer_fill(buffer, 0, data_buffer, data_size);
-    g_free(data_buffer); // Free the temporary data buffer
+    pipeline_trace_attach(pipeline, "persistent"); // Segments swapped in later are traced on their own
 
-    ret = gst_app_src_push_buffer(GST_APP_SRC(appsrc), buffer);
-    if (ret != GST_FLOW_OK) {
-        g_printerr("Failed to push data to appsrc: %d\n", ret);
-        gst_buffer_unref(buffer);
-        gst_app_src_end_of_stream(GST_APP_SRC(appsrc)); // Signal EOS on push failure
+    if (gst_element_set_state(pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+        g_printerr("Failed to set pipeline to PLAYING state.\n");
+        goto error_exit;
     }
+
+    bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline));
+    bus_watch_id = gst_bus_add_watch(bus, bus_call, main_loop);
+    gst_object_unref(bus);
+    return;
+
+error_exit:
+    if (pipeline) {
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        feed_producer_stop(feed_producer);
+        feed_producer = NULL;
+        gst_object_unref(pipeline);
+        pipeline = NULL;
+    }
+    g_printerr("An error occurred while building the persistent pipeline. Exiting application.\n");
+    if (main_loop) {
+        g_main_loop_quit(main_loop);
+    }
+}
+
+// State handed from swap_codec_segment() to the IDLE probe and the disposal idle callback
+typedef struct _SegmentSwap {
+    GstElement *old_segment;
+    GstElement *new_segment;
+    GstElement *upstream;   // Element feeding the segment (audioresample or an encode-stage queue)
+    GstElement *downstream; // Element after the segment (udpsink or a send-stage queue)
+    gboolean is_pcm;        // Format of the new segment, committed only once it is linked
+    gint64 start_us; // When the swap was requested (g_get_monotonic_time)
+} SegmentSwap;
+
+/**
+ * @brief Main-loop callback that shuts down and removes a replaced codec segment.
+ * Runs outside the streaming thread so setting the segment to NULL cannot deadlock.
+ */
+static gboolean dispose_codec_segment(gpointer user_data) {
+    GstElement *old_segment = GST_ELEMENT(user_data);
+
+    gst_element_set_state(old_segment, GST_STATE_NULL);
+    gst_bin_remove(GST_BIN(pipeline), old_segment);
+    gst_object_unref(old_segment);
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * @brief Returns the element linked to the given static pad of an element (unreferenced).
+ * Used to find the neighbours of the codec segment, which may be topology queues.
+ */
+static GstElement *peer_element(GstElement *element, const char *pad_name) {
+    GstPad *pad = gst_element_get_static_pad(element, pad_name);
+    GstPad *peer = gst_pad_get_peer(pad);
+    GstElement *parent = peer ? gst_pad_get_parent_element(peer) : NULL;
+
+    gst_object_unref(pad);
+    if (peer) gst_object_unref(peer);
+    if (parent) gst_object_unref(parent); // Still owned by the pipeline
+    return parent;
+}
+
+/**
+ * @brief IDLE probe on the segment's upstream src pad: relinks the new codec segment while
+ * no buffer is in flight. appsrc, converters and udpsink keep their state untouched.
+ */
+static GstPadProbeReturn on_segment_upstream_idle(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    SegmentSwap *swap = (SegmentSwap *)user_data;
+
+    gst_element_unlink_many(swap->upstream, swap->old_segment, swap->downstream, NULL);
+    if (!gst_element_link_many(swap->upstream, swap->new_segment, swap->downstream, NULL)) {
+        // Undo whatever half of the link succeeded, put the old segment back and drop the new one
+        g_printerr("Failed to link new codec segment, keeping the current one.\n");
+        gst_element_unlink_many(swap->upstream, swap->new_segment, swap->downstream, NULL);
+        if (!gst_element_link_many(swap->upstream, swap->old_segment, swap->downstream, NULL))
+            g_printerr("Failed to relink the current codec segment.\n");
+        g_idle_add(dispose_codec_segment, gst_object_ref(swap->new_segment));
+        gst_object_unref(swap->old_segment);
+        g_free(swap);
+        return GST_PAD_PROBE_REMOVE;
+    }
+    codec_segment = swap->new_segment;
+    set_pcm_format(swap->is_pcm);
+
+    g_print("[SWITCH-COST] incremental: %" G_GINT64_FORMAT " us\n",
+            g_get_monotonic_time() - swap->start_us);
+
+    // Hand the old segment over to the main loop for teardown
+    g_idle_add(dispose_codec_segment, swap->old_segment);
+    g_free(swap);
+    return GST_PAD_PROBE_REMOVE;
+}
+
+/**
+ * @brief Replaces only the codec segment of the persistent pipeline.
+ * The new segment is brought to PLAYING before it is linked, so the swap itself is
+ * just a relink done from an IDLE probe; the pipeline never leaves PLAYING.
+ *
+ * @param audio_format The desired audio format ("PCM" or "AC3").
+ */
+static void swap_codec_segment(const char *audio_format) {
+    SegmentSwap *swap;
+    GstPad *pad;
+    gint64 start_us = g_get_monotonic_time();
+    GstElement *new_segment = create_codec_segment(audio_format);
+
+    if (!new_segment) {
+        g_printerr("Keeping current codec segment.\n");
+        return;
+    }
+
+    gst_bin_add(GST_BIN(pipeline), new_segment);
+    pipeline_trace_attach(new_segment, audio_format);
+    gst_element_sync_state_with_parent(new_segment);
+
+    swap = g_new0(SegmentSwap, 1);
+    swap->old_segment = gst_object_ref(codec_segment);
+    swap->new_segment = new_segment;
+    swap->upstream = peer_element(codec_segment, "sink");
+    swap->downstream = peer_element(codec_segment, "src");
+    swap->is_pcm = (g_strcmp0(audio_format, "PCM") == 0);
+    swap->start_us = start_us;
+
+    pad = gst_element_get_static_pad(swap->upstream, "src");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_IDLE, on_segment_upstream_idle, swap, NULL);
+    gst_object_unref(pad);
 }
 
+
 /**
- * @brief Callback for appsrc's "enough-data" signal.
- * This function is called when appsrc has enough data.
- * For this example, we don't need to do anything specific here,
- * as data is pushed on demand via "need-data".
+ * @brief Fill callback of the feed producer (runs on the producer thread).
+ * Writes whole frames only: PCM sample frames, or complete AC3 frames in passthrough mode,
+ * never more than max_size bytes or max_duration of audio.
  *
- * @param appsrc The GstAppSrc element.
- * @param user_data User data.
+ * @param data Pooled buffer memory to fill.
+ * @param max_size Byte budget for this chunk (derived from appsrc's need-data request).
+ * @param max_duration Latency target: the longest chunk allowed.
+ * @param duration Set to the playback duration of the bytes written.
+ * @param user_data Unused.
+ * @return gsize Number of bytes written (0 skips this chunk).
  */
-static void stop_feed(GstElement *appsrc, gpointer user_data) {
-    g_print("Appsrc has enough data. Temporarily stopping data generation (if continuous).\n");
-    // In a real scenario, you might pause a data generation thread here.
+static gsize fill_feed_chunk(guint8 *data, gsize max_size, GstClockTime max_duration,
+                             GstClockTime *duration, gpointer user_data) {
+    // Generate PCM data for both PCM and AC3 formats
+    // For AC3, the PCM data will be encoded by avenc_ac3 in the pipeline,
+    // unless passthrough mode is on, in which case whole AC3 frames are pushed as-is.
+    CurrentAudioDataParams params;
+    gboolean push_ac3;
+    guint rate;
+    gsize size;
+
+    // One consistent snapshot per chunk; the main loop may be switching formats right now
+    G_LOCK(audio_format);
+    params = current_audio_data_params;
+    push_ac3 = ac3_passthrough && !is_pcm_format;
+    G_UNLOCK(audio_format);
+    rate = params.sample_rate;
+
+    if (push_ac3) {
+        guint64 frames = MIN(max_size / SYNTH_AC3_FRAME_BYTES, max_duration / AC3_FRAME_DURATION);
+
+        frames = MAX(frames, 1); // One 32 ms frame even under a shorter latency target
+        if (frames * SYNTH_AC3_FRAME_BYTES > max_size) return 0;
+        size = frames * SYNTH_AC3_FRAME_BYTES;
+        *duration = frames * AC3_FRAME_DURATION;
+
+        if (!feed_ac3_synth) {
+            feed_ac3_synth = synth_source_new(SYNTH_AC3_BURST, rate, params.channels, 0.0, 1.0);
+        }
+        synth_source_fill(feed_ac3_synth, data, size);
+    } else {
+        guint bytes_per_frame = params.channels * (params.depth / 8);
+        guint64 frames = MIN(max_size / bytes_per_frame, gst_util_uint64_scale(max_duration, rate, GST_SECOND));
+
+        if (frames == 0) return 0;
+        size = frames * bytes_per_frame;
+        *duration = gst_util_uint64_scale(frames, GST_SECOND, rate);
+
+        // The wavetable oscillator continues its phase from the previous chunk, so there are no clicks.
+        if (!feed_synth) {
+            feed_synth = synth_source_new(SYNTH_SINE, rate, params.channels,
+                                          440.0, 32000.0 / 32768.0);
+        }
+        synth_source_fill(feed_synth, data, size);
+    }
+    return size;
+}
+
+/**
+ * @brief Attaches a bounded producer thread to the current appsrc.
+ * Chunks are at most feed_latency_us long; appsrc max-bytes holds two of them, and the
+ * producer keeps at most FEED_RING_SLOTS more ready. Generation runs in real time and
+ * drops chunks rather than queueing latency when downstream is slower.
+ */
+static void start_feed_producer(void) {
+    guint bytes_per_second = current_audio_data_params.sample_rate * current_audio_data_params.channels *
+                             (current_audio_data_params.depth / 8);
+    FeedProducerConfig config = {
+        .ring_slots = FEED_RING_SLOTS,
+        .latency_us = feed_latency_us,
+        // PCM bytes for the latency target, but never less than one AC3 frame
+        .max_chunk = MAX((gsize)bytes_per_second * feed_latency_us / G_USEC_PER_SEC, SYNTH_AC3_FRAME_BYTES),
+        .max_bytes = 0,
+        .realtime = TRUE,
+    };
+
+    feed_producer = feed_producer_start(appsrc, &config, fill_feed_chunk, NULL);
+    if (!feed_producer) g_printerr("Failed to start the feed producer.\n");
 }
 
 
 /**
  * @brief This function will alternate between PCM and AC3 format.
  * It updates the global `current_audio_data_params` and triggers pipeline reconfiguration.
- * Data pushing is handled by appsrc's "need-data" signal.
+ * Data pushing is handled by the feed producer thread (see start_feed_producer()).
  *
  * @param user_data User data (GMainLoop).
  * @return gboolean TRUE to continue calling this timeout function, FALSE to stop.
@@ -325,20 +658,18 @@ static gboolean simulate_audio_data_feed(gpointer user_data) {
     static int toggle = 0; // Used to alternate between PCM and AC3
     GMainLoop *loop_ptr = (GMainLoop *)user_data; // Cast user_data to GMainLoop*
 
+    egress_report(); // Packets/sec, packets per syscall and CPU since the previous switch
+    thread_topology_report(); // Per-stage queue fill (nothing in the single-thread topology)
+    feed_producer_report(feed_producer); // Pushes, drops, underruns and enough-data since start
+
     if (toggle % 2 == 0) {
         g_print("Switching to PCM format.\n");
-        strcpy(current_audio_data_params.format, "PCM");
-        current_audio_data_params.sample_rate = 48000;
-        current_audio_data_params.channels = 2;
-        current_audio_data_params.depth = 16;
+        init_audio_data_params("PCM");
         handle_audio_format_change("PCM");
     } else {
         g_print("Switching to AC3 format.\n");
-        strcpy(current_audio_data_params.format, "AC3");
-        // For AC3 encoding, we still need PCM input parameters
-        current_audio_data_params.sample_rate = 48000; // AC3 supports 48kHz
-        current_audio_data_params.channels = 2;        // Stereo for AC3
-        current_audio_data_params.depth = 16;          // 16-bit PCM input
+        // For AC3 encoding, we still need PCM input parameters (48 kHz stereo S16LE)
+        init_audio_data_params("AC3");
         handle_audio_format_change("AC3");
     }
     
@@ -414,17 +745,33 @@ static gboolean bus_call(GstBus *bus, GstMessage *msg, gpointer data) {
 // Removed 'static' keyword from definition and moved it here
 void handle_audio_format_change(const char *new_format) {
     gboolean new_is_pcm = (g_strcmp0(new_format, "PCM") == 0);
+    gboolean is_pcm;
+
+    G_LOCK(audio_format);
+    is_pcm = is_pcm_format; // An incremental swap commits it from the streaming thread
+    G_UNLOCK(audio_format);
 
     // Reconfigure pipeline only if it's NULL (first run) or if the format has changed
-    if (pipeline == NULL || (new_is_pcm != is_pcm_format)) {
+    if (pipeline == NULL || (new_is_pcm != is_pcm)) {
         g_print("Audio format change detected: Current %s -> New %s. Reconfiguring pipeline.\n", 
-                is_pcm_format ? "PCM" : "AC3", new_format);
-        configure_pipeline(new_format);
+                is_pcm ? "PCM" : "AC3", new_format);
+        if (incremental_mode && pipeline) {
+            swap_codec_segment(new_format);
+        } else if (incremental_mode) {
+            build_persistent_pipeline(new_format);
+        } else {
+            gint64 start_us = g_get_monotonic_time();
+            configure_pipeline(new_format);
+            g_print("[SWITCH-COST] rebuild: %" G_GINT64_FORMAT " us\n", g_get_monotonic_time() - start_us);
+        }
     }
 }
 
+// SENDER_NO_MAIN lets other programs (e.g. fancy_sender/switch_bench) link this file
+// and drive handle_audio_format_change() directly.
+#ifndef SENDER_NO_MAIN
 /**
- * @brief Main function of the gst_sender application.
+ * @brief Main function of the sender application.
  * Initializes GStreamer, sets up a main loop, and simulates audio data
  * input with format switching.
  *
@@ -433,25 +780,84 @@ void handle_audio_format_change(const char *new_format) {
  * @return int Application exit code.
  */
 int main(int argc, char *argv[]) {
+    LatencyProfile latency = LATENCY_DEFAULT;
+    guint requested_chunk_us = 0;    // --feed-latency, if given
+    gboolean batched_egress = FALSE; // Configured after parsing, with the profile's latency budget
+
     // Initialize GStreamer library
     gst_init(&argc, &argv);
 
     // Create a GLib Main Loop to handle events (like GStreamer messages, timeouts)
     main_loop = g_main_loop_new(NULL, FALSE); // Assign to global main_loop
 
-    g_print("Starting `gst_sender` application. Waiting for audio data...\n");
+    g_print("Starting `sender` application. Waiting for audio data...\n");
 
     // Initialize current_audio_data_params with a default format (e.g., PCM)
-    strcpy(current_audio_data_params.format, "PCM");
-    current_audio_data_params.sample_rate = 48000;
-    current_audio_data_params.channels = 2;
-    current_audio_data_params.depth = 16;
-    
+    init_audio_data_params("PCM");
+    pipeline_trace_init(); // Tracing is enabled by the PIPELINE_TRACE environment variable
+
+    // --incremental keeps appsrc/converters/udpsink alive and swaps only the codec segment
+    for (int i = 1; i < argc; i++) {
+        if (g_strcmp0(argv[i], "--incremental") == 0) {
+            incremental_mode = TRUE;
+        } else if (g_strcmp0(argv[i], "--ac3-passthrough") == 0) {
+            ac3_passthrough = TRUE;
+        } else if (g_strcmp0(argv[i], "--batched-egress") == 0) {
+            batched_egress = TRUE;
+        } else if (g_str_has_prefix(argv[i], "--feed-latency=")) {
+            gchar *end;
+            gdouble ms = g_ascii_strtod(argv[i] + strlen("--feed-latency="), &end);
+            if (*end || ms < 0.25 || ms > 1000.0) {
+                g_printerr("Invalid feed latency: %s\n", argv[i] + strlen("--feed-latency="));
+                return -1;
+            }
+            feed_latency_us = requested_chunk_us = (guint)(ms * 1000);
+        } else if (g_str_has_prefix(argv[i], "--latency-profile=")) {
+            if (!latency_profile_parse(argv[i] + strlen("--latency-profile="), &latency)) {
+                g_printerr("Unknown latency profile: %s\n", argv[i] + strlen("--latency-profile="));
+                return -1;
+            }
+        } else if (g_str_has_prefix(argv[i], "--pcap=")) {
+            if (!pcap_capture_open(argv[i] + strlen("--pcap="))) return -1;
+        } else if (g_str_has_prefix(argv[i], "--pcm-codec=")) {
+            pcm_codec_name = argv[i] + strlen("--pcm-codec=");
+        } else if (g_strcmp0(argv[i], "--list-codecs") == 0) {
+            codec_registry_dump();
+            return 0;
+        } else if (g_str_has_prefix(argv[i], "--topology=")) {
+            TopologyProfile profile;
+            if (!thread_topology_parse(argv[i] + strlen("--topology="), &profile)) {
+                g_printerr("Unknown thread topology: %s\n", argv[i] + strlen("--topology="));
+                return -1;
+            }
+            thread_topology_configure(profile);
+        }
+    }
+    // The profile picks the chunk size unless --feed-latency set one (clamped to 2.5-10 ms when low)
+    latency_profile_configure(latency, requested_chunk_us);
+    feed_latency_us = latency_profile_chunk_us(feed_latency_us);
+    if (batched_egress)
+        egress_configure(EGRESS_BATCHED, EGRESS_BATCH, latency_profile_egress_budget_us(EGRESS_LATENCY_BUDGET_US));
+
+    // Resolve codec element factories and caps once, before the first pipeline is built
+    codec_registry_init();
+    if (!codec_for_format("PCM")) return -1;
+
+    // The persistent audioconvert/audioresample cannot carry compressed AC3
+    if (incremental_mode && ac3_passthrough) {
+        g_printerr("--ac3-passthrough is not supported with --incremental; using full rebuilds.\n");
+        incremental_mode = FALSE;
+    }
+
     // Configure the initial pipeline
-    configure_pipeline("PCM");
+    if (incremental_mode) {
+        build_persistent_pipeline("PCM");
+    } else {
+        configure_pipeline("PCM");
+    }
 
     // This timeout function will alternate between PCM and AC3 format every 5 seconds.
-    // It only triggers the format change, data pushing is handled by appsrc signals.
+    // It only triggers the format change, data pushing is handled by the feed producer.
     g_timeout_add_seconds(5, simulate_audio_data_feed, main_loop); // Pass global main_loop
 
     // Start the GLib Main Loop, which will run until g_main_loop_quit() is called
@@ -461,11 +867,15 @@ int main(int argc, char *argv[]) {
     // Set the pipeline to NULL state to release all resources
     if (pipeline) {
         g_print("Application exiting: Cleaning up pipeline...\n");
-        gst_element_set_state(pipeline, GST_STATE_NULL);
-        gst_object_unref(pipeline); // Unreference the pipeline object
+        teardown_pipeline();
     }
+    egress_shutdown(); // Flushes any batched packets and stops the batcher thread
+    pcap_capture_close();
+    pipeline_trace_shutdown(); // Writes the final stats dump
+    ring_logger_shutdown(); // Flushes records still queued by streaming threads
     g_main_loop_unref(main_loop); // Unreference the main loop
     gst_deinit(); // Deinitialize GStreamer resources
 
     return 0; // Exit successfully
-}
\ No newline at end of file
+}
+#endif /* SENDER_NO_MAIN */
@@ -0,0 +1,134 @@
+// ac3_frame.c
+/*
+ * AC3 sync frame 헤더 유틸 (ATSC A/52 syncinfo / bsi 앞부분)
+ *
+ *  [0..1] syncword 0x0B77  [2..3] crc1  [4] fscod(2) | frmsizecod(6)  [5] bsid(5) | bsmod(3)
+ */
+#include <glib.h>
+#include <string.h>
+
+#define AC3_SAMPLES_PER_FRAME 1536
+
+// frmsizecod >> 1 → kbps
+static const guint16 ac3_bitrates_kbps[19] = {
+    32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512, 576, 640
+};
+
+static const guint ac3_sample_rates[3] = { 48000, 44100, 32000 };
+
+// 📌 data가 AC3 sync frame의 시작이면 프레임 크기(바이트), 아니면 0
+guint ac3_frame_size(const guint8 *data, gsize len) {
+    guint fscod, frmsizecod, bitrate;
+
+    if (len < 6 || data[0] != 0x0B || data[1] != 0x77) return 0;
+    if ((data[5] >> 3) > 10) return 0; // bsid: AC3는 10 이하 (E-AC3는 16)
+
+    fscod = data[4] >> 6;
+    frmsizecod = data[4] & 0x3F;
+    if (fscod == 3 || frmsizecod > 37) return 0;
+
+    bitrate = ac3_bitrates_kbps[frmsizecod >> 1];
+    switch (fscod) {
+    case 0:  return bitrate * 2 * 2;                                  // 48 kHz: 2*kbps word
+    case 1:  return (bitrate * 320 / 147 + (frmsizecod & 1)) * 2;     // 44.1 kHz: 홀수 코드는 +1 word
+    default: return bitrate * 3 * 2;                                  // 32 kHz: 3*kbps word
+    }
+}
+
+// 📌 AC3 프레임의 샘플레이트 (헤더가 아니면 0)
+guint ac3_sample_rate(const guint8 *data, gsize len) {
+    if (len < 5 || data[0] != 0x0B || data[1] != 0x77 || (data[4] >> 6) == 3) return 0;
+    return ac3_sample_rates[data[4] >> 6];
+}
+
+// 📌 다음 syncword(0x0B77) 위치 찾기 (memchr로 0x0B를 건너뛰며 검색), 없으면 NULL
+const guint8 *ac3_find_sync(const guint8 *data, gsize len) {
+    const guint8 *p = data, *end = data + len;
+
+    while (p + 1 < end) {
+        p = memchr(p, 0x0B, (end - 1) - p);
+        if (!p) return NULL;
+        if (p[1] == 0x77) return p;
+        p++;
+    }
+    return NULL;
+}
+
+// CRC-16 (x^16 + x^15 + x^2 + 1, 초기값 0, 비반전) — AC3 crc1/crc2
+#define AC3_CRC_POLY 0x8005
+// x는 이 다항식에서 위수 32767 (x^15 + x + 1 이 원시 다항식)
+#define AC3_CRC_ORDER 32767
+
+static guint16 ac3_crc_table[256];
+
+static void ac3_crc_init(void) {
+    static gsize initialized = 0;
+
+    if (g_once_init_enter(&initialized)) {
+        for (guint i = 0; i < 256; i++) {
+            guint16 c = i << 8;
+            for (int b = 0; b < 8; b++) c = (c & 0x8000) ? (c << 1) ^ AC3_CRC_POLY : (c << 1);
+            ac3_crc_table[i] = c;
+        }
+        g_once_init_leave(&initialized, 1);
+    }
+}
+
+guint16 ac3_crc16(guint16 crc, const guint8 *data, gsize len) {
+    ac3_crc_init();
+    while (len--) crc = (crc << 8) ^ ac3_crc_table[(crc >> 8) ^ *data++];
+    return crc;
+}
+
+// GF(2) 다항식 곱셈 mod (x^16 + x^15 + x^2 + 1)
+static guint16 crc_poly_mul(guint32 a, guint32 b) {
+    guint32 r = 0;
+
+    while (b) {
+        if (b & 1) r ^= a;
+        b >>= 1;
+        a <<= 1;
+        if (a & 0x10000) a ^= 0x10000 | AC3_CRC_POLY;
+    }
+    return (guint16)r;
+}
+
+// x^n mod poly
+static guint16 crc_poly_pow_x(guint n) {
+    guint32 r = 1, base = 2;
+
+    while (n) {
+        if (n & 1) r = crc_poly_mul(r, base);
+        base = crc_poly_mul(base, base);
+        n >>= 1;
+    }
+    return (guint16)r;
+}
+
+// 프레임 앞 5/8 지점 (crc1 범위 끝, 바이트)
+guint ac3_frame_size_58(guint frame_size) {
+    return ((frame_size >> 2) + (frame_size >> 4)) << 1;
+}
+
+// 📌 crc1 검사: [2, 5/8) 구간 CRC가 0이어야 함
+gboolean ac3_check_crc1(const guint8 *frame, guint frame_size) {
+    return ac3_crc16(0, frame + 2, ac3_frame_size_58(frame_size) - 2) == 0;
+}
+
+// 📌 나머지 필드를 채운 프레임에 crc1/crc2 기록
+// crc1은 구간 맨 앞에 있으므로 CRC(뒤 데이터) * x^-(8L+16) 로 역산한다.
+void ac3_write_frame_crcs(guint8 *frame, guint frame_size) {
+    guint size_58 = ac3_frame_size_58(frame_size);
+    guint len = size_58 - 4;
+    guint16 crc1, crc2;
+
+    crc1 = ac3_crc16(0, frame + 4, len);
+    crc1 = crc_poly_mul(crc1, crc_poly_pow_x((AC3_CRC_ORDER - (8 * len + 16) % AC3_CRC_ORDER) % AC3_CRC_ORDER));
+    frame[2] = crc1 >> 8;
+    frame[3] = crc1 & 0xFF;
+
+    // 앞 5/8의 CRC가 0이므로 crc2는 뒤쪽 구간에 대한 일반 CRC
+    crc2 = ac3_crc16(0, frame + size_58, frame_size - size_58 - 2);
+    frame[frame_size - 2] = crc2 >> 8;
+    frame[frame_size - 1] = crc2 & 0xFF;
+}
@@ -0,0 +1,355 @@
+// codec_registry.c
+/*
+ * 송신 코덱 등록부 (fancy_sender / basic_sender 공용)
+ *
+ * 코덱마다 descriptor 하나: 요소 이름 목록(encoder/parse/payloader, 마지막이 payloader),
+ * RTP payload type, appsrc에 줄 입력 caps, 요소 속성을 정하는 setup hook.
+ * 등록할 때 GstElementFactory를 미리 찾아 두고 caps도 미리 만들어 두므로, 전환 때는
+ * gst_element_factory_create()로 요소만 찍어 낸다 (이름으로 registry 검색, caps 문자열 파싱 없음).
+ * factory가 없는 코덱은 등록은 되지만 사용할 수 없음으로 표시된다.
+ *
+ *   이름             입력        요소                               PT
+ *   opus             raw         opusenc ! rtpopuspay              96
+ *   ac3              raw         avenc_ac3 ! ac3parse ! rtpac3pay  97
+ *   ac3-passthrough  AC3 프레임  ac3parse ! rtpac3pay              97
+ *   l16              raw         rtpL16pay                         98
+ *   l24              raw         rtpL24pay                         99
+ *   eac3             raw         avenc_eac3 ! ac3parse ! rtpgstpay 100 (E-AC3 전용 RTP payloader가 없어 GStreamer 일반 payloader)
+ *   aac              raw         avenc_aac ! aacparse ! rtpmp4apay 101
+ *
+ * raw 입력은 48 kHz stereo S16LE (두 송신기의 appsrc 형식). 다른 형식은 앞의 audioconvert/audioresample이 맞춘다.
+ *
+ * 사용:
+ *   const CodecDescriptor *codec = codec_registry_lookup("opus");
+ *   GstElement *bin = codec_registry_make_bin(codec, &sink);     // [convert ! resample !] codec ! egress sink
+ *   GstElement *seg = codec_registry_make_segment(codec);        // codec 요소만 (ghost sink/src)
+ *   GstElement *enc = codec_registry_make_encoder(codec);        // payloader 뺀 부분 (일괄 변환)
+ *   GstElement *q = codec_registry_make_element("queue");        // 코덱 앞뒤 공용 요소 (변환, stage queue, egress sink)
+ *
+ * 코덱 추가: builtin_codecs에 descriptor 한 줄 (또는 codec_registry_register()). 전환 코드는 그대로.
+ */
+#include <gst/gst.h>
+#include <string.h>
+
+#include "latency_profile.h"
+#include "thread_topology.h"
+
+#define CODEC_MAX_ELEMENTS 4
+#define CODEC_UDP_PORT 5000
+#define RAW_INPUT_CAPS "audio/x-raw,format=S16LE,rate=48000,channels=2,layout=interleaved"
+
+typedef struct _CodecDescriptor CodecDescriptor;
+
+// 요소를 만든 직후 속성 설정 (elements: descriptor의 elements 순서, pt는 이미 설정됨.
+// 체인 일부만 만들 때는 만들지 않은 자리가 NULL)
+typedef void (*CodecSetupFunc)(const CodecDescriptor *codec, GstElement **elements);
+
+struct _CodecDescriptor {
+    const gchar *name;            // 조회 이름
+    const gchar *label;           // 로그용
+    const gchar *encoding_name;   // RTP encoding-name (수신기 caps)
+    guint pt;
+    gint clock_rate;
+    gint channels;                // L16/L24처럼 caps에 채널 수가 들어가는 코덱만 (0이면 생략)
+    gboolean encoded_input;       // TRUE: 입력이 이미 압축 → convert/resample 없음
+    const gchar *input_caps_str;  // appsrc caps
+    const gchar *elements[CODEC_MAX_ELEMENTS]; // NULL로 끝. 마지막이 payloader
+    CodecSetupFunc setup;
+    guint frame_samples;          // 코덱 프레임 길이 (샘플, 분할 경계용). raw는 0
+    const gchar *container;       // 인코딩 결과를 파일로 쓸 때 muxer (NULL이면 elementary stream 그대로)
+
+    // codec_registry_register()가 채운다
+    GstElementFactory *factories[CODEC_MAX_ELEMENTS];
+    guint n_elements;
+    GstCaps *input_caps;
+    GstCaps *rtp_caps;
+    gboolean available;
+};
+
+// ../common/egress.c
+GstElement *egress_make_sink(guint port);
+
+// ../common/rtcp_feedback.c
+void rtcp_feedback_track_encoder(GstElement *element);
+
+static void setup_aac(const CodecDescriptor *codec, GstElement **elements) {
+    if (elements[0]) g_object_set(elements[0], "bitrate", 128000, NULL);
+}
+
+static void setup_eac3(const CodecDescriptor *codec, GstElement **elements) {
+    if (elements[0]) g_object_set(elements[0], "bitrate", 256000, NULL);
+    // rtpgstpay는 caps를 in-band로 보낸다. 처음 한 번만 보내면 나중에 붙은 수신기는 디코딩할 수 없으므로 1초마다
+    if (elements[2]) g_object_set(elements[2], "config-interval", 1, NULL);
+}
+
+static CodecDescriptor builtin_codecs[] = {
+    { "opus", "Opus", "OPUS", 96, 48000, 0, FALSE, RAW_INPUT_CAPS,
+      { "opusenc", "rtpopuspay" }, NULL, 960, "oggmux" },
+    { "ac3", "AC3", "AC3", 97, 48000, 0, FALSE, RAW_INPUT_CAPS,
+      { "avenc_ac3", "ac3parse", "rtpac3pay" }, NULL, 1536, NULL },
+    { "ac3-passthrough", "AC3 passthrough", "AC3", 97, 48000, 0, TRUE, "audio/x-ac3",
+      { "ac3parse", "rtpac3pay" }, NULL, 1536, NULL },
+    { "l16", "L16", "L16", 98, 48000, 2, FALSE, RAW_INPUT_CAPS,
+      { "rtpL16pay" }, NULL, 0, NULL },
+    { "l24", "L24", "L24", 99, 48000, 2, FALSE, RAW_INPUT_CAPS,
+      { "rtpL24pay" }, NULL, 0, NULL },
+    { "eac3", "E-AC3", "X-GST", 100, 90000, 0, FALSE, RAW_INPUT_CAPS,
+      { "avenc_eac3", "ac3parse", "rtpgstpay" }, setup_eac3, 1536, NULL },
+    { "aac", "AAC", "MP4A-LATM", 101, 48000, 0, FALSE, RAW_INPUT_CAPS,
+      { "avenc_aac", "aacparse", "rtpmp4apay" }, setup_aac, 1024, "mp4mux" },
+};
+
+static GPtrArray *codecs = NULL;
+static GMutex codecs_lock;
+
+// 코덱 체인 앞뒤에 붙는 공용 요소. 코덱 요소처럼 factory는 init에서 한 번만 찾는다
+static const gchar *const common_element_names[] = {
+    "audioconvert", "audioresample", "queue", "multiudpsink", "appsink",
+};
+static GstElementFactory *common_factories[G_N_ELEMENTS(common_element_names)];
+
+// 📌 descriptor 등록: factory 검색과 caps 생성은 여기서 한 번만
+// codec은 프로세스가 끝날 때까지 살아 있어야 한다 (보통 static). 사용할 수 있으면 TRUE
+gboolean codec_registry_register(CodecDescriptor *codec) {
+    codec->available = TRUE;
+    codec->n_elements = 0;
+    for (guint i = 0; i < CODEC_MAX_ELEMENTS && codec->elements[i]; i++) {
+        codec->factories[i] = gst_element_factory_find(codec->elements[i]);
+        if (!codec->factories[i]) codec->available = FALSE;
+        codec->n_elements++;
+    }
+
+    codec->input_caps = gst_caps_from_string(codec->input_caps_str);
+    codec->rtp_caps = gst_caps_new_simple("application/x-rtp",
+                                          "media", G_TYPE_STRING, "audio",
+                                          "clock-rate", G_TYPE_INT, codec->clock_rate,
+                                          "encoding-name", G_TYPE_STRING, codec->encoding_name,
+                                          "payload", G_TYPE_INT, codec->pt,
+                                          NULL);
+    if (codec->channels > 0) {
+        gchar *params = g_strdup_printf("%d", codec->channels);
+        gst_caps_set_simple(codec->rtp_caps,
+                            "encoding-params", G_TYPE_STRING, params,
+                            "channels", G_TYPE_INT, codec->channels,
+                            NULL);
+        g_free(params);
+    }
+
+    g_mutex_lock(&codecs_lock);
+    if (!codecs) codecs = g_ptr_array_new();
+    g_ptr_array_add(codecs, codec);
+    g_mutex_unlock(&codecs_lock);
+    return codec->available;
+}
+
+static gpointer register_builtin_codecs(gpointer data) {
+    for (guint i = 0; i < G_N_ELEMENTS(common_element_names); i++)
+        common_factories[i] = gst_element_factory_find(common_element_names[i]);
+    for (guint i = 0; i < G_N_ELEMENTS(builtin_codecs); i++)
+        codec_registry_register(&builtin_codecs[i]);
+    return NULL;
+}
+
+// 📌 내장 코덱 등록 (gst_init 뒤, 여러 번 불러도 한 번만)
+void codec_registry_init(void) {
+    static GOnce once = G_ONCE_INIT;
+    g_once(&once, register_builtin_codecs, NULL);
+}
+
+// 📌 공용 요소 생성 (init에서 찾아 둔 factory로, 전환 때 registry 검색 없음). 없으면 NULL
+GstElement *codec_registry_make_element(const gchar *factory_name) {
+    codec_registry_init();
+    for (guint i = 0; i < G_N_ELEMENTS(common_element_names); i++) {
+        if (strcmp(common_element_names[i], factory_name) != 0) continue;
+        if (!common_factories[i]) {
+            g_printerr("[CODEC] %s 없음 (설치되어 있지 않음)\n", factory_name);
+            return NULL;
+        }
+        return gst_element_factory_create(common_factories[i], NULL);
+    }
+    g_printerr("[CODEC] 등록되지 않은 공용 요소: %s\n", factory_name);
+    return NULL;
+}
+
+static CodecDescriptor *find_codec(const gchar *name) {
+    CodecDescriptor *found = NULL;
+
+    codec_registry_init();
+    g_mutex_lock(&codecs_lock);
+    for (guint i = 0; i < codecs->len; i++) {
+        CodecDescriptor *codec = g_ptr_array_index(codecs, i);
+        if (g_strcmp0(codec->name, name) == 0) {
+            found = codec;
+            break;
+        }
+    }
+    g_mutex_unlock(&codecs_lock);
+    return found;
+}
+
+// 📌 이름으로 찾기. 없거나 필요한 요소가 설치되어 있지 않으면 NULL
+const CodecDescriptor *codec_registry_lookup(const gchar *name) {
+    const CodecDescriptor *found = find_codec(name);
+
+    if (!found) {
+        g_printerr("[CODEC] 모르는 코덱: %s\n", name);
+        return NULL;
+    }
+    if (!found->available) {
+        g_printerr("[CODEC] %s 사용 불가 (필요한 요소가 설치되어 있지 않음)\n", found->label);
+        return NULL;
+    }
+    return found;
+}
+
+// 📌 코덱의 입력(appsrc) caps. 요소 설치 여부와 상관없이 미리 만든 caps (소유권은 등록부)
+GstCaps *codec_registry_get_input_caps(const gchar *name) {
+    const CodecDescriptor *codec = find_codec(name);
+    return codec ? codec->input_caps : NULL;
+}
+
+// 📌 등록된 코덱 목록 출력 (--list-codecs 등)
+void codec_registry_dump(void) {
+    codec_registry_init();
+    g_mutex_lock(&codecs_lock);
+    for (guint i = 0; i < codecs->len; i++) {
+        const CodecDescriptor *codec = g_ptr_array_index(codecs, i);
+        gchar *caps = gst_caps_to_string(codec->rtp_caps);
+
+        g_print("  %-16s PT %-3u %s%s\n", codec->name, codec->pt, caps, codec->available ? "" : "  (요소 없음)");
+        g_free(caps);
+    }
+    g_mutex_unlock(&codecs_lock);
+}
+
+const gchar *codec_get_name(const CodecDescriptor *codec) { return codec->name; }
+const gchar *codec_get_label(const CodecDescriptor *codec) { return codec->label; }
+gboolean codec_has_encoded_input(const CodecDescriptor *codec) { return codec->encoded_input; }
+GstCaps *codec_get_input_caps(const CodecDescriptor *codec) { return codec->input_caps; }
+guint codec_get_frame_samples(const CodecDescriptor *codec) { return codec->frame_samples; }
+const gchar *codec_get_container(const CodecDescriptor *codec) { return codec->container; }
+
+// 📌 코덱 요소 [begin, end)를 bin에 만들어 넣고 연결한다 (first/last: 체인 양 끝)
+static gboolean add_codec_elements(const CodecDescriptor *codec, GstBin *bin, guint begin, guint end,
+                                   GstElement **first, GstElement **last) {
+    GstElement *elements[CODEC_MAX_ELEMENTS] = { NULL };
+
+    for (guint i = begin; i < end; i++) {
+        elements[i] = gst_element_factory_create(codec->factories[i], NULL);
+        if (!elements[i]) {
+            g_printerr("[CODEC] %s 생성 실패\n", codec->elements[i]);
+            for (guint j = begin; j < i; j++) gst_object_unref(elements[j]);
+            return FALSE;
+        }
+    }
+
+    if (end == codec->n_elements) g_object_set(elements[end - 1], "pt", codec->pt, NULL);
+    if (codec->setup) codec->setup(codec, elements);
+    for (guint i = begin; i < end; i++) latency_profile_tune_element(elements[i]); // 저지연 프로필일 때만
+    for (guint i = begin; i < end; i++) rtcp_feedback_track_encoder(elements[i]);  // RTCP 조정 중일 때만 (opusenc)
+
+    for (guint i = begin; i < end; i++) gst_bin_add(bin, elements[i]);
+    for (guint i = begin + 1; i < end; i++) {
+        if (!gst_element_link(elements[i - 1], elements[i])) {
+            g_printerr("[CODEC] %s 요소 연결 실패 (%s → %s)\n", codec->label,
+                       codec->elements[i - 1], codec->elements[i]);
+            return FALSE;
+        }
+    }
+
+    *first = elements[begin];
+    *last = elements[end - 1];
+    return TRUE;
+}
+
+// 📌 요소 [begin, end)를 ghost pad "sink"/"src"가 있는 bin으로
+static GstElement *make_range_bin(const CodecDescriptor *codec, guint begin, guint end) {
+    GstElement *segment = gst_bin_new(NULL);
+    GstElement *first, *last;
+    GstPad *pad;
+
+    if (!add_codec_elements(codec, GST_BIN(segment), begin, end, &first, &last)) {
+        gst_object_unref(segment);
+        return NULL;
+    }
+
+    pad = gst_element_get_static_pad(first, "sink");
+    gst_element_add_pad(segment, gst_ghost_pad_new("sink", pad));
+    gst_object_unref(pad);
+    pad = gst_element_get_static_pad(last, "src");
+    gst_element_add_pad(segment, gst_ghost_pad_new("src", pad));
+    gst_object_unref(pad);
+    return segment;
+}
+
+// 📌 코덱 요소만 담은 bin (ghost pad "sink"/"src"). 앞뒤 요소는 호출하는 쪽이 유지
+GstElement *codec_registry_make_segment(const CodecDescriptor *codec) {
+    return make_range_bin(codec, 0, codec->n_elements);
+}
+
+// 📌 payloader를 뺀 인코딩 부분만 (encoder [! parse]). 인코딩 단계가 없는 코덱(raw)은 NULL
+GstElement *codec_registry_make_encoder(const CodecDescriptor *codec) {
+    if (codec->n_elements < 2 || codec->encoded_input) return NULL;
+    return make_range_bin(codec, 0, codec->n_elements - 1);
+}
+
+// 📌 payloader 하나 (pt 설정됨). 인코딩된 프레임을 나중에 RTP로 만들 때
+GstElement *codec_registry_make_payloader(const CodecDescriptor *codec) {
+    GstElement *pay = gst_element_factory_create(codec->factories[codec->n_elements - 1], NULL);
+
+    if (pay) g_object_set(pay, "pt", codec->pt, NULL);
+    return pay;
+}
+
+// 📌 appsrc 뒤에 붙는 송출 bin 전체: [audioconvert ! audioresample !] 코덱 요소 ! egress sink
+// 단계 경계(변환 → 인코딩 → 송출)의 queue는 스레드 구성 프로필에 따라 들어간다
+GstElement *codec_registry_make_bin(const CodecDescriptor *codec, GstElement **out_sink) {
+    GstElement *bin = gst_bin_new(NULL);
+    GstElement *convert = NULL, *resample = NULL, *first, *last, *entry, *sink;
+    GstPad *pad;
+
+    sink = egress_make_sink(CODEC_UDP_PORT); // udpsink 또는 배치 송출 appsink
+    if (!sink || !add_codec_elements(codec, GST_BIN(bin), 0, codec->n_elements, &first, &last)) {
+        g_printerr("[CODEC] %s pipeline 요소 생성 실패\n", codec->label);
+        if (sink) gst_object_unref(sink);
+        gst_object_unref(bin);
+        return NULL;
+    }
+    g_object_set(sink, "sync", FALSE, "async", FALSE, NULL);
+    gst_bin_add(GST_BIN(bin), sink);
+    entry = first;
+
+    if (!codec->encoded_input) {
+        convert = codec_registry_make_element("audioconvert");
+        resample = codec_registry_make_element("audioresample");
+        if (!convert || !resample) {
+            g_printerr("[CODEC] audioconvert/audioresample 생성 실패\n");
+            if (convert) gst_object_unref(convert);
+            if (resample) gst_object_unref(resample);
+            gst_object_unref(bin);
+            return NULL;
+        }
+        gst_bin_add_many(GST_BIN(bin), convert, resample, NULL);
+        if (!gst_element_link(convert, resample) ||
+            !thread_topology_link(GST_BIN(bin), resample, first, STAGE_ENCODE)) {
+            g_printerr("[CODEC] %s 변환 요소 연결 실패\n", codec->label);
+            gst_object_unref(bin);
+            return NULL;
+        }
+        entry = convert;
+    }
+
+    if (!thread_topology_link(GST_BIN(bin), last, sink, STAGE_SEND)) {
+        g_printerr("[CODEC] %s 송출 연결 실패\n", codec->label);
+        gst_object_unref(bin);
+        return NULL;
+    }
+
+    // ghost pad (입력 경계 queue가 있으면 그 queue가 입구)
+    pad = gst_element_get_static_pad(thread_topology_entry(GST_BIN(bin), entry), "sink");
+    gst_element_add_pad(bin, gst_ghost_pad_new("sink", pad));
+    gst_object_unref(pad);
+
+    if (out_sink) *out_sink = sink;
+    return bin;
+}
@@ -0,0 +1,478 @@
+// egress.c
+/*
+ * RTP 송출 sink 공용 모듈
+ *
+ *  EGRESS_UDPSINK : multiudpsink (render 한 번의 패킷 × 목적지를 g_socket_send_messages 한 번으로)
+ *  EGRESS_BATCHED : appsink로 받은 패킷을 모든 세션이 공유하는 송출 스레드에 모아서
+ *                   sendmmsg 한 번으로 보낸다. 목적지와 크기가 같은 연속 패킷은
+ *                   커널이 지원하면 UDP GSO(UDP_SEGMENT)로 한 메시지에 묶는다.
+ *
+ * fan-out: sink 하나가 목적지 N개로 보낸다 (인코딩/페이로드는 한 번).
+ *   목적지 변경은 sink 속성/목록만 바꾸므로 bin 재구성이나 인코더 정지가 없다.
+ *   배치 모드에서는 같은 GstBuffer를 목적지마다 ref만 늘려 큐에 넣는다 (복사 없음).
+ *
+ * 배치는 max_batch개가 모이거나, 가장 오래된 패킷이 latency budget만큼 기다리면 바로 나간다.
+ * 즉 배치 때문에 늘어나는 지연은 최대 budget이다.
+ *
+ * 사용:
+ *   egress_configure(EGRESS_BATCHED, 64, 1000);  // sink 만들기 전에 한 번
+ *   GstElement *sink = egress_make_sink(5000);
+ *   egress_set_clients(sink, "127.0.0.1:5000,10.0.0.7:5000");  // 실행 중 변경 가능
+ *   egress_report();                             // pps / 시스템콜당 패킷 / CPU (udpsink는 추정치)
+ */
+#define _GNU_SOURCE // sendmmsg
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// ../common/codec_registry.c (factory는 등록부가 미리 찾아 둔다)
+GstElement *codec_registry_make_element(const gchar *factory_name);
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+#define EGRESS_HOST "127.0.0.1"
+#define EGRESS_DEST_KEY "egress-dest"
+#define EGRESS_NDEST_KEY "egress-ndest"
+#define EGRESS_PORT_KEY "egress-port"     // 첫 목적지 포트 (egress_get_port, 목적지를 바꿀 때 갱신)
+#define EGRESS_MAX_BATCH 256
+#define GSO_MAX_SEGMENTS 64
+#define GSO_MAX_BYTES 65000
+
+typedef enum {
+    EGRESS_UDPSINK,
+    EGRESS_BATCHED
+} EgressMode;
+
+typedef struct {
+    GstBuffer *buffer;          // RTP 패킷 (ref 보유, 보낸 뒤 해제)
+    struct sockaddr_in dest;
+} EgressPacket;
+
+// 배치 모드 sink의 목적지 목록 (스트리밍 스레드와 main loop가 같이 접근)
+typedef struct {
+    GMutex lock;
+    GArray *addrs;              // struct sockaddr_in
+} EgressDests;
+
+static EgressMode egress_mode = EGRESS_UDPSINK;
+static guint max_batch = 64;
+static gint64 latency_budget_us = 1000;
+
+// 송출 스레드 (EGRESS_BATCHED, 모든 세션 공유)
+static struct {
+    GMutex lock;
+    GCond cond;
+    GCond space_cond;   // 송출 스레드가 큐를 비웠다 (backpressure 대기용)
+    GThread *thread;
+    gboolean running;
+    EgressPacket *queue;
+    guint len;
+    gint64 oldest_us;   // 큐에서 가장 오래된 패킷이 들어온 시각
+    int fd;
+    gboolean gso;
+} batcher;
+
+// 통계 (두 모드 공통)
+static volatile gsize stat_packets;
+static volatile gsize stat_syscalls;
+static volatile gsize stat_gso_messages;
+static volatile gsize stat_errors;
+
+// 📌 같은 목적지/같은 크기 연속 패킷을 GSO 한 메시지로 묶을 수 있는 개수
+static guint gso_run_length(EgressPacket *packets, struct iovec *iovs, guint start, guint n) {
+    guint run = 1;
+    gsize total = iovs[start].iov_len;
+
+    while (start + run < n && run < GSO_MAX_SEGMENTS &&
+           iovs[start + run].iov_len == iovs[start].iov_len &&
+           total + iovs[start + run].iov_len <= GSO_MAX_BYTES &&
+           packets[start + run].dest.sin_port == packets[start].dest.sin_port &&
+           packets[start + run].dest.sin_addr.s_addr == packets[start].dest.sin_addr.s_addr) {
+        total += iovs[start + run].iov_len;
+        run++;
+    }
+    return run;
+}
+
+typedef union {
+    char buf[CMSG_SPACE(sizeof(guint16))];
+    struct cmsghdr align;
+} GsoControl;
+
+// 📌 packets[start..n)을 sendmmsg 메시지로 구성. first[k]는 메시지 k의 첫 패킷 번호
+static guint build_messages(EgressPacket *packets, struct iovec *iovs, guint start, guint n,
+                            struct mmsghdr *msgs, GsoControl *controls, guint *first) {
+    guint nmsg = 0;
+
+    for (guint i = start; i < n;) {
+        guint run = batcher.gso ? gso_run_length(packets, iovs, i, n) : 1;
+        struct msghdr *hdr = &msgs[nmsg].msg_hdr;
+
+        memset(&msgs[nmsg], 0, sizeof(msgs[nmsg]));
+        hdr->msg_name = &packets[i].dest;
+        hdr->msg_namelen = sizeof(packets[i].dest);
+        hdr->msg_iov = &iovs[i];
+        hdr->msg_iovlen = run;
+
+        if (run > 1) {
+            struct cmsghdr *cm;
+
+            hdr->msg_control = controls[nmsg].buf;
+            hdr->msg_controllen = sizeof(controls[nmsg].buf);
+            cm = CMSG_FIRSTHDR(hdr);
+            cm->cmsg_level = SOL_UDP;
+            cm->cmsg_type = UDP_SEGMENT;
+            cm->cmsg_len = CMSG_LEN(sizeof(guint16));
+            *(guint16 *)CMSG_DATA(cm) = (guint16)iovs[i].iov_len;
+            g_atomic_pointer_add(&stat_gso_messages, 1);
+        }
+        first[nmsg] = i;
+        nmsg++;
+        i += run;
+    }
+    return nmsg;
+}
+
+// 📌 한 배치 전송: 메시지 구성 → sendmmsg (부분 전송이면 나머지 다시)
+static void send_batch(EgressPacket *packets, guint n) {
+    struct mmsghdr msgs[EGRESS_MAX_BATCH];
+    struct iovec iovs[EGRESS_MAX_BATCH];
+    GstMapInfo maps[EGRESS_MAX_BATCH];
+    GsoControl controls[EGRESS_MAX_BATCH];
+    guint first[EGRESS_MAX_BATCH];
+    guint nmsg, sent = 0;
+
+    for (guint i = 0; i < n; i++) {
+        gst_buffer_map(packets[i].buffer, &maps[i], GST_MAP_READ);
+        iovs[i].iov_base = maps[i].data;
+        iovs[i].iov_len = maps[i].size;
+    }
+    nmsg = build_messages(packets, iovs, 0, n, msgs, controls, first);
+
+    while (sent < nmsg) {
+        int r = sendmmsg(batcher.fd, msgs + sent, nmsg - sent, 0);
+
+        g_atomic_pointer_add(&stat_syscalls, 1);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            if (batcher.gso && (errno == EIO || errno == EINVAL)) {
+                // 장치/커널이 GSO를 못 하면 끄고, 아직 못 보낸 패킷은 GSO 없이 다시 구성해서 보낸다
+                g_printerr("[EGRESS] UDP GSO 사용 불가 (%s), sendmmsg만 사용\n", g_strerror(errno));
+                batcher.gso = FALSE;
+                nmsg = build_messages(packets, iovs, first[sent], n, msgs, controls, first);
+                sent = 0;
+                continue;
+            }
+            g_atomic_pointer_add(&stat_errors, nmsg - sent);
+            break;
+        }
+        sent += r;
+    }
+
+    for (guint i = 0; i < n; i++) {
+        gst_buffer_unmap(packets[i].buffer, &maps[i]);
+        gst_buffer_unref(packets[i].buffer);
+    }
+    g_atomic_pointer_add(&stat_packets, n);
+}
+
+// 📌 송출 스레드: max_batch개가 모이거나 가장 오래된 패킷이 budget을 넘기면 보낸다
+static gpointer batcher_thread(gpointer data) {
+    EgressPacket *local = g_new(EgressPacket, EGRESS_MAX_BATCH);
+
+    g_mutex_lock(&batcher.lock);
+    while (batcher.running || batcher.len > 0) {
+        guint n;
+
+        if (batcher.len == 0) {
+            g_cond_wait(&batcher.cond, &batcher.lock);
+            continue;
+        }
+        if (batcher.running && batcher.len < max_batch &&
+            g_get_monotonic_time() < batcher.oldest_us + latency_budget_us) {
+            g_cond_wait_until(&batcher.cond, &batcher.lock, batcher.oldest_us + latency_budget_us);
+            continue;
+        }
+
+        // 큐를 통째로 가져오고 락 밖에서 전송
+        n = batcher.len;
+        memcpy(local, batcher.queue, n * sizeof(EgressPacket));
+        batcher.len = 0;
+        g_cond_broadcast(&batcher.space_cond);
+        g_mutex_unlock(&batcher.lock);
+
+        send_batch(local, n);
+
+        g_mutex_lock(&batcher.lock);
+    }
+    g_mutex_unlock(&batcher.lock);
+
+    g_free(local);
+    return NULL;
+}
+
+static gpointer batcher_start(gpointer data) {
+    int probe;
+    socklen_t probe_len = sizeof(probe);
+
+    batcher.fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (batcher.fd < 0) {
+        g_printerr("[EGRESS] 소켓 생성 실패: %s\n", g_strerror(errno));
+        return NULL;
+    }
+    // getsockopt가 되면 커널이 UDP_SEGMENT를 안다 (4.18+)
+    batcher.gso = getsockopt(batcher.fd, SOL_UDP, UDP_SEGMENT, &probe, &probe_len) == 0;
+
+    batcher.queue = g_new(EgressPacket, EGRESS_MAX_BATCH);
+    batcher.running = TRUE;
+    batcher.thread = g_thread_new("egress-batcher", batcher_thread, NULL);
+    g_print("[EGRESS] 배치 송출 시작 (최대 %u개, budget %" G_GINT64_FORMAT " us, GSO %s)\n",
+            max_batch, latency_budget_us, batcher.gso ? "사용" : "미지원");
+    return NULL;
+}
+
+// 📌 appsink 콜백 (각 세션 스트리밍 스레드): 패킷을 큐에 넣기만 한다
+static GstFlowReturn on_new_sample(GstAppSink *sink, gpointer user_data) {
+    GstSample *sample = gst_app_sink_pull_sample(sink);
+    EgressDests *dests = g_object_get_data(G_OBJECT(sink), EGRESS_DEST_KEY);
+    GstBuffer *buffer;
+
+    if (!sample) return GST_FLOW_EOS;
+    buffer = gst_buffer_ref(gst_sample_get_buffer(sample));
+    gst_sample_unref(sample);
+
+    g_mutex_lock(&dests->lock);
+    g_mutex_lock(&batcher.lock);
+    if (!batcher.running) {
+        // 송출 스레드가 없음 (소켓 실패 또는 종료 후)
+        g_mutex_unlock(&batcher.lock);
+        g_mutex_unlock(&dests->lock);
+        gst_buffer_unref(buffer);
+        g_atomic_pointer_add(&stat_errors, 1);
+        return GST_FLOW_OK;
+    }
+
+    // 목적지마다 같은 버퍼를 한 번씩 (ref만 증가)
+    for (guint i = 0; i < dests->addrs->len; i++) {
+        // 큐가 가득 차면 송출 스레드가 비울 때까지 기다린다 (backpressure)
+        while (batcher.len >= EGRESS_MAX_BATCH && batcher.running) {
+            g_cond_signal(&batcher.cond);
+            g_cond_wait(&batcher.space_cond, &batcher.lock);
+        }
+        if (!batcher.running) break;
+
+        if (batcher.len == 0) batcher.oldest_us = g_get_monotonic_time();
+        batcher.queue[batcher.len].buffer = gst_buffer_ref(buffer);
+        batcher.queue[batcher.len].dest = g_array_index(dests->addrs, struct sockaddr_in, i);
+        batcher.len++;
+        if (batcher.len == 1 || batcher.len >= max_batch) g_cond_signal(&batcher.cond);
+    }
+    g_mutex_unlock(&batcher.lock);
+    g_mutex_unlock(&dests->lock);
+
+    gst_buffer_unref(buffer);
+    return GST_FLOW_OK;
+}
+
+// 📌 udpsink 모드 통계용 probe (패킷 하나가 목적지 수만큼 나간다)
+// 📌 udpsink 모드 통계 (sink pad probe)
+// multiudpsink는 render 한 번(버퍼 하나 또는 버퍼 리스트)의 패킷 × 목적지를 g_socket_send_messages()
+// 한 번(Linux에서는 sendmmsg)으로 보낸다. 부분 전송 재시도는 여기서 보이지 않으므로
+// 시스템콜 수는 render 호출 수로 잡은 추정치 (배치 모드는 실제 호출 수)
+static GstPadProbeReturn on_udpsink_buffer(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    GstElement *sink = GST_PAD_PARENT(pad);
+    guint ndest = GPOINTER_TO_UINT(g_object_get_data(G_OBJECT(sink), EGRESS_NDEST_KEY));
+    guint n = (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) ?
+        gst_buffer_list_length(GST_PAD_PROBE_INFO_BUFFER_LIST(info)) : 1;
+
+    g_atomic_pointer_add(&stat_packets, n * ndest);
+    if (ndest) g_atomic_pointer_add(&stat_syscalls, 1);
+    return GST_PAD_PROBE_OK;
+}
+
+static void egress_dests_free(gpointer data) {
+    EgressDests *dests = data;
+
+    g_array_unref(dests->addrs);
+    g_mutex_clear(&dests->lock);
+    g_free(dests);
+}
+
+// 📌 "host:port" 하나를 주소로 (IPv4, 호스트 이름 가능)
+static gboolean parse_destination(const gchar *spec, struct sockaddr_in *addr) {
+    const gchar *colon = strrchr(spec, ':');
+    struct addrinfo hints = { 0 }, *result = NULL;
+    gchar *host;
+    guint64 port;
+    gboolean ok;
+
+    if (!colon || !g_ascii_string_to_unsigned(colon + 1, 10, 1, 65535, &port, NULL)) return FALSE;
+
+    host = g_strndup(spec, colon - spec);
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    ok = getaddrinfo(host, NULL, &hints, &result) == 0;
+    if (ok) {
+        *addr = *(struct sockaddr_in *)result->ai_addr;
+        addr->sin_port = htons((guint16)port);
+        freeaddrinfo(result);
+    }
+    g_free(host);
+    return ok;
+}
+
+// 📌 송출 모드 설정 (sink를 만들기 전에 호출)
+void egress_configure(EgressMode mode, guint batch, guint budget_us) {
+    egress_mode = mode;
+    max_batch = CLAMP(batch, 1, EGRESS_MAX_BATCH);
+    latency_budget_us = budget_us;
+}
+
+// 📌 목적지 목록 교체 ("host:port,host:port", 빈 문자열이면 목적지 없음). 실행 중 호출 가능
+void egress_set_clients(GstElement *sink, const gchar *clients) {
+    EgressDests *dests = g_object_get_data(G_OBJECT(sink), EGRESS_DEST_KEY);
+    gchar **specs = g_strsplit(clients ? clients : "", ",", -1);
+    guint ndest = 0, first_port = 0;
+
+    if (dests) {
+        GArray *addrs = g_array_new(FALSE, FALSE, sizeof(struct sockaddr_in));
+
+        for (guint i = 0; specs[i]; i++) {
+            struct sockaddr_in addr;
+            if (!*specs[i]) continue;
+            if (parse_destination(g_strstrip(specs[i]), &addr)) g_array_append_val(addrs, addr);
+            else g_printerr("[EGRESS] 잘못된 목적지: %s\n", specs[i]);
+        }
+        if (addrs->len > 0) first_port = ntohs(g_array_index(addrs, struct sockaddr_in, 0).sin_port);
+        g_mutex_lock(&dests->lock);
+        g_array_unref(dests->addrs);
+        dests->addrs = addrs;
+        g_mutex_unlock(&dests->lock);
+    } else {
+        // multiudpsink: clients 속성 교체는 내부 락 아래에서 한 번에 적용된다
+        for (guint i = 0; specs[i]; i++) {
+            if (!*specs[i]) continue;
+            if (ndest++ == 0 && strrchr(specs[i], ':'))
+                first_port = (guint)g_ascii_strtoull(strrchr(specs[i], ':') + 1, NULL, 10);
+        }
+        g_object_set(sink, "clients", clients ? clients : "", NULL);
+        g_object_set_data(G_OBJECT(sink), EGRESS_NDEST_KEY, GUINT_TO_POINTER(ndest));
+    }
+    g_object_set_data(G_OBJECT(sink), EGRESS_PORT_KEY, GUINT_TO_POINTER(first_port));
+    g_strfreev(specs);
+}
+
+// 📌 목적지를 EGRESS_HOST:port 하나로
+void egress_set_port(GstElement *sink, guint port) {
+    gchar *clients = g_strdup_printf("%s:%u", EGRESS_HOST, port);
+
+    egress_set_clients(sink, clients);
+    g_free(clients);
+}
+
+// 📌 첫 목적지 포트 (목적지가 없으면 0). 패킷 캡처가 버퍼마다 읽으므로 egress_set_clients가 미리 계산해 둔 값
+guint egress_get_port(GstElement *sink) {
+    return GPOINTER_TO_UINT(g_object_get_data(G_OBJECT(sink), EGRESS_PORT_KEY));
+}
+
+// 📌 RTP 송출 sink 생성, 목적지는 EGRESS_HOST:port 하나 (sync/async 등 basesink 속성은 호출자가 설정)
+GstElement *egress_make_sink(guint port) {
+    static GOnce batcher_once = G_ONCE_INIT;
+    gchar *clients = g_strdup_printf("%s:%u", EGRESS_HOST, port);
+    GstElement *sink;
+    GstPad *pad;
+
+    if (egress_mode == EGRESS_UDPSINK) {
+        sink = codec_registry_make_element("multiudpsink");
+        if (sink) {
+            egress_set_clients(sink, clients);
+            pad = gst_element_get_static_pad(sink, "sink");
+            gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+                              on_udpsink_buffer, NULL, NULL);
+            gst_object_unref(pad);
+        }
+        g_free(clients);
+        return sink;
+    }
+
+    g_once(&batcher_once, batcher_start, NULL);
+
+    sink = codec_registry_make_element("appsink");
+    if (sink) {
+        EgressDests *dests = g_new0(EgressDests, 1);
+        GstAppSinkCallbacks callbacks = { NULL, NULL, on_new_sample };
+
+        g_mutex_init(&dests->lock);
+        dests->addrs = g_array_new(FALSE, FALSE, sizeof(struct sockaddr_in));
+        g_object_set_data_full(G_OBJECT(sink), EGRESS_DEST_KEY, dests, egress_dests_free);
+        egress_set_clients(sink, clients);
+
+        gst_app_sink_set_callbacks(GST_APP_SINK(sink), &callbacks, NULL, NULL);
+        g_object_set(sink, "emit-signals", FALSE, "max-buffers", 1, NULL);
+    }
+    g_free(clients);
+    return sink;
+}
+
+// 📌 지난 보고 이후 pps, 시스템콜당 패킷 수, 프로세스 CPU 사용률
+void egress_report(void) {
+    static gint64 last_us = 0;
+    static guint64 last_packets = 0, last_syscalls = 0;
+    static gdouble last_cpu_s = 0.0;
+    struct rusage usage;
+    gint64 now = g_get_monotonic_time();
+    guint64 packets = g_atomic_pointer_get(&stat_packets);
+    guint64 syscalls = g_atomic_pointer_get(&stat_syscalls);
+    gdouble cpu_s, elapsed_s;
+
+    getrusage(RUSAGE_SELF, &usage);
+    cpu_s = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+            (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+
+    if (last_us) {
+        elapsed_s = (now - last_us) / 1e6;
+        g_print("[EGRESS] %s: %.0f pps, 시스템콜당 %.1f 패킷%s, CPU %.1f%%, GSO 메시지 %" G_GSIZE_FORMAT
+                ", 실패 %" G_GSIZE_FORMAT "\n",
+                egress_mode == EGRESS_BATCHED ? "batched" : "udpsink",
+                (packets - last_packets) / elapsed_s,
+                syscalls > last_syscalls ? (gdouble)(packets - last_packets) / (syscalls - last_syscalls) : 0.0,
+                egress_mode == EGRESS_BATCHED ? "" : " (추정: render당 sendmmsg 1회)",
+                (cpu_s - last_cpu_s) * 100.0 / elapsed_s,
+                (gsize)g_atomic_pointer_get(&stat_gso_messages), (gsize)g_atomic_pointer_get(&stat_errors));
+    }
+    last_us = now;
+    last_packets = packets;
+    last_syscalls = syscalls;
+    last_cpu_s = cpu_s;
+}
+
+void egress_get_stats(guint64 *packets, guint64 *syscalls) {
+    if (packets) *packets = g_atomic_pointer_get(&stat_packets);
+    if (syscalls) *syscalls = g_atomic_pointer_get(&stat_syscalls);
+}
+
+// 📌 남은 패킷을 모두 보내고 송출 스레드 종료
+void egress_shutdown(void) {
+    if (!batcher.thread) return;
+
+    g_mutex_lock(&batcher.lock);
+    batcher.running = FALSE;
+    g_cond_signal(&batcher.cond);
+    g_cond_broadcast(&batcher.space_cond);
+    g_mutex_unlock(&batcher.lock);
+
+    g_thread_join(batcher.thread);
+    batcher.thread = NULL;
+    close(batcher.fd);
+    g_free(batcher.queue);
+}
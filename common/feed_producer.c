@@ -0,0 +1,276 @@
+// feed_producer.c
+/*
+ * appsrc 생산자 스레드 (유한 lock-free ring + need-data/enough-data backpressure)
+ *
+ *  생성 스레드 ──▶ [ring: 최대 ring_slots개] ──▶ appsrc push
+ *                                              ▲ need-data: 요청 크기 기록 + ring에 있는 만큼 즉시 push
+ *                                              ▲ enough-data: push 중지 (appsrc max-bytes 도달)
+ *
+ *  - 생성은 전용 스레드에서만 한다. main loop는 어떤 경우에도 기다리지 않는다.
+ *  - appsrc는 block=FALSE로 쓰고, max-bytes를 넘으면 오는 enough-data로 멈춘다.
+ *    다음 need-data까지 생성분은 ring에만 쌓이므로 메모리는 ring_slots * max_chunk + max-bytes로 묶인다.
+ *  - 버퍼 하나의 크기: need-data가 요청한 바이트 수를 [max_chunk/4, max_chunk]로 자르고,
+ *    latency_us 분량을 넘지 않게 fill 함수가 프레임 단위로 맞춘다 (저지연 프로필은 2.5~10 ms).
+ *  - realtime=TRUE (live 입력): 생성은 실시간 속도. ring이 차 있으면 새 chunk를 버리고 센다 (지연을 쌓지 않음).
+ *    realtime=FALSE (파일/배치): ring에 자리가 날 때까지 생성 스레드가 기다린다.
+ *
+ * ring은 생성 스레드 하나가 쓰고, 읽는 쪽은 need-data를 받은 스트리밍 스레드나 생성 스레드 중
+ * consuming 플래그를 먼저 잡은 하나만 읽는다 (기다리지 않고 못 잡으면 건너뜀).
+ *
+ * 사용:
+ *   FeedProducerConfig config = { .ring_slots = 8, .latency_us = 20000, .max_chunk = 3840, .realtime = TRUE };
+ *   FeedProducer *fp = feed_producer_start(appsrc, &config, fill, NULL);
+ *   feed_producer_report(fp);
+ *   feed_producer_stop(fp);
+ */
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+
+#include "feed_producer.h"
+
+// ../common/producer_pool.c
+typedef struct _ProducerPool ProducerPool;
+ProducerPool *producer_pool_new(guint buffer_size, guint max_buffers);
+GstBuffer *producer_pool_acquire(ProducerPool *pp);
+void producer_pool_free(ProducerPool *pp);
+
+struct _FeedProducer {
+    GstElement *appsrc;
+    FeedProducerConfig config;
+    FeedFillFunc fill;
+    gpointer user_data;
+    ProducerPool *pool;
+    gulong need_id, enough_id;
+
+    // ring (쓰는 쪽: 생성 스레드, 읽는 쪽: consuming을 잡은 스레드)
+    GstBuffer *slots[FEED_RING_MAX_SLOTS];
+    volatile guint head, tail;
+    volatile gint consuming;
+
+    volatile gint wanted;       // need-data ~ enough-data 사이
+    volatile guint requested;   // 마지막 need-data 요청 바이트
+
+    GThread *thread;
+    GMutex lock;                // cond 대기용 (ring 접근에는 쓰지 않음)
+    GCond cond;
+    gboolean running;
+
+    volatile gsize pushed, pushed_bytes, dropped, underruns, enough;
+    volatile guint ring_peak;
+};
+
+static guint ring_fill(FeedProducer *fp) {
+    return g_atomic_int_get(&fp->tail) - g_atomic_int_get(&fp->head);
+}
+
+static void wake_producer(FeedProducer *fp) {
+    g_mutex_lock(&fp->lock);
+    g_cond_signal(&fp->cond);
+    g_mutex_unlock(&fp->lock);
+}
+
+// 📌 ring → appsrc (wanted인 동안). 다른 스레드가 이미 비우는 중이면 바로 돌아간다
+static void drain_ring(FeedProducer *fp, gboolean from_need_data) {
+    guint popped = 0;
+
+    if (!g_atomic_int_compare_and_exchange(&fp->consuming, 0, 1)) return;
+
+    if (from_need_data && ring_fill(fp) == 0) g_atomic_pointer_add(&fp->underruns, 1);
+
+    while (g_atomic_int_get(&fp->wanted)) {
+        guint head = fp->head;
+        GstBuffer *buffer;
+
+        if (head == g_atomic_int_get(&fp->tail)) break;
+        buffer = fp->slots[head % fp->config.ring_slots];
+        g_atomic_int_set(&fp->head, head + 1);
+        popped++;
+
+        g_atomic_pointer_add(&fp->pushed_bytes, gst_buffer_get_size(buffer));
+        // block=FALSE: 기다리지 않음. max-bytes를 넘으면 이 안에서 enough-data가 와서 wanted가 꺼진다
+        if (gst_app_src_push_buffer(GST_APP_SRC(fp->appsrc), buffer) != GST_FLOW_OK) {
+            g_atomic_int_set(&fp->wanted, 0); // flushing/EOS: 다음 need-data까지 멈춤
+            break;
+        }
+        g_atomic_pointer_add(&fp->pushed, 1);
+    }
+
+    g_atomic_int_set(&fp->consuming, 0);
+    if (popped > 0 && !fp->config.realtime) wake_producer(fp); // 자리가 났음
+}
+
+// 📌 appsrc 스트리밍 스레드: 요청 크기 기록 후 ring에 있는 만큼 바로 push
+static void on_need_data(GstElement *appsrc, guint size, gpointer user_data) {
+    FeedProducer *fp = user_data;
+
+    g_atomic_int_set(&fp->requested, size);
+    g_atomic_int_set(&fp->wanted, 1);
+    drain_ring(fp, TRUE);
+}
+
+static void on_enough_data(GstElement *appsrc, gpointer user_data) {
+    FeedProducer *fp = user_data;
+
+    g_atomic_int_set(&fp->wanted, 0);
+    g_atomic_pointer_add(&fp->enough, 1);
+}
+
+// 📌 다음 chunk 하나 생성 (요청 크기와 지연 목표로 크기 결정)
+static GstBuffer *produce_chunk(FeedProducer *fp, GstClockTime *media_time) {
+    gsize max_chunk = fp->config.max_chunk;
+    gsize requested = g_atomic_int_get(&fp->requested);
+    gsize max_size = requested ? CLAMP(requested, max_chunk / 4, max_chunk) : max_chunk;
+    GstClockTime duration = 0;
+    GstBuffer *buffer = producer_pool_acquire(fp->pool);
+    GstMapInfo map;
+    gsize size;
+
+    gst_buffer_map(buffer, &map, GST_MAP_WRITE);
+    size = fp->fill(map.data, max_size, fp->config.latency_us * GST_USECOND, &duration, fp->user_data);
+    gst_buffer_unmap(buffer, &map);
+
+    if (size == 0) {
+        gst_buffer_unref(buffer);
+        return NULL;
+    }
+    if (size < max_chunk) gst_buffer_set_size(buffer, size);
+    // do-timestamp appsrc면 PTS는 push 시각으로 다시 정해진다 (media_time은 생성 속도 조절용)
+    GST_BUFFER_PTS(buffer) = *media_time;
+    GST_BUFFER_DURATION(buffer) = duration;
+    *media_time += duration;
+    return buffer;
+}
+
+static gpointer producer_thread_func(gpointer data) {
+    FeedProducer *fp = data;
+    GstClockTime media_time = 0;
+    gint64 start_us = g_get_monotonic_time();
+
+    g_mutex_lock(&fp->lock);
+    while (fp->running) {
+        GstBuffer *buffer;
+        guint fill;
+
+        g_mutex_unlock(&fp->lock);
+
+        fill = ring_fill(fp);
+        if (fill >= fp->config.ring_slots && !fp->config.realtime) {
+            // 배치 모드: 자리가 날 때까지 기다린다 (need-data가 비우면 깨움)
+            drain_ring(fp, FALSE);
+            g_mutex_lock(&fp->lock);
+            if (fp->running && ring_fill(fp) >= fp->config.ring_slots)
+                g_cond_wait_until(&fp->cond, &fp->lock, g_get_monotonic_time() + 10 * G_TIME_SPAN_MILLISECOND);
+            continue;
+        }
+
+        buffer = produce_chunk(fp, &media_time);
+        if (buffer) {
+            if (ring_fill(fp) >= fp->config.ring_slots) {
+                // 실시간 모드: downstream이 밀려 있으면 새 chunk를 버린다 (메모리/지연 상한 유지)
+                gst_buffer_unref(buffer);
+                g_atomic_pointer_add(&fp->dropped, 1);
+            } else {
+                guint tail = fp->tail;
+                fp->slots[tail % fp->config.ring_slots] = buffer;
+                g_atomic_int_set(&fp->tail, tail + 1);
+                fill = ring_fill(fp);
+                if (fill > g_atomic_int_get(&fp->ring_peak)) g_atomic_int_set(&fp->ring_peak, fill);
+            }
+        }
+        drain_ring(fp, FALSE); // need-data가 ring이 빈 상태에서 왔다면 여기서 보낸다
+
+        g_mutex_lock(&fp->lock);
+        if (fp->running && fp->config.realtime) {
+            // 생성한 미디어 시간만큼 실제 시간이 흐를 때까지 (절대 시각 기준, 오차 누적 없음)
+            gint64 due_us = start_us + (gint64)(media_time / GST_USECOND);
+            if (!buffer) due_us = g_get_monotonic_time() + fp->config.latency_us;
+            while (fp->running && g_cond_wait_until(&fp->cond, &fp->lock, due_us))
+                ;
+        }
+    }
+    g_mutex_unlock(&fp->lock);
+    return NULL;
+}
+
+// 📌 appsrc에 생산자를 붙이고 생성 스레드 시작 (appsrc는 block=FALSE, max-bytes 설정됨)
+FeedProducer *feed_producer_start(GstElement *appsrc, const FeedProducerConfig *config,
+                                  FeedFillFunc fill, gpointer user_data) {
+    FeedProducer *fp = g_new0(FeedProducer, 1);
+
+    fp->config = *config;
+    fp->config.ring_slots = CLAMP(config->ring_slots, 2, FEED_RING_MAX_SLOTS);
+    fp->config.latency_us = MAX(config->latency_us, 250);
+    if (!fp->config.max_bytes) fp->config.max_bytes = config->max_chunk * 2;
+
+    // 풀: ring + appsrc 대기분 + downstream에서 쓰는 중인 것 몇 개
+    fp->pool = producer_pool_new(config->max_chunk,
+                                 fp->config.ring_slots + fp->config.max_bytes / MAX(config->max_chunk / 4, 1) + 4);
+    if (!fp->pool) {
+        g_free(fp);
+        return NULL;
+    }
+
+    fp->appsrc = gst_object_ref(appsrc);
+    fp->fill = fill;
+    fp->user_data = user_data;
+    g_mutex_init(&fp->lock);
+    g_cond_init(&fp->cond);
+
+    g_object_set(appsrc, "block", FALSE, "max-bytes", fp->config.max_bytes, NULL);
+    fp->need_id = g_signal_connect(appsrc, "need-data", G_CALLBACK(on_need_data), fp);
+    fp->enough_id = g_signal_connect(appsrc, "enough-data", G_CALLBACK(on_enough_data), fp);
+
+    fp->running = TRUE;
+    fp->thread = g_thread_new("feed-producer", producer_thread_func, fp);
+
+    g_print("[FEED] 생산자 시작: ring %u개 x 최대 %" G_GSIZE_FORMAT " 바이트, 지연 목표 %.1f ms, max-bytes %"
+            G_GUINT64_FORMAT ", %s\n", fp->config.ring_slots, fp->config.max_chunk, fp->config.latency_us / 1000.0,
+            fp->config.max_bytes, fp->config.realtime ? "실시간" : "backpressure 대기");
+    return fp;
+}
+
+void feed_producer_get_stats(FeedProducer *fp, FeedProducerStats *stats) {
+    stats->pushed = g_atomic_pointer_get(&fp->pushed);
+    stats->pushed_bytes = g_atomic_pointer_get(&fp->pushed_bytes);
+    stats->dropped = g_atomic_pointer_get(&fp->dropped);
+    stats->underruns = g_atomic_pointer_get(&fp->underruns);
+    stats->enough = g_atomic_pointer_get(&fp->enough);
+    stats->ring_peak = g_atomic_int_get(&fp->ring_peak);
+}
+
+void feed_producer_report(FeedProducer *fp) {
+    FeedProducerStats stats;
+
+    if (!fp) return;
+    feed_producer_get_stats(fp, &stats);
+    g_print("[FEED] push %" G_GUINT64_FORMAT "개 (%.1f KB), 버림 %" G_GUINT64_FORMAT
+            ", underrun %" G_GUINT64_FORMAT ", enough-data %" G_GUINT64_FORMAT ", ring 최대 %u/%u\n",
+            stats.pushed, stats.pushed_bytes / 1024.0, stats.dropped,
+            stats.underruns, stats.enough, stats.ring_peak, fp->config.ring_slots);
+}
+
+// 📌 생성 스레드 종료, 신호 해제, ring에 남은 버퍼 정리
+// pipeline을 NULL로 만든 뒤 (appsrc 스트리밍 스레드가 멈춘 다음) 부른다
+void feed_producer_stop(FeedProducer *fp) {
+    if (!fp) return;
+
+    g_signal_handler_disconnect(fp->appsrc, fp->need_id);
+    g_signal_handler_disconnect(fp->appsrc, fp->enough_id);
+    g_atomic_int_set(&fp->wanted, 0);
+
+    g_mutex_lock(&fp->lock);
+    fp->running = FALSE;
+    g_cond_signal(&fp->cond);
+    g_mutex_unlock(&fp->lock);
+    g_thread_join(fp->thread);
+
+    for (guint i = fp->head; i != fp->tail; i++)
+        gst_buffer_unref(fp->slots[i % fp->config.ring_slots]);
+    fp->head = fp->tail;
+
+    gst_object_unref(fp->appsrc);
+    producer_pool_free(fp->pool);
+    g_mutex_clear(&fp->lock);
+    g_cond_clear(&fp->cond);
+    g_free(fp);
+}
@@ -0,0 +1,41 @@
+// feed_producer.h
+/*
+ * 상한이 있는 appsrc 생산자 스레드 (feed_producer.c) 선언
+ */
+#ifndef FEED_PRODUCER_H
+#define FEED_PRODUCER_H
+
+#include <gst/gst.h>
+
+#define FEED_RING_MAX_SLOTS 64
+
+// data에 최대 max_size 바이트, max_duration 분량 이하를 프레임 단위로 채우고 바이트 수를 돌려준다
+// (*duration에 채운 분량의 재생 시간). 0을 돌려주면 이번 chunk는 건너뛴다.
+typedef gsize (*FeedFillFunc)(guint8 *data, gsize max_size, GstClockTime max_duration,
+                              GstClockTime *duration, gpointer user_data);
+
+typedef struct {
+    guint ring_slots;     // 미리 만들어 둘 수 있는 버퍼 수 (최대 FEED_RING_MAX_SLOTS)
+    guint latency_us;     // 버퍼 하나의 최대 재생 시간 (µs)
+    gsize max_chunk;      // 버퍼 하나의 최대 바이트 (latency_us 분량 이상으로)
+    guint64 max_bytes;    // appsrc max-bytes (0이면 max_chunk * 2)
+    gboolean realtime;    // 실시간 속도로 생성, ring이 차면 버림
+} FeedProducerConfig;
+
+typedef struct {
+    guint64 pushed, pushed_bytes;
+    guint64 dropped;      // realtime에서 ring이 차서 버린 chunk
+    guint64 underruns;    // need-data 때 ring이 비어 있던 횟수
+    guint64 enough;       // enough-data 횟수
+    guint ring_peak;      // ring 최대 채움
+} FeedProducerStats;
+
+typedef struct _FeedProducer FeedProducer;
+
+FeedProducer *feed_producer_start(GstElement *appsrc, const FeedProducerConfig *config,
+                                  FeedFillFunc fill, gpointer user_data);
+void feed_producer_get_stats(FeedProducer *fp, FeedProducerStats *stats);
+void feed_producer_report(FeedProducer *fp);
+void feed_producer_stop(FeedProducer *fp);
+
+#endif // FEED_PRODUCER_H
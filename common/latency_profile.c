@@ -0,0 +1,230 @@
+// latency_profile.c
+/*
+ * 종단(입력 → 스피커) 지연 프로필 공용 모듈
+ *
+ * 한 단계만 줄여서는 지연이 줄지 않는다 (가장 큰 버퍼가 전체를 정한다). 프로필 하나로
+ * 송신기와 수신기의 모든 단계를 같이 맞춘다:
+ *
+ *  단계                 LATENCY_DEFAULT         LATENCY_LOW
+ *  생산자 chunk          프로그램 기본 (20~100ms)  2.5~10 ms (기본 5)
+ *  appsrc               max-bytes = chunk 2개    + min-latency = chunk, max-latency = chunk 2개
+ *  Opus 인코더           20 ms, generic           chunk 이하 최대 프레임 (2.5/5/10 ms), restricted-lowdelay
+ *  payloader            기본                     max-ptime = 프레임 (패킷에 프레임을 모으지 않음)
+ *  송출 sink            그대로                    sync/async 끔 (인코딩되는 즉시 송출), 배치 budget 200 us
+ *  수신 jitterbuffer    50 ms                    10 ms
+ *  수신 audio sink      장치 기본                 buffer-time 20 ms, latency-time 5 ms
+ *
+ * AC3는 프레임이 1536 샘플(32 ms) 고정이라 인코더 쪽은 줄일 수 없다.
+ * 나머지 단계(chunk, appsrc, payloader 프레임 1개/패킷, sink, 수신기)는 같이 적용된다.
+ *
+ * 측정 (LATENCY_LOW): 송출 패킷에 RTP header extension(one-byte, id LATENCY_STAMP_EXT_ID)으로
+ * 송신 측 capture 시각(monotonic µs, appsrc PTS를 pipeline clock에서 환산)을 붙이고,
+ * 수신기가 재생 시각(sink에 도착한 버퍼가 clock에 맞춰 나갈 시각)과 비교한다.
+ * 같은 호스트의 monotonic clock을 쓰므로 송신기와 수신기가 같은 기계에 있을 때만 의미가 있다.
+ * 기준은 appsrc push 시각이라 실제 마이크 입력이라면 chunk 길이만큼 더해진다.
+ *
+ * 사용:
+ *   latency_profile_configure(LATENCY_LOW, 0);          // bin 만들기 전에 한 번 (0이면 chunk 기본)
+ *   guint chunk_us = latency_profile_chunk_us(20000);  // 프로그램 기본 20 ms
+ *   latency_profile_tune_appsrc(appsrc, chunk_us);
+ *   latency_profile_tune_element(element);             // codec_registry가 만드는 요소마다, 송출 sink
+ *   latency_profile_stamp(sink);                       // 송출 sink (RTP 세션 probe 뒤)
+ *   latency_profile_read_stamp(rtp_buffer, &capture_us);        // 수신기
+ */
+#include <gst/gst.h>
+#include <gst/base/gstbasesink.h>
+#include <gst/rtp/gstrtpbuffer.h>
+
+#include "latency_profile.h"
+
+#define LATENCY_STAMP_EXT_ID 7
+#define LOW_CHUNK_DEFAULT_US 5000
+#define LOW_CHUNK_MIN_US 2500
+#define LOW_CHUNK_MAX_US 10000
+
+typedef struct {
+    gboolean tune;                 // FALSE면 아무것도 바꾸지 않는다
+    const gchar *opus_audio_type;
+    gboolean sink_no_sync;
+    guint egress_budget_us;
+    guint jitterbuffer_ms;
+    guint64 audio_buffer_time_us, audio_latency_time_us;
+} LatencyPolicy;
+
+static const LatencyPolicy policies[] = {
+    [LATENCY_DEFAULT] = { FALSE },
+    [LATENCY_LOW] = { TRUE, "restricted-lowdelay", TRUE, 200, 10, 20000, 5000 },
+};
+
+static const gchar *profile_names[] = { "default", "low" };
+
+static LatencyProfile current_profile = LATENCY_DEFAULT;
+static guint chunk_us = 0;             // LATENCY_LOW의 생산자 chunk
+static const gchar *opus_frame = NULL; // opusenc frame-size (chunk에서 정함)
+
+// 📌 프로필 설정 (bin을 만들기 전에 호출). chunk_request_us는 LATENCY_LOW에서만, 0이면 기본
+void latency_profile_configure(LatencyProfile profile, guint chunk_request_us) {
+    current_profile = profile;
+    if (profile != LATENCY_LOW) return;
+
+    chunk_us = CLAMP(chunk_request_us ? chunk_request_us : LOW_CHUNK_DEFAULT_US, LOW_CHUNK_MIN_US, LOW_CHUNK_MAX_US);
+    // 한 chunk가 인코더 프레임 하나 이상을 채우도록 (프레임이 chunk보다 길면 인코더가 기다린다)
+    opus_frame = chunk_us >= 10000 ? "10" : chunk_us >= 5000 ? "5" : "2.5";
+    g_print("[LATENCY] 저지연 프로필: chunk %.1f ms, Opus 프레임 %s ms, jitterbuffer %u ms\n",
+            chunk_us / 1000.0, opus_frame, policies[profile].jitterbuffer_ms);
+}
+
+// 📌 "default" / "low" → 프로필
+gboolean latency_profile_parse(const gchar *name, LatencyProfile *profile) {
+    for (guint i = 0; i < G_N_ELEMENTS(profile_names); i++) {
+        if (g_strcmp0(name, profile_names[i]) == 0) {
+            *profile = i;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+gboolean latency_profile_is_low(void) {
+    return current_profile == LATENCY_LOW;
+}
+
+// 📌 생산자 chunk 길이 (프로필이 정하지 않으면 프로그램 기본값 그대로)
+guint latency_profile_chunk_us(guint default_us) {
+    return current_profile == LATENCY_LOW ? chunk_us : default_us;
+}
+
+// 📌 배치 송출 latency budget
+guint latency_profile_egress_budget_us(guint default_us) {
+    return policies[current_profile].tune ? MIN(default_us, policies[current_profile].egress_budget_us) : default_us;
+}
+
+// 📌 수신 jitterbuffer 지연
+guint latency_profile_jitterbuffer_ms(guint default_ms) {
+    return policies[current_profile].tune ? policies[current_profile].jitterbuffer_ms : default_ms;
+}
+
+// 📌 live appsrc가 보고하는 지연을 chunk 하나로 (sink가 chunk보다 길게 기다리지 않게)
+void latency_profile_tune_appsrc(GstElement *appsrc, guint appsrc_chunk_us) {
+    if (!policies[current_profile].tune) return;
+    g_object_set(appsrc,
+                 "min-latency", (gint64)appsrc_chunk_us * GST_USECOND,
+                 "max-latency", (gint64)appsrc_chunk_us * 2 * GST_USECOND,
+                 NULL);
+}
+
+static gboolean has_property(GstElement *element, const gchar *name) {
+    return g_object_class_find_property(G_OBJECT_GET_CLASS(element), name) != NULL;
+}
+
+// 📌 요소 하나를 프로필에 맞춘다 (종류는 factory 이름/속성으로 판단, 모르는 요소는 그대로)
+void latency_profile_tune_element(GstElement *element) {
+    const LatencyPolicy *policy = &policies[current_profile];
+    GstElementFactory *factory;
+    const gchar *name;
+
+    if (!policy->tune || !element) return;
+    factory = gst_element_get_factory(element);
+    name = factory ? GST_OBJECT_NAME(factory) : "";
+
+    if (g_strcmp0(name, "opusenc") == 0) {
+        gst_util_set_object_arg(G_OBJECT(element), "frame-size", opus_frame);
+        gst_util_set_object_arg(G_OBJECT(element), "audio-type", policy->opus_audio_type);
+    } else if (has_property(element, "max-ptime") && has_property(element, "pt")) {
+        // RTP payloader: 프레임을 모아 큰 패킷을 만들지 않는다 (AC3 32 ms 프레임도 한 개씩)
+        g_object_set(element, "max-ptime", (gint64)chunk_us * GST_USECOND, NULL);
+    } else if (has_property(element, "buffer-time") && has_property(element, "latency-time")) {
+        // audio sink (수신기): 장치 ring buffer를 짧게
+        g_object_set(element,
+                     "buffer-time", (gint64)policy->audio_buffer_time_us,
+                     "latency-time", (gint64)policy->audio_latency_time_us,
+                     NULL);
+    } else if (policy->sink_no_sync && GST_IS_BASE_SINK(element)) {
+        // 송출 sink: clock을 기다리지 않고 인코딩되는 즉시
+        g_object_set(element, "sync", FALSE, "async", FALSE, NULL);
+    }
+}
+
+// 📌 버퍼 PTS(pad의 segment 기준) → 이 프로세스의 monotonic µs (clock이 없으면 -1)
+gint64 latency_profile_pts_to_monotonic(GstPad *pad, GstClockTime pts, GstClockTime extra) {
+    GstElement *element = gst_pad_get_parent_element(pad);
+    GstEvent *event = gst_pad_get_sticky_event(pad, GST_EVENT_SEGMENT, 0);
+    GstClock *clock = element ? gst_element_get_clock(element) : NULL;
+    gint64 result = -1;
+
+    if (clock && event && GST_CLOCK_TIME_IS_VALID(pts)) {
+        const GstSegment *segment;
+        GstClockTime running;
+
+        gst_event_parse_segment(event, &segment);
+        running = gst_segment_to_running_time(segment, GST_FORMAT_TIME, pts);
+        if (GST_CLOCK_TIME_IS_VALID(running)) {
+            // pipeline clock과 monotonic의 차이를 지금 한 번 재서 옮긴다 (clock 종류와 무관)
+            GstClockTimeDiff ahead = (GstClockTimeDiff)(gst_element_get_base_time(element) + running + extra) -
+                                     (GstClockTimeDiff)gst_clock_get_time(clock);
+            result = g_get_monotonic_time() + ahead / 1000;
+        }
+    }
+    if (clock) gst_object_unref(clock);
+    if (event) gst_event_unref(event);
+    if (element) gst_object_unref(element);
+    return result;
+}
+
+static void stamp_packet(GstBuffer *buffer, gint64 capture_us) {
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+    guint8 data[8];
+
+    if (!gst_rtp_buffer_map(buffer, GST_MAP_READWRITE, &rtp)) return;
+    GST_WRITE_UINT64_BE(data, (guint64)capture_us);
+    gst_rtp_buffer_add_extension_onebyte_header(&rtp, LATENCY_STAMP_EXT_ID, data, sizeof(data));
+    gst_rtp_buffer_unmap(&rtp);
+}
+
+static GstPadProbeReturn on_sink_input(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+        GstBufferList *list = gst_buffer_list_make_writable(GST_PAD_PROBE_INFO_BUFFER_LIST(info));
+        guint n = gst_buffer_list_length(list);
+
+        for (guint i = 0; i < n; i++) {
+            GstBuffer *buffer = gst_buffer_list_get_writable(list, i);
+            gint64 capture_us = latency_profile_pts_to_monotonic(pad, GST_BUFFER_PTS(buffer), 0);
+            if (capture_us >= 0) stamp_packet(buffer, capture_us);
+        }
+        GST_PAD_PROBE_INFO_DATA(info) = list;
+    } else {
+        GstBuffer *buffer = gst_buffer_make_writable(GST_PAD_PROBE_INFO_BUFFER(info));
+        gint64 capture_us = latency_profile_pts_to_monotonic(pad, GST_BUFFER_PTS(buffer), 0);
+
+        if (capture_us >= 0) stamp_packet(buffer, capture_us);
+        GST_PAD_PROBE_INFO_DATA(info) = buffer;
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+// 📌 송출 sink에 capture 시각 stamp probe (LATENCY_LOW에서만)
+void latency_profile_stamp(GstElement *sink) {
+    GstPad *pad;
+
+    if (current_profile != LATENCY_LOW) return;
+    pad = gst_element_get_static_pad(sink, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+                      on_sink_input, NULL, NULL);
+    gst_object_unref(pad);
+}
+
+// 📌 수신한 RTP 패킷의 송신 측 capture 시각 (stamp가 없으면 FALSE)
+gboolean latency_profile_read_stamp(GstBuffer *buffer, gint64 *capture_us) {
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+    gpointer data;
+    guint size;
+    gboolean found = FALSE;
+
+    if (!gst_rtp_buffer_map(buffer, GST_MAP_READ, &rtp)) return FALSE;
+    if (gst_rtp_buffer_get_extension_onebyte_header(&rtp, LATENCY_STAMP_EXT_ID, 0, &data, &size) && size == 8) {
+        *capture_us = (gint64)GST_READ_UINT64_BE(data);
+        found = TRUE;
+    }
+    gst_rtp_buffer_unmap(&rtp);
+    return found;
+}
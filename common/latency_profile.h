@@ -0,0 +1,27 @@
+// latency_profile.h
+/*
+ * 종단 지연 프로필 (latency_profile.c) 선언
+ */
+#ifndef LATENCY_PROFILE_H
+#define LATENCY_PROFILE_H
+
+#include <gst/gst.h>
+
+typedef enum {
+    LATENCY_DEFAULT,
+    LATENCY_LOW
+} LatencyProfile;
+
+void latency_profile_configure(LatencyProfile profile, guint chunk_request_us);
+gboolean latency_profile_parse(const gchar *name, LatencyProfile *profile);
+gboolean latency_profile_is_low(void);
+guint latency_profile_chunk_us(guint default_us);
+guint latency_profile_egress_budget_us(guint default_us);
+guint latency_profile_jitterbuffer_ms(guint default_ms);
+void latency_profile_tune_appsrc(GstElement *appsrc, guint appsrc_chunk_us);
+void latency_profile_tune_element(GstElement *element);
+gint64 latency_profile_pts_to_monotonic(GstPad *pad, GstClockTime pts, GstClockTime extra);
+void latency_profile_stamp(GstElement *sink);
+gboolean latency_profile_read_stamp(GstBuffer *buffer, gint64 *capture_us);
+
+#endif // LATENCY_PROFILE_H
@@ -0,0 +1,177 @@
+// pcap_capture.c
+/*
+ * 송출 패킷 캡처: 송출 sink로 들어가는 RTP 패킷을 pcap 파일에 기록한다.
+ *
+ * 전환 회귀 시험과 수신기 부하 시험에 같은 트래픽을 다시 쓰기 위한 것 (재생: fancy_sender/pcap_replay.c).
+ * sink 입력 pad probe에서 기록하므로 코덱 전환으로 bin/sink가 바뀌어도 한 파일에 이어서 남는다.
+ * RTP 헤더를 세션 값으로 고쳐 쓰는 probe(../common/rtp_continuity.c)보다 뒤에 붙여야
+ * 실제로 나간 헤더가 기록된다.
+ *
+ *  형식   : pcap (µs 타임스탬프), LINKTYPE_ETHERNET, Ethernet + IPv4 + UDP + RTP.
+ *           Wireshark에서 "Decode As → RTP"로 바로 볼 수 있다
+ *  시각   : probe 시점의 wall clock (배치 송출이면 실제 전송은 최대 latency budget만큼 뒤)
+ *  주소   : 127.0.0.1 → 127.0.0.1:<그 버퍼를 보낼 때 sink의 첫 목적지 포트>. fan-out 복사본은 한 번만 기록
+ *           (실행 중 목적지를 바꾸면 그 뒤 패킷은 새 포트로 기록된다)
+ *  기록   : 스트리밍 스레드에서 버퍼된 fwrite (1초마다 flush, 강제 종료돼도 잃는 것은 최대 1초)
+ *
+ * 사용:
+ *   pcap_capture_open("out.pcap");       // sink 만들기 전에 한 번
+ *   pcap_capture_attach(sink);           // 송출 sink마다 (열려 있지 않으면 아무것도 안 함)
+ *   pcap_capture_close();                // 종료 시 (패킷 수 출력)
+ */
+#include <gst/gst.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PCAP_MAGIC_US 0xa1b2c3d4
+#define PCAP_LINKTYPE_ETHERNET 1
+#define PCAP_SNAPLEN 65535
+#define PCAP_FILE_BUFFER (256 * 1024)
+#define PCAP_FLUSH_INTERVAL_US G_USEC_PER_SEC
+#define CAPTURE_SRC_PORT 40000
+#define ETH_HEADER_LEN 14
+#define IPV4_HEADER_LEN 20
+#define UDP_HEADER_LEN 8
+#define FRAME_HEADER_LEN (ETH_HEADER_LEN + IPV4_HEADER_LEN + UDP_HEADER_LEN)
+
+static struct {
+    GMutex lock;
+    FILE *fp;
+    guint16 ip_id;
+    gint64 last_flush_us;
+    guint64 packets;
+    guint64 bytes;
+} capture;
+
+// ../common/egress.c
+guint egress_get_port(GstElement *sink);
+
+// 📌 IPv4 헤더 checksum (헤더 20바이트, checksum 필드는 0인 상태로)
+static guint16 ipv4_checksum(const guint8 *header) {
+    guint32 sum = 0;
+
+    for (guint i = 0; i < IPV4_HEADER_LEN; i += 2) sum += GST_READ_UINT16_BE(header + i);
+    while (sum >> 16) sum = (sum & 0xffff) + (sum >> 16);
+    return ~sum & 0xffff;
+}
+
+// 📌 레코드 헤더 + Ethernet/IPv4/UDP 헤더 + RTP 패킷 (capture.lock 안에서)
+static void write_record(const guint8 *data, gsize size, guint16 dst_port, gint64 now_us) {
+    guint8 record[16];
+    guint8 frame[FRAME_HEADER_LEN] = { 0 };
+    guint8 *ip = frame + ETH_HEADER_LEN;
+    guint8 *udp = ip + IPV4_HEADER_LEN;
+    gsize caplen = MIN(size, PCAP_SNAPLEN - FRAME_HEADER_LEN);
+
+    GST_WRITE_UINT32_LE(record, now_us / G_USEC_PER_SEC);
+    GST_WRITE_UINT32_LE(record + 4, now_us % G_USEC_PER_SEC);
+    GST_WRITE_UINT32_LE(record + 8, caplen + FRAME_HEADER_LEN);
+    GST_WRITE_UINT32_LE(record + 12, size + FRAME_HEADER_LEN);
+
+    // Ethernet: MAC은 0 (loopback과 같음), EtherType IPv4
+    GST_WRITE_UINT16_BE(frame + 12, 0x0800);
+
+    ip[0] = 0x45;                                             // IPv4, 헤더 20바이트
+    GST_WRITE_UINT16_BE(ip + 2, size + IPV4_HEADER_LEN + UDP_HEADER_LEN);
+    GST_WRITE_UINT16_BE(ip + 4, capture.ip_id++);
+    GST_WRITE_UINT16_BE(ip + 6, 0x4000);                      // DF
+    ip[8] = 64;                                               // TTL
+    ip[9] = 17;                                               // UDP
+    GST_WRITE_UINT32_BE(ip + 12, 0x7f000001);
+    GST_WRITE_UINT32_BE(ip + 16, 0x7f000001);
+    GST_WRITE_UINT16_BE(ip + 10, ipv4_checksum(ip));
+
+    GST_WRITE_UINT16_BE(udp, CAPTURE_SRC_PORT);
+    GST_WRITE_UINT16_BE(udp + 2, dst_port);
+    GST_WRITE_UINT16_BE(udp + 4, size + UDP_HEADER_LEN);      // checksum 0 = 없음
+
+    fwrite(record, 1, sizeof(record), capture.fp);
+    fwrite(frame, 1, sizeof(frame), capture.fp);
+    fwrite(data, 1, caplen, capture.fp);
+    capture.packets++;
+    capture.bytes += size;
+}
+
+static void capture_buffer(GstBuffer *buffer, guint16 dst_port, gint64 now_us) {
+    GstMapInfo map;
+
+    if (!gst_buffer_map(buffer, &map, GST_MAP_READ)) return;
+    write_record(map.data, map.size, dst_port, now_us);
+    gst_buffer_unmap(buffer, &map);
+}
+
+static GstPadProbeReturn on_sink_input(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    guint16 dst_port = egress_get_port(GST_PAD_PARENT(pad)); // 지금 목적지 (실행 중 바뀔 수 있음)
+    gint64 now_us = g_get_real_time();
+
+    g_mutex_lock(&capture.lock);
+    if (capture.fp) {
+        if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+            GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST(info);
+            guint n = gst_buffer_list_length(list);
+
+            for (guint i = 0; i < n; i++) capture_buffer(gst_buffer_list_get(list, i), dst_port, now_us);
+        } else {
+            capture_buffer(GST_PAD_PROBE_INFO_BUFFER(info), dst_port, now_us);
+        }
+        if (now_us - capture.last_flush_us >= PCAP_FLUSH_INTERVAL_US) {
+            fflush(capture.fp);
+            capture.last_flush_us = now_us;
+        }
+    }
+    g_mutex_unlock(&capture.lock);
+    return GST_PAD_PROBE_OK;
+}
+
+// 📌 캡처 파일 열기 + pcap 전역 헤더 (little endian으로 기록)
+gboolean pcap_capture_open(const gchar *path) {
+    guint8 header[24];
+    FILE *fp = fopen(path, "wb");
+
+    if (!fp) {
+        g_printerr("[PCAP] %s 열기 실패\n", path);
+        return FALSE;
+    }
+    setvbuf(fp, NULL, _IOFBF, PCAP_FILE_BUFFER);
+
+    GST_WRITE_UINT32_LE(header, PCAP_MAGIC_US);
+    GST_WRITE_UINT16_LE(header + 4, 2);   // version 2.4
+    GST_WRITE_UINT16_LE(header + 6, 4);
+    GST_WRITE_UINT32_LE(header + 8, 0);   // thiszone
+    GST_WRITE_UINT32_LE(header + 12, 0);  // sigfigs
+    GST_WRITE_UINT32_LE(header + 16, PCAP_SNAPLEN);
+    GST_WRITE_UINT32_LE(header + 20, PCAP_LINKTYPE_ETHERNET);
+    fwrite(header, 1, sizeof(header), fp);
+
+    g_mutex_lock(&capture.lock);
+    capture.fp = fp;
+    capture.packets = capture.bytes = 0;
+    capture.last_flush_us = g_get_real_time();
+    g_mutex_unlock(&capture.lock);
+
+    g_print("[PCAP] 송출 패킷 캡처: %s\n", path);
+    return TRUE;
+}
+
+// 📌 송출 sink에 캡처 probe (목적지 포트는 버퍼마다 그때의 첫 목적지)
+void pcap_capture_attach(GstElement *sink) {
+    GstPad *pad;
+
+    if (!capture.fp) return;
+    pad = gst_element_get_static_pad(sink, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+                      on_sink_input, NULL, NULL);
+    gst_object_unref(pad);
+}
+
+// 📌 파일 닫기 (이후 probe는 기록하지 않는다)
+void pcap_capture_close(void) {
+    g_mutex_lock(&capture.lock);
+    if (capture.fp) {
+        fclose(capture.fp);
+        capture.fp = NULL;
+        g_print("[PCAP] 캡처 종료: 패킷 %" G_GUINT64_FORMAT "개, %" G_GUINT64_FORMAT " bytes\n",
+                capture.packets, capture.bytes);
+    }
+    g_mutex_unlock(&capture.lock);
+}
@@ -0,0 +1,453 @@
+// pipeline_trace.c
+/*
+ * 송신 bin 안 element별 지연/처리량 추적
+ *
+ * 환경 변수 PIPELINE_TRACE가 있을 때만 켜진다 (없으면 probe를 하나도 달지 않는다 → 비용 0).
+ *   PIPELINE_TRACE=/tmp/trace.json   주기마다 JSON 파일을 통째로 다시 씀 (tmp 파일 + rename)
+ *   PIPELINE_TRACE=-                 JSON을 stdout으로
+ *   PIPELINE_TRACE_INTERVAL=5        덤프 주기 초 (기본 5)
+ *
+ * bin의 element마다 pad probe를 달아서 버퍼 하나당 다음을 기록한다.
+ *   process : element의 sink pad에 들어온 뒤 src pad로 나갈 때까지 (같은 스트리밍 스레드)
+ *   queue   : queue element 대기 시간 (PTS로 들어간 버퍼/나온 버퍼를 짝지음)
+ *   sink    : appsrc 타임스탬프(running time) → 송출 sink 도착까지 종단 지연, pps, 바이트/초
+ *
+ * 값은 log2(us) 구간 히스토그램에 원자적 증가로만 쌓는다 (락 없음).
+ * 같은 종류의 bin이 여러 번 만들어져도(전환, 다중 세션) "bin이름/element" 이름으로 합쳐진다.
+ *
+ * 사용:
+ *   pipeline_trace_init();                 // main에서 한 번
+ *   pipeline_trace_attach(bin, NULL);      // bin을 만든 직후
+ *   pipeline_trace_shutdown();             // 마지막 덤프
+ */
+#include <gst/gst.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#define TRACE_BUCKETS 24            // 1us ~ 8s
+#define TRACE_MAX_SERIES 128
+#define TRACE_QUEUE_RING 256        // queue 안에 동시에 있을 수 있는 버퍼 수 (넘치면 그 버퍼는 측정 안 함)
+#define TRACE_OVERHEAD_SAMPLE 64    // probe 자체 비용은 64번에 한 번만 잰다
+#define TRACE_ELEMENT_KEY "pipeline-trace"
+
+typedef enum {
+    SERIES_PROCESS,
+    SERIES_QUEUE,
+    SERIES_SINK
+} SeriesKind;
+
+typedef struct {
+    volatile gint buckets[TRACE_BUCKETS]; // buckets[i]: 2^(i-1) <= us < 2^i
+    volatile gsize count;
+    volatile gsize sum_us;
+} TraceHistogram;
+
+typedef struct {
+    gchar *name;
+    SeriesKind kind;
+    TraceHistogram hist;          // process/queue 시간, sink면 종단 지연
+    volatile gsize packets;
+    volatile gsize bytes;
+
+    // 덤프 스레드 전용 (직전 덤프 값)
+    guint64 last_packets, last_bytes;
+} TraceSeries;
+
+// element 하나의 probe 상태 (element object data, element와 함께 해제)
+typedef struct {
+    TraceSeries *series;
+    GstElement *element;
+    gint64 entry_us;              // process: sink pad 진입 시각 (같은 스레드에서만 읽고 씀)
+
+    // queue: 들어간 버퍼의 (PTS, 시각) 링. 쓰는 쪽 upstream 스레드, 읽는 쪽 queue 스레드
+    GstClockTime ring_pts[TRACE_QUEUE_RING];
+    gint64 ring_us[TRACE_QUEUE_RING];
+    volatile guint head, tail;
+} TraceElement;
+
+static gboolean trace_enabled = FALSE;
+static gchar *trace_path = NULL;
+static guint trace_interval_s = 5;
+
+static GMutex series_lock;        // series 등록만 보호 (기록은 락 없음)
+static TraceSeries *series_table[TRACE_MAX_SERIES];
+static volatile gint series_count = 0;
+
+static volatile gsize probe_calls = 0;
+static volatile gsize overhead_ns = 0;
+
+static GThread *dump_thread = NULL;
+static GMutex dump_lock;
+static GCond dump_cond;
+static gboolean dump_running = FALSE;
+
+// 📌 히스토그램에 us 값 하나 추가 (락 없음)
+static void histogram_add(TraceHistogram *h, gint64 us) {
+    guint bucket = 0;
+
+    if (us < 0) us = 0;
+    if (us > 0) bucket = MIN(g_bit_storage((gulong)us), TRACE_BUCKETS - 1);
+    g_atomic_int_inc(&h->buckets[bucket]);
+    g_atomic_pointer_add(&h->count, 1);
+    g_atomic_pointer_add(&h->sum_us, (gsize)us);
+}
+
+// 📌 누적 비율 q에 해당하는 구간 상한 (us)
+static guint64 histogram_quantile(const gint *buckets, guint64 count, gdouble q) {
+    guint64 seen = 0, target = (guint64)(count * q);
+
+    for (guint i = 0; i < TRACE_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen > target) return i ? (G_GUINT64_CONSTANT(1) << i) : 1;
+    }
+    return G_GUINT64_CONSTANT(1) << (TRACE_BUCKETS - 1);
+}
+
+// 📌 이름으로 series 찾기/등록 (bin을 만들 때만, main loop 스레드)
+static TraceSeries *get_series(const gchar *name, SeriesKind kind) {
+    TraceSeries *series = NULL;
+
+    g_mutex_lock(&series_lock);
+    for (gint i = 0; i < series_count; i++) {
+        if (strcmp(series_table[i]->name, name) == 0) {
+            series = series_table[i];
+            break;
+        }
+    }
+    if (!series && series_count < TRACE_MAX_SERIES) {
+        series = g_new0(TraceSeries, 1);
+        series->name = g_strdup(name);
+        series->kind = kind;
+        series_table[series_count] = series;
+        g_atomic_int_inc(&series_count); // 덤프 스레드는 개수를 먼저 읽고 표를 읽는다
+    }
+    g_mutex_unlock(&series_lock);
+    return series;
+}
+
+static gint64 now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (gint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// 📌 probe 자체 비용 측정 (TRACE_OVERHEAD_SAMPLE번에 한 번만 시각을 읽는다, 아니면 0)
+static gint64 overhead_begin(void) {
+    if (g_atomic_pointer_add(&probe_calls, 1) % TRACE_OVERHEAD_SAMPLE != 0) return 0;
+    return now_ns();
+}
+
+static void overhead_end(gint64 start_ns) {
+    if (start_ns) g_atomic_pointer_add(&overhead_ns, (gsize)((now_ns() - start_ns) * TRACE_OVERHEAD_SAMPLE));
+}
+
+static GstBuffer *probe_first_buffer(GstPadProbeInfo *info) {
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+        GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST(info);
+        return gst_buffer_list_length(list) ? gst_buffer_list_get(list, 0) : NULL;
+    }
+    return GST_PAD_PROBE_INFO_BUFFER(info);
+}
+
+// 📌 sink pad 진입 (process: 시각 기록, queue: 링에 넣기, sink: 종단 지연/처리량)
+static GstPadProbeReturn on_sink_buffer(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    TraceElement *te = user_data;
+    gint64 sample_ns = overhead_begin();
+    gint64 now = g_get_monotonic_time();
+    GstBuffer *buffer = probe_first_buffer(info);
+
+    switch (te->series->kind) {
+    case SERIES_PROCESS:
+        te->entry_us = now;
+        break;
+    case SERIES_QUEUE: {
+        guint tail = g_atomic_int_get(&te->tail);
+
+        if (buffer && GST_BUFFER_PTS_IS_VALID(buffer) &&
+            tail - g_atomic_int_get(&te->head) < TRACE_QUEUE_RING) {
+            te->ring_pts[tail % TRACE_QUEUE_RING] = GST_BUFFER_PTS(buffer);
+            te->ring_us[tail % TRACE_QUEUE_RING] = now;
+            g_atomic_int_set(&te->tail, tail + 1);
+        }
+        break;
+    }
+    case SERIES_SINK: {
+        guint n = 1;
+        gsize bytes;
+        GstClockTime running;
+
+        if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+            GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST(info);
+            n = gst_buffer_list_length(list);
+            bytes = gst_buffer_list_calculate_size(list);
+        } else {
+            bytes = gst_buffer_get_size(buffer);
+        }
+        g_atomic_pointer_add(&te->series->packets, n);
+        g_atomic_pointer_add(&te->series->bytes, bytes);
+
+        // appsrc do-timestamp PTS = 넣은 순간의 running time
+        if (buffer && GST_BUFFER_PTS_IS_VALID(buffer)) {
+            running = gst_element_get_current_running_time(te->element);
+            if (GST_CLOCK_TIME_IS_VALID(running) && running >= GST_BUFFER_PTS(buffer))
+                histogram_add(&te->series->hist, (running - GST_BUFFER_PTS(buffer)) / GST_USECOND);
+        }
+        break;
+    }
+    }
+
+    overhead_end(sample_ns);
+    return GST_PAD_PROBE_OK;
+}
+
+// 📌 src pad 출력 (process: 진입부터 걸린 시간, queue: 같은 PTS 버퍼의 대기 시간)
+static GstPadProbeReturn on_src_buffer(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    TraceElement *te = user_data;
+    gint64 sample_ns = overhead_begin();
+    gint64 now = g_get_monotonic_time();
+
+    if (te->series->kind == SERIES_PROCESS) {
+        if (te->entry_us) histogram_add(&te->series->hist, now - te->entry_us);
+    } else {
+        GstBuffer *buffer = probe_first_buffer(info);
+        guint head = g_atomic_int_get(&te->head), tail = g_atomic_int_get(&te->tail);
+
+        // leaky queue가 버린 버퍼나 측정 못 한 버퍼는 PTS가 앞서므로 건너뛴다
+        while (buffer && GST_BUFFER_PTS_IS_VALID(buffer) && head != tail) {
+            GstClockTime pts = te->ring_pts[head % TRACE_QUEUE_RING];
+            gint64 entered = te->ring_us[head % TRACE_QUEUE_RING];
+
+            if (pts > GST_BUFFER_PTS(buffer)) break;
+            head++;
+            if (pts == GST_BUFFER_PTS(buffer)) {
+                histogram_add(&te->series->hist, now - entered);
+                break;
+            }
+        }
+        g_atomic_int_set(&te->head, head);
+    }
+
+    overhead_end(sample_ns);
+    return GST_PAD_PROBE_OK;
+}
+
+static GstPad *first_pad(GstElement *element, gboolean sink) {
+    GstPad *pad = NULL;
+    GList *pads;
+
+    GST_OBJECT_LOCK(element);
+    pads = sink ? element->sinkpads : element->srcpads;
+    if (pads) pad = gst_object_ref(pads->data);
+    GST_OBJECT_UNLOCK(element);
+    return pad;
+}
+
+// 📌 queue는 뒤에 오는 element 이름으로 구분 ("queue>opusenc")
+static gchar *series_name(const gchar *label, GstElement *element) {
+    const gchar *factory = GST_OBJECT_NAME(gst_element_get_factory(element));
+    gchar *name;
+
+    if (g_strcmp0(factory, "queue") == 0) {
+        GstPad *src = first_pad(element, FALSE);
+        GstPad *peer = src ? gst_pad_get_peer(src) : NULL;
+        GstElement *next = peer ? gst_pad_get_parent_element(peer) : NULL;
+
+        name = g_strdup_printf("%s/queue>%s", label,
+                               next ? GST_OBJECT_NAME(gst_element_get_factory(next)) : "?");
+        if (next) gst_object_unref(next);
+        if (peer) gst_object_unref(peer);
+        if (src) gst_object_unref(src);
+        return name;
+    }
+    return g_strdup_printf("%s/%s", label, factory);
+}
+
+static void attach_element(GstElement *element, const gchar *label) {
+    GstPad *sinkpad, *srcpad;
+    TraceElement *te;
+    SeriesKind kind;
+    gchar *name;
+
+    if (!gst_element_get_factory(element) || GST_IS_BIN(element)) return;
+    if (g_object_get_data(G_OBJECT(element), TRACE_ELEMENT_KEY)) return; // 이미 추적 중
+
+    sinkpad = first_pad(element, TRUE);
+    srcpad = first_pad(element, FALSE);
+    if (!sinkpad) {
+        if (srcpad) gst_object_unref(srcpad);
+        return; // source element는 sink에서 PTS로 잰다
+    }
+
+    if (!srcpad) kind = SERIES_SINK;
+    else if (g_strcmp0(GST_OBJECT_NAME(gst_element_get_factory(element)), "queue") == 0) kind = SERIES_QUEUE;
+    else kind = SERIES_PROCESS;
+
+    name = series_name(label, element);
+    te = g_new0(TraceElement, 1);
+    te->series = get_series(name, kind);
+    te->element = element;
+    g_free(name);
+    if (!te->series) {
+        g_free(te);
+        gst_object_unref(sinkpad);
+        if (srcpad) gst_object_unref(srcpad);
+        return;
+    }
+    g_object_set_data_full(G_OBJECT(element), TRACE_ELEMENT_KEY, te, g_free);
+
+    gst_pad_add_probe(sinkpad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+                      on_sink_buffer, te, NULL);
+    if (srcpad) {
+        gst_pad_add_probe(srcpad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+                          on_src_buffer, te, NULL);
+        gst_object_unref(srcpad);
+    }
+    gst_object_unref(sinkpad);
+}
+
+static void append_histogram(GString *out, const TraceHistogram *h) {
+    gint buckets[TRACE_BUCKETS];
+    guint64 count = g_atomic_pointer_get(&h->count);
+    guint64 sum = g_atomic_pointer_get(&h->sum_us);
+
+    for (guint i = 0; i < TRACE_BUCKETS; i++) buckets[i] = g_atomic_int_get(&h->buckets[i]);
+
+    g_string_append_printf(out, "\"count\": %" G_GUINT64_FORMAT ", \"mean_us\": %.1f, "
+                           "\"p50_us\": %" G_GUINT64_FORMAT ", \"p99_us\": %" G_GUINT64_FORMAT ", \"log2_us\": [",
+                           count, count ? (gdouble)sum / count : 0.0,
+                           histogram_quantile(buckets, count, 0.50), histogram_quantile(buckets, count, 0.99));
+    for (guint i = 0; i < TRACE_BUCKETS; i++)
+        g_string_append_printf(out, "%s%d", i ? ", " : "", buckets[i]);
+    g_string_append(out, "]");
+}
+
+// 📌 현재 누적값을 JSON으로 (덤프 스레드에서만)
+static void write_dump(gdouble elapsed_s) {
+    static const gchar *kind_names[] = { "process", "queue", "sink" };
+    static gdouble last_cpu_s = 0.0;
+    static guint64 last_overhead_ns = 0;
+    GString *out = g_string_new("{\n");
+    gint n = g_atomic_int_get(&series_count);
+    guint64 overhead = g_atomic_pointer_get(&overhead_ns);
+    struct rusage usage;
+    gdouble cpu_s;
+
+    getrusage(RUSAGE_SELF, &usage);
+    cpu_s = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+            (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+
+    // 추적 비용: probe 안에서 쓴 시간 / 프로세스 CPU 시간
+    g_string_append_printf(out, "  \"interval_s\": %.2f,\n  \"overhead_pct\": %.3f,\n  \"series\": [\n",
+                           elapsed_s,
+                           cpu_s > last_cpu_s ? (overhead - last_overhead_ns) / 1e9 * 100.0 / (cpu_s - last_cpu_s) : 0.0);
+    last_cpu_s = cpu_s;
+    last_overhead_ns = overhead;
+
+    for (gint i = 0; i < n; i++) {
+        TraceSeries *s = series_table[i];
+
+        g_string_append_printf(out, "    { \"name\": \"%s\", \"kind\": \"%s\", ", s->name, kind_names[s->kind]);
+        if (s->kind == SERIES_SINK) {
+            guint64 packets = g_atomic_pointer_get(&s->packets);
+            guint64 bytes = g_atomic_pointer_get(&s->bytes);
+
+            g_string_append_printf(out, "\"pps\": %.1f, \"bytes_per_s\": %.1f, \"e2e\": { ",
+                                   (packets - s->last_packets) / elapsed_s, (bytes - s->last_bytes) / elapsed_s);
+            append_histogram(out, &s->hist);
+            g_string_append(out, " }");
+            s->last_packets = packets;
+            s->last_bytes = bytes;
+        } else {
+            append_histogram(out, &s->hist);
+        }
+        g_string_append_printf(out, " }%s\n", i + 1 < n ? "," : "");
+    }
+    g_string_append(out, "  ]\n}\n");
+
+    if (g_strcmp0(trace_path, "-") == 0) {
+        fputs(out->str, stdout);
+        fflush(stdout);
+    } else {
+        GError *error = NULL;
+        if (!g_file_set_contents(trace_path, out->str, out->len, &error)) {
+            g_printerr("[TRACE] 덤프 실패: %s\n", error->message);
+            g_error_free(error);
+        }
+    }
+    g_string_free(out, TRUE);
+}
+
+static gpointer dump_thread_func(gpointer data) {
+    gint64 last_us = g_get_monotonic_time();
+
+    g_mutex_lock(&dump_lock);
+    while (dump_running) {
+        gint64 deadline = last_us + (gint64)trace_interval_s * G_USEC_PER_SEC;
+
+        // 깨어났으면 (종료 요청 또는 가짜 깨어남) 다시 확인, 시간이 되면 덤프
+        if (g_cond_wait_until(&dump_cond, &dump_lock, deadline)) continue;
+
+        g_mutex_unlock(&dump_lock);
+        write_dump((g_get_monotonic_time() - last_us) / 1e6);
+        last_us = g_get_monotonic_time();
+        g_mutex_lock(&dump_lock);
+    }
+    g_mutex_unlock(&dump_lock);
+    return NULL;
+}
+
+// 📌 PIPELINE_TRACE를 읽고 켜져 있으면 덤프 스레드 시작
+gboolean pipeline_trace_init(void) {
+    const gchar *path = g_getenv("PIPELINE_TRACE");
+    const gchar *interval = g_getenv("PIPELINE_TRACE_INTERVAL");
+
+    if (!path || !*path || trace_enabled) return trace_enabled;
+
+    trace_path = g_strdup(path);
+    if (interval && g_ascii_strtoull(interval, NULL, 10) > 0)
+        trace_interval_s = (guint)g_ascii_strtoull(interval, NULL, 10);
+    trace_enabled = TRUE;
+
+    dump_running = TRUE;
+    dump_thread = g_thread_new("pipeline-trace", dump_thread_func, NULL);
+    g_print("[TRACE] element 추적 켜짐 → %s (%u초마다)\n", trace_path, trace_interval_s);
+    return TRUE;
+}
+
+// 📌 bin 안 모든 element에 probe 연결 (꺼져 있으면 아무것도 하지 않음)
+// label: series 이름 앞부분, NULL이면 bin 이름. 같은 label의 bin들은 합쳐서 집계된다
+void pipeline_trace_attach(GstElement *bin, const gchar *label) {
+    GstIterator *it;
+    GValue item = G_VALUE_INIT;
+
+    if (!trace_enabled || !bin) return;
+    if (!GST_IS_BIN(bin)) {
+        attach_element(bin, label ? label : GST_ELEMENT_NAME(bin));
+        return;
+    }
+
+    it = gst_bin_iterate_recurse(GST_BIN(bin));
+    while (gst_iterator_next(it, &item) == GST_ITERATOR_OK) {
+        attach_element(g_value_get_object(&item), label ? label : GST_ELEMENT_NAME(bin));
+        g_value_reset(&item);
+    }
+    g_value_unset(&item);
+    gst_iterator_free(it);
+}
+
+// 📌 마지막 덤프 후 덤프 스레드 종료
+void pipeline_trace_shutdown(void) {
+    if (!dump_thread) return;
+
+    g_mutex_lock(&dump_lock);
+    dump_running = FALSE;
+    g_cond_signal(&dump_cond);
+    g_mutex_unlock(&dump_lock);
+    g_thread_join(dump_thread);
+    dump_thread = NULL;
+
+    write_dump(trace_interval_s);
+}
@@ -0,0 +1,88 @@
+// producer_pool.c
+/*
+ * appsrc 생산자용 고정 크기 버퍼 풀 (GstBufferPool 기반)
+ *
+ * 호출자는 producer_pool_acquire()로 받은 버퍼를 map(WRITE)해서 그 자리에 채운 뒤 appsrc로 보낸다.
+ * downstream이 버퍼를 놓으면 풀로 돌아오므로, 정상 스트리밍 중에는 힙 할당이 없다.
+ *
+ *   hit  : 풀에 있던 버퍼를 재사용
+ *   miss : 새로 할당 (풀이 비었거나, downstream이 메모리를 바꿔서 풀이 버퍼를 버린 경우)
+ */
+#include <gst/gst.h>
+
+typedef struct _ProducerPool {
+    GstBufferPool *pool;
+    guint buffer_size;
+    volatile gsize hits;
+    volatile gsize misses;
+} ProducerPool;
+
+// 풀이 한 번 이상 내준 버퍼 표시 (풀에서 돌아온 버퍼는 qdata가 유지된다)
+static GQuark recycled_quark;
+
+// 📌 buffer_size 크기 버퍼 max_buffers개를 미리 할당해 둔 풀 생성
+ProducerPool *producer_pool_new(guint buffer_size, guint max_buffers) {
+    ProducerPool *pp;
+    GstStructure *config;
+    GstBuffer **warm;
+
+    if (!recycled_quark) recycled_quark = g_quark_from_static_string("producer-pool-recycled");
+
+    pp = g_new0(ProducerPool, 1);
+    pp->buffer_size = buffer_size;
+    pp->pool = gst_buffer_pool_new();
+
+    config = gst_buffer_pool_get_config(pp->pool);
+    gst_buffer_pool_config_set_params(config, NULL, buffer_size, max_buffers, max_buffers);
+    if (!gst_buffer_pool_set_config(pp->pool, config) || !gst_buffer_pool_set_active(pp->pool, TRUE)) {
+        g_printerr("[POOL] 버퍼 풀 설정 실패 (%u x %u 바이트)\n", max_buffers, buffer_size);
+        gst_object_unref(pp->pool);
+        g_free(pp);
+        return NULL;
+    }
+
+    // 미리 할당된 버퍼들에 표시를 달아 둔다 (시작 시 할당은 miss로 세지 않음)
+    warm = g_new0(GstBuffer *, max_buffers);
+    for (guint i = 0; i < max_buffers; i++) {
+        if (gst_buffer_pool_acquire_buffer(pp->pool, &warm[i], NULL) != GST_FLOW_OK) break;
+        gst_mini_object_set_qdata(GST_MINI_OBJECT(warm[i]), recycled_quark, GINT_TO_POINTER(1), NULL);
+    }
+    for (guint i = 0; i < max_buffers && warm[i]; i++) gst_buffer_unref(warm[i]);
+    g_free(warm);
+
+    return pp;
+}
+
+// 📌 쓰기 가능한 고정 크기 버퍼 하나 (기다리지 않음)
+GstBuffer *producer_pool_acquire(ProducerPool *pp) {
+    GstBufferPoolAcquireParams params = { 0 };
+    GstBuffer *buffer = NULL;
+
+    params.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+    if (gst_buffer_pool_acquire_buffer(pp->pool, &buffer, &params) == GST_FLOW_OK) {
+        if (gst_mini_object_get_qdata(GST_MINI_OBJECT(buffer), recycled_quark)) {
+            g_atomic_pointer_add(&pp->hits, 1);
+        } else {
+            // 풀이 버렸던 자리를 새로 채운 버퍼
+            gst_mini_object_set_qdata(GST_MINI_OBJECT(buffer), recycled_quark, GINT_TO_POINTER(1), NULL);
+            g_atomic_pointer_add(&pp->misses, 1);
+        }
+        return buffer;
+    }
+
+    // 모든 버퍼가 downstream에 있음 → 풀 밖의 일회용 버퍼
+    g_atomic_pointer_add(&pp->misses, 1);
+    return gst_buffer_new_allocate(NULL, pp->buffer_size, NULL);
+}
+
+void producer_pool_get_stats(ProducerPool *pp, guint64 *hits, guint64 *misses) {
+    if (hits) *hits = g_atomic_pointer_get(&pp->hits);
+    if (misses) *misses = g_atomic_pointer_get(&pp->misses);
+}
+
+void producer_pool_free(ProducerPool *pp) {
+    if (!pp) return;
+    gst_buffer_pool_set_active(pp->pool, FALSE);
+    gst_object_unref(pp->pool);
+    g_free(pp);
+}
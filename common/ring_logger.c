@@ -0,0 +1,443 @@
+// ring_logger.c
+/*
+ * 스트리밍 스레드용 비동기 로거
+ *
+ * 호출 스레드는 고정 크기 바이너리 레코드(시각, 포맷 포인터, 인자 값)를 자기 스레드 전용
+ * ring에 복사만 한다. 락/stdio/문자열 포맷팅이 없다. 문자열 포맷팅과 stdout/stderr 출력은
+ * 백그라운드 flush 스레드가 한다. ring이 가득 차면 기다리지 않고 버리고 개수만 센다.
+ *
+ *  - fmt는 printf 형식이며 문자열 리터럴이어야 한다 (포인터만 저장, 나중에 포맷).
+ *  - %s 인자는 레코드 안에 복사된다 (레코드당 합쳐서 RING_LOG_TEXT_BYTES까지, 넘치면 잘림).
+ *  - 인자는 최대 RING_LOG_MAX_ARGS개, '*' 폭/정밀도와 %n은 지원하지 않는다.
+ *
+ * 사용:
+ *   ring_log("[DETECTOR] 검사 속도 %.1f MB/s\n", mbps);
+ *   ring_log_error("[EGRESS] 실패: %s\n", g_strerror(errno));
+ *   ring_log_timed("[FORMAT SWITCHED] -> %s\n", "AC3");   // 앞에 벽시계 시각
+ *   ring_logger_shutdown();                              // 남은 기록 출력 (exit 때도 자동)
+ */
+#include <gst/gst.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RING_LOG_CAPACITY 512       // 스레드당 레코드 수
+#define RING_LOG_MAX_ARGS 8
+#define RING_LOG_TEXT_BYTES 64
+#define RING_LOG_FLUSH_INTERVAL_US 10000
+
+#define RING_LOG_STDERR (1 << 0)
+#define RING_LOG_TIMED  (1 << 1)
+
+typedef union {
+    gint64 i;
+    guint64 u;
+    gdouble d;
+    long double ld;
+    guint text_offset;              // %s: text[] 안의 위치
+} RingLogArg;
+
+typedef struct {
+    gint64 time_us;                 // g_get_real_time
+    const gchar *fmt;
+    guint8 flags;
+    guint8 nargs;
+    guint8 text_used;
+    RingLogArg args[RING_LOG_MAX_ARGS];
+    gchar text[RING_LOG_TEXT_BYTES];
+} RingLogRecord;
+
+// 스레드 하나의 ring (쓰는 쪽: 그 스레드, 읽는 쪽: flush 스레드)
+typedef struct {
+    RingLogRecord records[RING_LOG_CAPACITY];
+    volatile guint head, tail;
+    volatile gsize written, dropped;
+    volatile gint exited;           // 스레드가 끝났으면 flush 스레드가 비운 뒤 해제
+} RingLogThread;
+
+static void on_thread_exit(gpointer data);
+static GPrivate thread_ring = G_PRIVATE_INIT(on_thread_exit);
+
+static GMutex rings_lock;           // ring 등록/해제만 보호
+static GPtrArray *rings = NULL;
+
+static GThread *flush_thread = NULL;
+static GMutex flush_lock;
+static GCond flush_cond, flushed_cond;
+static gboolean flush_running = FALSE;
+static guint64 flush_requested = 0, flush_done = 0;
+
+static gsize total_written = 0, total_dropped = 0; // rings_lock 보호 (떠난 스레드 몫 포함)
+
+static void on_thread_exit(gpointer data) {
+    RingLogThread *ring = data;
+
+    g_atomic_int_set(&ring->exited, 1);
+}
+
+// 📌 printf 변환 하나 파싱: *p는 '%' 다음을 가리킨다. 길이 수식어와 변환 문자를 돌려주고
+// spec에는 길이 수식어를 뺀 "%[flags][width][.precision]"를 담는다 (spec이 NULL이면 생략)
+static gchar parse_spec(const gchar **p, gchar *length, GString *spec) {
+    const gchar *s = *p;
+
+    if (spec) g_string_append_c(spec, '%');
+    while (*s && strchr("-+ #0123456789.", *s)) {
+        if (spec) g_string_append_c(spec, *s);
+        s++;
+    }
+    *length = 0;
+    while (*s && strchr("hlLqjzt", *s)) {
+        // 64비트 이상이면 'l'로 통일 (LP64: long == gint64), long double은 'L'
+        if (*s == 'L') *length = 'L';
+        else if (*s != 'h' && *length != 'L') *length = 'l';
+        s++;
+    }
+    *p = *s ? s + 1 : s;
+    return *s;
+}
+
+static RingLogThread *get_thread_ring(void);
+
+// 📌 호출 스레드: 인자를 형식에 맞게 꺼내 레코드에 복사만 한다
+static void ring_log_va(guint8 flags, const gchar *fmt, va_list ap) {
+    RingLogThread *ring = get_thread_ring();
+    guint tail = ring->tail;
+    RingLogRecord *rec;
+    const gchar *p = fmt;
+
+    if (tail - g_atomic_int_get(&ring->head) >= RING_LOG_CAPACITY) {
+        g_atomic_pointer_add(&ring->dropped, 1);
+        return;
+    }
+
+    rec = &ring->records[tail % RING_LOG_CAPACITY];
+    rec->time_us = g_get_real_time();
+    rec->fmt = fmt;
+    rec->flags = flags;
+    rec->nargs = 0;
+    rec->text_used = 0;
+
+    while ((p = strchr(p, '%')) != NULL) {
+        gchar length, conv;
+        RingLogArg *arg;
+
+        p++;
+        if (*p == '%') {
+            p++;
+            continue;
+        }
+        conv = parse_spec(&p, &length, NULL);
+        if (!conv || rec->nargs >= RING_LOG_MAX_ARGS) break;
+        arg = &rec->args[rec->nargs++];
+
+        switch (conv) {
+        case 'd': case 'i':
+            arg->i = length == 'l' ? va_arg(ap, gint64) : va_arg(ap, gint);
+            break;
+        case 'u': case 'x': case 'X': case 'o':
+            arg->u = length == 'l' ? va_arg(ap, guint64) : va_arg(ap, guint);
+            break;
+        case 'c':
+            arg->i = va_arg(ap, gint);
+            break;
+        case 'p':
+            arg->u = (guint64)(guintptr)va_arg(ap, gpointer);
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            if (length == 'L') arg->ld = va_arg(ap, long double);
+            else arg->d = va_arg(ap, gdouble);
+            break;
+        case 's': {
+            const gchar *str = va_arg(ap, const gchar *);
+            gsize room = RING_LOG_TEXT_BYTES - rec->text_used;
+            gsize len;
+
+            if (!str) str = "(null)";
+            len = room ? MIN(strlen(str), room - 1) : 0;
+            arg->text_offset = rec->text_used;
+            if (room) {
+                memcpy(rec->text + rec->text_used, str, len);
+                rec->text[rec->text_used + len] = '\0';
+                rec->text_used += len + 1;
+            } else {
+                arg->text_offset = RING_LOG_TEXT_BYTES - 1; // 빈 문자열
+                rec->text[RING_LOG_TEXT_BYTES - 1] = '\0';
+            }
+            break;
+        }
+        default:
+            rec->nargs--; // 지원하지 않는 변환: 그대로 출력
+            break;
+        }
+    }
+
+    g_atomic_int_set(&ring->tail, tail + 1);
+    g_atomic_pointer_add(&ring->written, 1);
+}
+
+// 📌 flush 스레드: 레코드 하나를 문자열로
+static void format_record(GString *out, const RingLogRecord *rec) {
+    GString *spec = g_string_new(NULL);
+    const gchar *p = rec->fmt;
+    guint n = 0;
+
+    if (rec->flags & RING_LOG_TIMED) {
+        time_t secs = rec->time_us / G_USEC_PER_SEC;
+        struct tm tm;
+        gchar timebuf[32];
+
+        localtime_r(&secs, &tm);
+        strftime(timebuf, sizeof(timebuf), "%Y-%m-%d %H:%M:%S", &tm);
+        g_string_append_printf(out, "[%s.%03d] ", timebuf, (gint)(rec->time_us % G_USEC_PER_SEC / 1000));
+    }
+
+    while (*p) {
+        const gchar *pct = strchr(p, '%');
+        gchar length, conv;
+
+        if (!pct) {
+            g_string_append(out, p);
+            break;
+        }
+        g_string_append_len(out, p, pct - p);
+        p = pct + 1;
+        if (*p == '%') {
+            g_string_append_c(out, '%');
+            p++;
+            continue;
+        }
+
+        g_string_truncate(spec, 0);
+        conv = parse_spec(&p, &length, spec);
+        if (!conv) break;
+        if (n >= rec->nargs || !strchr("diuxXocpfFeEgGaAs", conv)) {
+            g_string_append_len(out, pct, p - pct); // 인자 없음: 형식을 그대로
+            continue;
+        }
+
+        switch (conv) {
+        case 'd': case 'i':
+            g_string_append(spec, G_GINT64_MODIFIER);
+            g_string_append_c(spec, conv);
+            g_string_append_printf(out, spec->str, rec->args[n].i);
+            break;
+        case 'u': case 'x': case 'X': case 'o':
+            g_string_append(spec, G_GINT64_MODIFIER);
+            g_string_append_c(spec, conv);
+            g_string_append_printf(out, spec->str, rec->args[n].u);
+            break;
+        case 'c':
+            g_string_append_c(spec, conv);
+            g_string_append_printf(out, spec->str, (gint)rec->args[n].i);
+            break;
+        case 'p':
+            g_string_append_c(spec, conv);
+            g_string_append_printf(out, spec->str, (gpointer)(guintptr)rec->args[n].u);
+            break;
+        case 's':
+            g_string_append_c(spec, conv);
+            g_string_append_printf(out, spec->str, rec->text + rec->args[n].text_offset);
+            break;
+        default:
+            if (length == 'L') {
+                g_string_append_c(spec, 'L');
+                g_string_append_c(spec, conv);
+                g_string_append_printf(out, spec->str, rec->args[n].ld);
+            } else {
+                g_string_append_c(spec, conv);
+                g_string_append_printf(out, spec->str, rec->args[n].d);
+            }
+            break;
+        }
+        n++;
+    }
+    g_string_free(spec, TRUE);
+}
+
+// 📌 모든 ring을 비워서 출력 (flush 스레드, 또는 종료 후 호출 스레드)
+static void drain_rings(void) {
+    GString *out = g_string_new(NULL), *err = g_string_new(NULL);
+    gsize exited_dropped = 0;
+
+    g_mutex_lock(&rings_lock);
+    for (guint i = 0; rings && i < rings->len;) {
+        RingLogThread *ring = g_ptr_array_index(rings, i);
+        guint head = ring->head, tail = g_atomic_int_get(&ring->tail);
+        gboolean exited = g_atomic_int_get(&ring->exited);
+
+        for (; head != tail; head++) {
+            const RingLogRecord *rec = &ring->records[head % RING_LOG_CAPACITY];
+            format_record(rec->flags & RING_LOG_STDERR ? err : out, rec);
+        }
+        g_atomic_int_set(&ring->head, head);
+
+        if (exited && head == g_atomic_int_get(&ring->tail)) {
+            // 끝난 스레드의 ring: 통계를 넘겨받고 해제
+            total_written += g_atomic_pointer_get(&ring->written);
+            exited_dropped += g_atomic_pointer_get(&ring->dropped);
+            g_ptr_array_remove_index_fast(rings, i);
+            g_free(ring);
+            continue;
+        }
+        i++;
+    }
+    total_dropped += exited_dropped;
+    g_mutex_unlock(&rings_lock);
+
+    if (out->len) {
+        fwrite(out->str, 1, out->len, stdout);
+        fflush(stdout);
+    }
+    if (err->len) {
+        fwrite(err->str, 1, err->len, stderr);
+        fflush(stderr);
+    }
+    if (exited_dropped)
+        fprintf(stderr, "[LOG] ring이 가득 차서 기록 %" G_GSIZE_FORMAT "개 버림\n", exited_dropped);
+    g_string_free(out, TRUE);
+    g_string_free(err, TRUE);
+}
+
+// 📌 살아 있는 스레드의 drop 수를 가져와 보고 (flush 스레드)
+static void collect_drops(void) {
+    gsize dropped = 0;
+
+    g_mutex_lock(&rings_lock);
+    for (guint i = 0; rings && i < rings->len; i++) {
+        RingLogThread *ring = g_ptr_array_index(rings, i);
+        gsize d = g_atomic_pointer_get(&ring->dropped);
+
+        // 스레드가 증가시킨 만큼만 옮긴다 (ring 쪽 값은 0으로 되돌리지 않고 차이만)
+        if (d) {
+            g_atomic_pointer_add(&ring->dropped, -(gssize)d);
+            dropped += d;
+        }
+    }
+    total_dropped += dropped;
+    g_mutex_unlock(&rings_lock);
+
+    if (dropped) {
+        fprintf(stderr, "[LOG] ring이 가득 차서 기록 %" G_GSIZE_FORMAT "개 버림\n", dropped);
+    }
+}
+
+static gpointer flush_thread_func(gpointer data) {
+    g_mutex_lock(&flush_lock);
+    while (flush_running) {
+        guint64 requested = flush_requested;
+
+        g_mutex_unlock(&flush_lock);
+        drain_rings();
+        collect_drops();
+        g_mutex_lock(&flush_lock);
+
+        flush_done = requested;
+        g_cond_broadcast(&flushed_cond);
+        if (flush_requested == requested && flush_running)
+            g_cond_wait_until(&flush_cond, &flush_lock, g_get_monotonic_time() + RING_LOG_FLUSH_INTERVAL_US);
+    }
+    g_mutex_unlock(&flush_lock);
+    return NULL;
+}
+
+void ring_logger_shutdown(void);
+
+static gpointer start_flush_thread(gpointer data) {
+    rings = g_ptr_array_new();
+    flush_running = TRUE;
+    flush_thread = g_thread_new("ring-logger", flush_thread_func, NULL);
+    atexit(ring_logger_shutdown); // 명시적으로 부르지 않아도 종료 시 남은 기록 출력
+    return NULL;
+}
+
+// 📌 호출 스레드의 ring (처음이면 만들어서 등록, 이때만 락)
+static RingLogThread *get_thread_ring(void) {
+    static GOnce once = G_ONCE_INIT;
+    RingLogThread *ring = g_private_get(&thread_ring);
+
+    if (G_LIKELY(ring)) return ring;
+
+    g_once(&once, start_flush_thread, NULL);
+    ring = g_new0(RingLogThread, 1);
+    g_mutex_lock(&rings_lock);
+    g_ptr_array_add(rings, ring);
+    g_mutex_unlock(&rings_lock);
+    g_private_set(&thread_ring, ring);
+    return ring;
+}
+
+void ring_log(const gchar *fmt, ...) {
+    va_list ap;
+
+    va_start(ap, fmt);
+    ring_log_va(0, fmt, ap);
+    va_end(ap);
+}
+
+void ring_log_error(const gchar *fmt, ...) {
+    va_list ap;
+
+    va_start(ap, fmt);
+    ring_log_va(RING_LOG_STDERR, fmt, ap);
+    va_end(ap);
+}
+
+void ring_log_timed(const gchar *fmt, ...) {
+    va_list ap;
+
+    va_start(ap, fmt);
+    ring_log_va(RING_LOG_TIMED, fmt, ap);
+    va_end(ap);
+}
+
+// 📌 지금까지 쌓인 기록이 출력될 때까지 기다린다 (스트리밍 스레드에서는 부르지 말 것)
+void ring_logger_flush(void) {
+    guint64 target;
+
+    g_mutex_lock(&flush_lock);
+    if (!flush_running) {
+        g_mutex_unlock(&flush_lock);
+        return;
+    }
+    target = ++flush_requested;
+    g_cond_signal(&flush_cond);
+    while (flush_running && flush_done < target) g_cond_wait(&flushed_cond, &flush_lock);
+    g_mutex_unlock(&flush_lock);
+}
+
+// 📌 누적 기록 수 / 버린 수 (대략값)
+void ring_logger_get_stats(guint64 *written, guint64 *dropped) {
+    guint64 w, d;
+
+    g_mutex_lock(&rings_lock);
+    w = total_written;
+    d = total_dropped;
+    for (guint i = 0; rings && i < rings->len; i++) {
+        RingLogThread *ring = g_ptr_array_index(rings, i);
+        w += g_atomic_pointer_get(&ring->written);
+        d += g_atomic_pointer_get(&ring->dropped);
+    }
+    g_mutex_unlock(&rings_lock);
+
+    if (written) *written = w;
+    if (dropped) *dropped = d;
+}
+
+// 📌 flush 스레드를 멈추고 남은 기록 출력 (여러 번 불러도 됨)
+void ring_logger_shutdown(void) {
+    GThread *thread;
+
+    g_mutex_lock(&flush_lock);
+    thread = flush_thread;
+    flush_thread = NULL;
+    flush_running = FALSE;
+    g_cond_broadcast(&flush_cond);
+    g_cond_broadcast(&flushed_cond);
+    g_mutex_unlock(&flush_lock);
+
+    if (thread) g_thread_join(thread);
+    drain_rings(); // 종료 후에 남긴 기록도 여기서 (atexit) 출력
+    collect_drops();
+}
@@ -0,0 +1,370 @@
+// rtcp_feedback.c
+/*
+ * RTCP 피드백으로 Opus 비트레이트 조정
+ *
+ * 송신기가 RTP 옆에서 RTCP를 같이 돌린다:
+ *  - 송출 sink마다 probe로 실제로 나가는 패킷(SSRC, 개수, payload 바이트, 마지막 timestamp)을 세고
+ *    RTCP_INTERVAL_MS마다 SR + SDES(CNAME)를 수신기 RTCP 포트로 보낸다.
+ *  - 수신기(receiver --rtcp)가 보내는 RR에서 우리 SSRC의 report block(fraction lost, jitter, LSR/DLSR)을 읽어
+ *    지금 쓰는 opusenc에 바로 적용한다. bitrate / inband-fec / packet-loss-percentage는 PLAYING 중에도
+ *    바꿀 수 있어서 bin을 다시 만들지 않는다.
+ *
+ * 조정 (RR 하나마다, 손실은 EWMA):
+ *   손실 > LOSS_HIGH (10%)        bitrate × (1 - 손실/2)    혼잡: 크게 줄인다
+ *   jitter > JITTER_HIGH_MS       bitrate × JITTER_BACKOFF  큐가 쌓이는 중
+ *   손실 < LOSS_LOW (2%)          bitrate × INCREASE_STEP   조금씩 올린다
+ *   그 밖                         유지
+ *   범위 [min, max] kbps, 시작 값은 START_BITRATE를 범위로 자른 값
+ *   FEC: 손실 ≥ FEC_ON_LOSS면 inband-fec 켬 + packet-loss-percentage = 손실(올림),
+ *        손실 없는 RR이 FEC_OFF_REPORTS번 이어지면 끔
+ *   RTT: LSR/DLSR로 계산해서 보고만 한다
+ *
+ * 코덱 전환으로 opusenc가 새로 만들어지면 codec_registry가 rtcp_feedback_track_encoder()로 알려 주고
+ * 지금까지 조정된 값을 그 자리에서 넣는다 (전환할 때마다 처음 값으로 돌아가지 않음).
+ * Opus가 아닌 구간에서는 SR/RR만 오가고 조정할 인코더는 없다.
+ *
+ * 포트: RTP 목적지 포트 P에 대해 수신기 RTCP = P+1 (SR 목적지), 송신기 RTCP = P+3 (RR을 받는 곳.
+ *       송신기 쪽 RTP/RTCP 쌍을 P+2/P+3으로 둔다. 같은 호스트에서 수신기 P+1과 겹치지 않게)
+ *
+ * 사용:
+ *   rtcp_feedback_start("127.0.0.1", 5001, 5003, 16, 128);  // bin 만들기 전에 한 번 (main loop 필요)
+ *   rtcp_feedback_attach(sink);                             // 송출 sink마다, RTP 세션 probe 뒤
+ *   rtcp_feedback_track_encoder(element);                   // codec_registry가 만드는 요소마다
+ *   rtcp_feedback_stop();                                   // 종료 시 (요약 출력)
+ */
+#include <gio/gio.h>
+#include <gst/gst.h>
+#include <gst/rtp/gstrtpbuffer.h>
+#include <gst/rtp/gstrtcpbuffer.h>
+#include <string.h>
+
+#define RTCP_INTERVAL_MS 1000
+#define RTCP_MAX_SIZE 1500
+#define NTP_UNIX_OFFSET G_GUINT64_CONSTANT(2208988800) // 1900-01-01 ~ 1970-01-01 (초)
+#define DEFAULT_CLOCK_RATE 48000
+
+#define START_BITRATE 64000
+#define OPUS_MIN_BITRATE 4000
+#define OPUS_MAX_BITRATE 650000
+#define LOSS_SMOOTHING 0.5           // EWMA 가중치 (새 보고)
+#define LOSS_HIGH 0.10
+#define LOSS_LOW 0.02
+#define JITTER_HIGH_MS 30.0
+#define JITTER_BACKOFF 0.85
+#define INCREASE_STEP 1.08
+#define FEC_ON_LOSS 0.01
+#define FEC_OFF_REPORTS 5
+
+static struct {
+    GMutex lock;
+    gboolean running;
+    GSocket *socket;
+    GSocketAddress *peer;         // 수신기 RTCP
+    GSource *read_source;
+    guint sr_timer;
+    gchar *cname;
+
+    // 송출 통계 (sink probe, lock 안에서)
+    gboolean sending;
+    guint32 ssrc;
+    guint32 packets, octets;
+    guint32 last_ts;
+    gint64 last_us;
+    gint clock_rate;
+
+    // 조정 상태
+    guint min_bps, max_bps;
+    guint bitrate;
+    gdouble loss;                 // EWMA, 0~1
+    gboolean fec;
+    guint loss_percent;
+    guint clean_reports;
+    guint reports;
+    GWeakRef encoder;             // 지금 쓰는 opusenc (전환으로 사라지면 NULL)
+} feedback;
+
+// 📌 wall clock → 64비트 NTP 시각
+static guint64 ntp_from_real_us(gint64 real_us) {
+    guint64 sec = real_us / G_USEC_PER_SEC + NTP_UNIX_OFFSET;
+    guint64 frac = ((guint64)(real_us % G_USEC_PER_SEC) << 32) / G_USEC_PER_SEC;
+
+    return (sec << 32) | frac;
+}
+
+static gint read_clock_rate(GstPad *pad) {
+    GstCaps *caps = gst_pad_get_current_caps(pad);
+    gint rate = DEFAULT_CLOCK_RATE;
+
+    if (caps) {
+        if (!gst_structure_get_int(gst_caps_get_structure(caps, 0), "clock-rate", &rate) || rate <= 0)
+            rate = DEFAULT_CLOCK_RATE;
+        gst_caps_unref(caps);
+    }
+    return rate;
+}
+
+// 📌 나가는 패킷 하나를 송출 통계에 (lock 안에서)
+static void count_packet(GstBuffer *buffer, gint clock_rate, gint64 now) {
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+
+    if (!gst_rtp_buffer_map(buffer, GST_MAP_READ, &rtp)) return;
+    if (gst_rtp_buffer_get_ssrc(&rtp) != feedback.ssrc) {
+        // 새 SSRC (clock-rate가 다른 코덱으로 전환): SR 카운터는 SSRC마다 0부터
+        feedback.packets = 0;
+        feedback.octets = 0;
+    }
+    feedback.ssrc = gst_rtp_buffer_get_ssrc(&rtp);
+    feedback.last_ts = gst_rtp_buffer_get_timestamp(&rtp);
+    feedback.packets++;
+    feedback.octets += gst_rtp_buffer_get_payload_len(&rtp);
+    gst_rtp_buffer_unmap(&rtp);
+
+    feedback.last_us = now;
+    feedback.clock_rate = clock_rate;
+    feedback.sending = TRUE;
+}
+
+static GstPadProbeReturn on_sink_input(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    gint *clock_rate = user_data;
+    gint64 now = g_get_monotonic_time();
+
+    if (!*clock_rate) *clock_rate = read_clock_rate(pad);
+
+    g_mutex_lock(&feedback.lock);
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+        GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST(info);
+        guint n = gst_buffer_list_length(list);
+
+        for (guint i = 0; i < n; i++) count_packet(gst_buffer_list_get(list, i), *clock_rate, now);
+    } else {
+        count_packet(GST_PAD_PROBE_INFO_BUFFER(info), *clock_rate, now);
+    }
+    g_mutex_unlock(&feedback.lock);
+    return GST_PAD_PROBE_OK;
+}
+
+// 📌 SR + SDES CNAME (패킷을 하나라도 보낸 뒤부터)
+static gboolean on_sr_timer(gpointer user_data) {
+    GstBuffer *buffer;
+    GstRTCPBuffer rtcp = GST_RTCP_BUFFER_INIT;
+    GstRTCPPacket packet;
+    GstMapInfo map;
+    GError *error = NULL;
+    guint32 ssrc, rtp_ts, packets, octets;
+    gint64 now = g_get_monotonic_time();
+
+    g_mutex_lock(&feedback.lock);
+    if (!feedback.sending) {
+        g_mutex_unlock(&feedback.lock);
+        return G_SOURCE_CONTINUE;
+    }
+    ssrc = feedback.ssrc;
+    rtp_ts = feedback.last_ts + (guint32)((now - feedback.last_us) * feedback.clock_rate / G_USEC_PER_SEC);
+    packets = feedback.packets;
+    octets = feedback.octets;
+    g_mutex_unlock(&feedback.lock);
+
+    buffer = gst_rtcp_buffer_new(RTCP_MAX_SIZE);
+    gst_rtcp_buffer_map(buffer, GST_MAP_READWRITE, &rtcp);
+    gst_rtcp_buffer_add_packet(&rtcp, GST_RTCP_TYPE_SR, &packet);
+    gst_rtcp_packet_sr_set_sender_info(&packet, ssrc, ntp_from_real_us(g_get_real_time()), rtp_ts, packets, octets);
+    gst_rtcp_buffer_add_packet(&rtcp, GST_RTCP_TYPE_SDES, &packet);
+    gst_rtcp_packet_sdes_add_item(&packet, ssrc);
+    gst_rtcp_packet_sdes_add_entry(&packet, GST_RTCP_SDES_CNAME, strlen(feedback.cname),
+                                   (const guint8 *)feedback.cname);
+    gst_rtcp_buffer_unmap(&rtcp); // 버퍼 크기가 실제 길이로 줄어든다
+
+    gst_buffer_map(buffer, &map, GST_MAP_READ);
+    if (g_socket_send_to(feedback.socket, feedback.peer, (const gchar *)map.data, map.size, NULL, &error) < 0) {
+        g_printerr("[RTCP] SR 전송 실패: %s\n", error->message);
+        g_error_free(error);
+    }
+    gst_buffer_unmap(buffer, &map);
+    gst_buffer_unref(buffer);
+    return G_SOURCE_CONTINUE;
+}
+
+// 📌 조정된 값을 인코더에 (PLAYING 중에 바꿀 수 있는 속성만)
+static void apply_to_encoder(GstElement *encoder) {
+    g_object_set(encoder,
+                 "bitrate", (gint)feedback.bitrate,
+                 "inband-fec", feedback.fec,
+                 "packet-loss-percentage", (gint)feedback.loss_percent,
+                 NULL);
+}
+
+// 📌 우리 SSRC에 대한 report block 하나로 비트레이트/FEC 조정
+static void handle_report_block(guint8 fraction_lost, guint32 jitter, guint32 lsr, guint32 dlsr) {
+    gdouble loss = fraction_lost / 256.0;
+    gdouble jitter_ms, target;
+    gchar rtt[32] = "-";
+    GstElement *encoder;
+
+    g_mutex_lock(&feedback.lock);
+    jitter_ms = jitter * 1000.0 / (feedback.clock_rate ? feedback.clock_rate : DEFAULT_CLOCK_RATE);
+    if (lsr) {
+        // NTP 가운데 32비트 (1/65536 초 단위)
+        guint32 now_mid = (guint32)(ntp_from_real_us(g_get_real_time()) >> 16);
+        g_snprintf(rtt, sizeof(rtt), "%.1f ms", (guint32)(now_mid - lsr - dlsr) * 1000.0 / 65536.0);
+    }
+
+    feedback.loss = feedback.reports ? LOSS_SMOOTHING * loss + (1.0 - LOSS_SMOOTHING) * feedback.loss : loss;
+    feedback.reports++;
+
+    target = feedback.bitrate;
+    if (feedback.loss > LOSS_HIGH) target *= 1.0 - feedback.loss / 2;
+    else if (jitter_ms > JITTER_HIGH_MS) target *= JITTER_BACKOFF;
+    else if (feedback.loss < LOSS_LOW) target *= INCREASE_STEP;
+    feedback.bitrate = (guint)CLAMP(target, feedback.min_bps, feedback.max_bps);
+
+    if (feedback.loss >= FEC_ON_LOSS) {
+        feedback.fec = TRUE;
+        feedback.clean_reports = 0;
+    } else if (fraction_lost == 0 && ++feedback.clean_reports >= FEC_OFF_REPORTS) {
+        feedback.fec = FALSE;
+    }
+    feedback.loss_percent = feedback.fec ? MIN((guint)(feedback.loss * 100 + 0.999), 100) : 0;
+
+    encoder = g_weak_ref_get(&feedback.encoder);
+    if (encoder) {
+        apply_to_encoder(encoder);
+        gst_object_unref(encoder);
+    }
+
+    g_print("[RTCP] RR: 손실 %.1f%% (평균 %.1f%%), jitter %.2f ms, RTT %s → %u kbps, FEC %s (%u%%)%s\n",
+            loss * 100, feedback.loss * 100, jitter_ms, rtt, feedback.bitrate / 1000,
+            feedback.fec ? "켬" : "끔", feedback.loss_percent, encoder ? "" : " (Opus 구간 아님)");
+    g_mutex_unlock(&feedback.lock);
+}
+
+// 📌 받은 compound RTCP에서 우리 SSRC의 report block 찾기 (RR, SR 모두)
+static void handle_rtcp(const guint8 *data, gsize size) {
+    GstBuffer *buffer = gst_rtcp_buffer_new_copy_data((gpointer)data, size);
+    GstRTCPBuffer rtcp = GST_RTCP_BUFFER_INIT;
+    GstRTCPPacket packet;
+    guint32 ssrc;
+
+    if (!gst_rtcp_buffer_validate_reduced(buffer)) {
+        gst_buffer_unref(buffer);
+        return;
+    }
+    g_mutex_lock(&feedback.lock);
+    ssrc = feedback.ssrc;
+    g_mutex_unlock(&feedback.lock);
+
+    gst_rtcp_buffer_map(buffer, GST_MAP_READ, &rtcp);
+    for (gboolean more = gst_rtcp_buffer_get_first_packet(&rtcp, &packet); more;
+         more = gst_rtcp_packet_move_to_next(&packet)) {
+        GstRTCPType type = gst_rtcp_packet_get_type(&packet);
+
+        if (type != GST_RTCP_TYPE_RR && type != GST_RTCP_TYPE_SR) continue;
+        for (guint i = 0; i < gst_rtcp_packet_get_rb_count(&packet); i++) {
+            guint32 block_ssrc, highest_seq, jitter, lsr, dlsr;
+            guint8 fraction_lost;
+            gint32 packets_lost;
+
+            gst_rtcp_packet_get_rb(&packet, i, &block_ssrc, &fraction_lost, &packets_lost, &highest_seq,
+                                   &jitter, &lsr, &dlsr);
+            if (block_ssrc == ssrc) handle_report_block(fraction_lost, jitter, lsr, dlsr);
+        }
+    }
+    gst_rtcp_buffer_unmap(&rtcp);
+    gst_buffer_unref(buffer);
+}
+
+static gboolean on_rtcp_readable(GSocket *socket, GIOCondition condition, gpointer user_data) {
+    guint8 data[RTCP_MAX_SIZE];
+    gssize size;
+
+    while ((size = g_socket_receive(socket, (gchar *)data, sizeof(data), NULL, NULL)) > 0)
+        handle_rtcp(data, size);
+    return G_SOURCE_CONTINUE;
+}
+
+// 📌 RTCP 소켓 열기 + SR 타이머 (bitrate 범위는 kbps)
+gboolean rtcp_feedback_start(const gchar *host, guint peer_port, guint local_port, guint min_kbps, guint max_kbps) {
+    GInetAddress *address = g_inet_address_new_from_string(host);
+    GSocketAddress *local;
+    GError *error = NULL;
+
+    if (!address) {
+        g_printerr("[RTCP] 주소는 IP로: %s\n", host);
+        return FALSE;
+    }
+    feedback.peer = g_inet_socket_address_new(address, peer_port);
+    g_object_unref(address);
+
+    feedback.socket = g_socket_new(G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM, G_SOCKET_PROTOCOL_UDP, &error);
+    if (feedback.socket) {
+        local = g_inet_socket_address_new_from_string("0.0.0.0", local_port);
+        if (!g_socket_bind(feedback.socket, local, TRUE, &error)) g_clear_object(&feedback.socket);
+        g_object_unref(local);
+    }
+    if (!feedback.socket) {
+        g_printerr("[RTCP] 포트 %u 열기 실패: %s\n", local_port, error->message);
+        g_error_free(error);
+        g_clear_object(&feedback.peer);
+        return FALSE;
+    }
+    g_socket_set_blocking(feedback.socket, FALSE);
+
+    feedback.min_bps = CLAMP(MIN(min_kbps, max_kbps) * 1000, OPUS_MIN_BITRATE, OPUS_MAX_BITRATE);
+    feedback.max_bps = CLAMP(MAX(min_kbps, max_kbps) * 1000, OPUS_MIN_BITRATE, OPUS_MAX_BITRATE);
+    feedback.bitrate = CLAMP(START_BITRATE, feedback.min_bps, feedback.max_bps);
+    feedback.cname = g_strdup_printf("gst_sender@%s", g_get_host_name());
+    g_weak_ref_init(&feedback.encoder, NULL);
+
+    feedback.read_source = g_socket_create_source(feedback.socket, G_IO_IN, NULL);
+    g_source_set_callback(feedback.read_source, (GSourceFunc)on_rtcp_readable, NULL, NULL);
+    g_source_attach(feedback.read_source, NULL);
+    feedback.sr_timer = g_timeout_add(RTCP_INTERVAL_MS, on_sr_timer, NULL);
+    feedback.running = TRUE;
+
+    g_print("[RTCP] SR → %s:%u, RR ← :%u, Opus bitrate %u~%u kbps (시작 %u)\n", host, peer_port, local_port,
+            feedback.min_bps / 1000, feedback.max_bps / 1000, feedback.bitrate / 1000);
+    return TRUE;
+}
+
+// 📌 송출 sink에 통계 probe (rtp_continuity probe 뒤에 붙여야 실제 SSRC/timestamp가 보인다)
+void rtcp_feedback_attach(GstElement *sink) {
+    GstPad *pad;
+
+    if (!feedback.running) return;
+    pad = gst_element_get_static_pad(sink, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+                      on_sink_input, g_new0(gint, 1), g_free);
+    gst_object_unref(pad);
+}
+
+// 📌 새로 만든 요소가 opusenc면 조정 대상으로 삼고 지금 값을 넣는다
+void rtcp_feedback_track_encoder(GstElement *element) {
+    GstElementFactory *factory;
+
+    if (!feedback.running || !element) return;
+    factory = gst_element_get_factory(element);
+    if (!factory || g_strcmp0(GST_OBJECT_NAME(factory), "opusenc") != 0) return;
+
+    g_mutex_lock(&feedback.lock);
+    g_weak_ref_set(&feedback.encoder, element);
+    apply_to_encoder(element);
+    g_mutex_unlock(&feedback.lock);
+}
+
+// 📌 종료 (요약 출력)
+void rtcp_feedback_stop(void) {
+    if (!feedback.running) return;
+    feedback.running = FALSE;
+
+    g_source_remove(feedback.sr_timer);
+    g_source_destroy(feedback.read_source);
+    g_source_unref(feedback.read_source);
+    g_socket_close(feedback.socket, NULL);
+    g_clear_object(&feedback.socket);
+    g_clear_object(&feedback.peer);
+    g_weak_ref_clear(&feedback.encoder);
+
+    g_print("[RTCP] RR %u개, 마지막 bitrate %u kbps, 평균 손실 %.1f%%, FEC %s\n", feedback.reports,
+            feedback.bitrate / 1000, feedback.loss * 100, feedback.fec ? "켬" : "끔");
+    g_free(feedback.cname);
+    feedback.cname = NULL;
+}
@@ -0,0 +1,167 @@
+// rtp_continuity.c
+/*
+ * 코덱 전환을 넘어 하나로 이어지는 RTP 세션
+ *
+ * 전환마다 payloader(와 basic_sender는 udpsink까지)가 새로 만들어지면 SSRC, seqnum 시작값,
+ * timestamp 시작값이 매번 새로 뽑혀서 수신기는 다른 스트림으로 보고 jitterbuffer를 비운다.
+ * 여기서는 송출 sink 입력 pad에 probe를 달아 나가는 패킷의 RTP 헤더를 세션 값으로 다시 쓴다.
+ *
+ *   SSRC     : clock-rate가 같은 동안 하나 (처음 만들 때 무작위). SSRC 하나의 timestamp는 한 clock으로
+ *              세야 하므로(RFC 3550) clock-rate가 다른 코덱(E-AC3 rtpgstpay 90 kHz 등)으로 바뀌면
+ *              새 SSRC와 새 timestamp 시작값으로 간다. sink는 첫 패킷 때 정한 SSRC를 끝까지 쓴다
+ *   seqnum   : 세션 카운터에서 패킷마다 +1 (이전 bin이 비워지는 동안 섞여 나가도 겹치지 않음)
+ *   timestamp: sink(=payloader)마다 첫 패킷에서 보정값을 정해 둔다.
+ *              같은 SSRC의 이전 패킷 timestamp + 그 뒤 흐른 시간 × clock-rate 가 되도록 하고,
+ *              이후 그 sink의 패킷은 같은 보정값 (payloader가 만든 간격은 그대로)
+ *
+ * payload type은 건드리지 않는다. 코덱마다 다른 PT는 bin을 만들 때 payloader "pt"로 정한다.
+ *
+ * 사용:
+ *   RtpContinuity *rtp = rtp_continuity_new();
+ *   rtp_continuity_attach(rtp, sink);      // 새 bin의 송출 sink마다
+ *   rtp_continuity_unref(rtp);             // attach된 probe가 각자 참조를 잡고 있다
+ */
+#include <gst/gst.h>
+#include <gst/rtp/gstrtpbuffer.h>
+
+#define DEFAULT_CLOCK_RATE 48000
+
+typedef struct _RtpContinuity {
+    GMutex lock;
+    guint32 ssrc;         // 지금 SSRC (새로 시작하는 sink가 쓴다)
+    guint16 next_seq;
+    guint32 ts_base;      // 지금 SSRC의 첫 패킷 timestamp
+    gboolean started;     // 지금 SSRC로 패킷을 하나라도 내보냈는지
+    gint clock_rate;      // 지금 SSRC의 clock-rate
+    guint32 last_ts;      // 지금 SSRC로 마지막으로 내보낸 timestamp
+    gint64 last_us;       // 그때의 monotonic 시각
+} RtpContinuity;
+
+// sink 하나(= payloader 하나)의 보정 상태
+typedef struct {
+    RtpContinuity *session;
+    gboolean started;
+    guint32 ssrc;         // 첫 패킷 때 정한 SSRC
+    guint32 ts_delta;     // 원래 timestamp에 더하는 값 (mod 2^32)
+    gint clock_rate;
+} RtpOutput;
+
+RtpContinuity *rtp_continuity_new(void) {
+    RtpContinuity *c = g_atomic_rc_box_new0(RtpContinuity);
+
+    g_mutex_init(&c->lock);
+    c->ssrc = g_random_int();
+    c->next_seq = g_random_int_range(0, 0x10000);
+    c->ts_base = g_random_int();
+    return c;
+}
+
+static void rtp_continuity_clear(gpointer data) {
+    RtpContinuity *c = data;
+    g_mutex_clear(&c->lock);
+}
+
+void rtp_continuity_unref(RtpContinuity *c) {
+    if (c) g_atomic_rc_box_release_full(c, rtp_continuity_clear);
+}
+
+guint32 rtp_continuity_get_ssrc(RtpContinuity *c) {
+    return c->ssrc;
+}
+
+static void rtp_output_free(gpointer data) {
+    RtpOutput *out = data;
+
+    rtp_continuity_unref(out->session);
+    g_free(out);
+}
+
+// 📌 sink 입력 caps의 clock-rate (첫 패킷 때 한 번)
+static gint read_clock_rate(GstPad *pad) {
+    GstCaps *caps = gst_pad_get_current_caps(pad);
+    gint rate = DEFAULT_CLOCK_RATE;
+
+    if (caps) {
+        if (!gst_structure_get_int(gst_caps_get_structure(caps, 0), "clock-rate", &rate) || rate <= 0)
+            rate = DEFAULT_CLOCK_RATE;
+        gst_caps_unref(caps);
+    }
+    return rate;
+}
+
+// 📌 패킷 하나의 SSRC/seqnum/timestamp를 세션 값으로 (buffer는 쓰기 가능해야 함)
+static void rewrite_packet(RtpOutput *out, GstBuffer *buffer, gint64 now) {
+    RtpContinuity *c = out->session;
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+    guint32 ts;
+
+    if (!gst_rtp_buffer_map(buffer, GST_MAP_READWRITE, &rtp)) return;
+    ts = gst_rtp_buffer_get_timestamp(&rtp);
+
+    g_mutex_lock(&c->lock);
+    if (!out->started) {
+        guint32 expected;
+
+        if (c->started && c->clock_rate != out->clock_rate) {
+            // 다른 clock으로 센 timestamp는 같은 SSRC에 섞을 수 없다: 새 SSRC로 시작
+            guint32 old_ssrc = c->ssrc;
+
+            do c->ssrc = g_random_int(); while (c->ssrc == old_ssrc);
+            c->ts_base = g_random_int();
+            c->started = FALSE;
+            g_print("[RTP] clock-rate %d → %d Hz: 새 SSRC 0x%08x\n", c->clock_rate, out->clock_rate, c->ssrc);
+        }
+        expected = c->ts_base;
+        if (c->started)
+            expected = c->last_ts + (guint32)((now - c->last_us) * out->clock_rate / G_USEC_PER_SEC);
+        out->ssrc = c->ssrc;
+        out->ts_delta = expected - ts;
+        out->started = TRUE;
+        c->clock_rate = out->clock_rate;
+    }
+    ts += out->ts_delta;
+    gst_rtp_buffer_set_ssrc(&rtp, out->ssrc);
+    gst_rtp_buffer_set_seq(&rtp, c->next_seq++);
+    gst_rtp_buffer_set_timestamp(&rtp, ts);
+    if (out->ssrc == c->ssrc) {
+        // 비워지는 중인 이전 SSRC의 패킷은 지금 SSRC의 기준 시각을 건드리지 않는다
+        c->last_ts = ts;
+        c->last_us = now;
+        c->started = TRUE;
+    }
+    g_mutex_unlock(&c->lock);
+
+    gst_rtp_buffer_unmap(&rtp);
+}
+
+static GstPadProbeReturn on_sink_input(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    RtpOutput *out = user_data;
+    gint64 now = g_get_monotonic_time();
+
+    if (!out->started && !out->clock_rate) out->clock_rate = read_clock_rate(pad);
+
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+        GstBufferList *list = gst_buffer_list_make_writable(GST_PAD_PROBE_INFO_BUFFER_LIST(info));
+        guint n = gst_buffer_list_length(list);
+
+        for (guint i = 0; i < n; i++) rewrite_packet(out, gst_buffer_list_get_writable(list, i), now);
+        GST_PAD_PROBE_INFO_DATA(info) = list;
+    } else {
+        GstBuffer *buffer = gst_buffer_make_writable(GST_PAD_PROBE_INFO_BUFFER(info));
+
+        rewrite_packet(out, buffer, now);
+        GST_PAD_PROBE_INFO_DATA(info) = buffer;
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+// 📌 송출 sink에 세션을 붙인다 (sink가 살아 있는 동안 세션 참조 유지)
+void rtp_continuity_attach(RtpContinuity *c, GstElement *sink) {
+    GstPad *pad = gst_element_get_static_pad(sink, "sink");
+    RtpOutput *out = g_new0(RtpOutput, 1);
+
+    out->session = g_atomic_rc_box_acquire(c);
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+                      on_sink_input, out, rtp_output_free);
+    gst_object_unref(pad);
+}
@@ -0,0 +1,124 @@
+// stream_metrics.c
+/*
+ * 스트림(세션)별 실시간 지표 공용 모듈
+ *
+ * pipeline 쪽(스트리밍 스레드, 생산자)은 자기 스트림의 카운터를 원자 연산으로 올리기만 하고,
+ * 모니터(gui_monitor.c 등)는 따로 도는 스레드에서 스냅샷을 읽어 간다.
+ * 락은 스트림 등록과 스냅샷 목록 복사에만 쓰므로 스트리밍 경로는 모니터를 기다리지 않는다.
+ *
+ *  누적 카운터: bytes, packets, switches, drops, cpu_ns → 모니터가 이전 스냅샷과의 차이로 속도 계산
+ *  현재 값    : 마지막 전환 간격, 종단 지연(sink 도착 - appsrc 입력), appsrc 대기 바이트, 현재 포맷
+ *
+ * 사용:
+ *   StreamMetrics *m = stream_metrics_register("session-0-src");  // 같은 이름이면 같은 객체
+ *   stream_metrics_add_packets(m, 1, 1200);                      // sink probe에서
+ *   stream_metrics_record_switch(m, gap_us);
+ *   guint n = stream_metrics_snapshot(snaps, G_N_ELEMENTS(snaps));  // 모니터 스레드에서
+ */
+#include <gst/gst.h>
+#include <string.h>
+#include <time.h>
+
+#include "stream_metrics.h"
+
+struct _StreamMetrics {
+    gchar name[STREAM_METRICS_NAME_LEN];
+
+    volatile gsize bytes, packets;   // sink에 들어간 RTP 패킷
+    volatile gsize switches;
+    volatile gsize drops;            // 생산자가 건너뛴 tick / push 실패
+    volatile gsize cpu_ns;           // 스트림 전용 스레드(생산자, 송출 스트리밍 스레드) CPU 시간
+
+    volatile gsize last_switch_gap_us;
+    volatile gsize latency_us;
+    volatile gsize queue_bytes;
+    volatile gint is_ac3;
+};
+
+// 등록된 스트림 (프로세스가 끝날 때까지 유지, 같은 이름은 재사용)
+static GMutex registry_lock;
+static GPtrArray *registry = NULL;
+
+// 📌 이름으로 스트림 지표를 가져온다 (없으면 등록)
+StreamMetrics *stream_metrics_register(const gchar *name) {
+    StreamMetrics *m = NULL;
+
+    g_mutex_lock(&registry_lock);
+    if (!registry) registry = g_ptr_array_new();
+    for (guint i = 0; i < registry->len; i++) {
+        StreamMetrics *entry = g_ptr_array_index(registry, i);
+        if (strncmp(entry->name, name, STREAM_METRICS_NAME_LEN - 1) == 0) {
+            m = entry;
+            break;
+        }
+    }
+    if (!m) {
+        m = g_new0(StreamMetrics, 1);
+        g_strlcpy(m->name, name, sizeof(m->name));
+        g_ptr_array_add(registry, m);
+    }
+    g_mutex_unlock(&registry_lock);
+    return m;
+}
+
+void stream_metrics_add_packets(StreamMetrics *m, guint packets, gsize bytes) {
+    g_atomic_pointer_add(&m->packets, packets);
+    g_atomic_pointer_add(&m->bytes, bytes);
+}
+
+void stream_metrics_record_switch(StreamMetrics *m, guint64 gap_us) {
+    g_atomic_pointer_add(&m->switches, 1);
+    g_atomic_pointer_set(&m->last_switch_gap_us, gap_us);
+}
+
+void stream_metrics_add_drops(StreamMetrics *m, guint drops) {
+    g_atomic_pointer_add(&m->drops, drops);
+}
+
+void stream_metrics_add_cpu(StreamMetrics *m, guint64 cpu_ns) {
+    g_atomic_pointer_add(&m->cpu_ns, cpu_ns);
+}
+
+void stream_metrics_set_latency(StreamMetrics *m, guint64 latency_us) {
+    g_atomic_pointer_set(&m->latency_us, latency_us);
+}
+
+void stream_metrics_set_queue_level(StreamMetrics *m, guint64 bytes) {
+    g_atomic_pointer_set(&m->queue_bytes, bytes);
+}
+
+void stream_metrics_set_format(StreamMetrics *m, gboolean is_ac3) {
+    g_atomic_int_set(&m->is_ac3, is_ac3);
+}
+
+// 📌 호출 스레드의 CPU 시간 (ns). 스트림 전용 스레드에서 구간 CPU를 재는 데 쓴다
+guint64 stream_metrics_thread_cpu_ns(void) {
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+    return (guint64)ts.tv_sec * G_GUINT64_CONSTANT(1000000000) + ts.tv_nsec;
+}
+
+// 📌 등록된 스트림 최대 max개의 현재 값 (모니터 스레드에서). 돌려준 개수만큼 out에 채운다
+guint stream_metrics_snapshot(StreamMetricsSnapshot *out, guint max) {
+    guint n = 0;
+
+    g_mutex_lock(&registry_lock);
+    for (guint i = 0; registry && i < registry->len && n < max; i++, n++) {
+        StreamMetrics *m = g_ptr_array_index(registry, i);
+        StreamMetricsSnapshot *s = &out[n];
+
+        memcpy(s->name, m->name, sizeof(s->name));
+        s->bytes = g_atomic_pointer_get(&m->bytes);
+        s->packets = g_atomic_pointer_get(&m->packets);
+        s->switches = g_atomic_pointer_get(&m->switches);
+        s->drops = g_atomic_pointer_get(&m->drops);
+        s->cpu_ns = g_atomic_pointer_get(&m->cpu_ns);
+        s->last_switch_gap_us = g_atomic_pointer_get(&m->last_switch_gap_us);
+        s->latency_us = g_atomic_pointer_get(&m->latency_us);
+        s->queue_bytes = g_atomic_pointer_get(&m->queue_bytes);
+        s->is_ac3 = g_atomic_int_get(&m->is_ac3);
+    }
+    g_mutex_unlock(&registry_lock);
+    return n;
+}
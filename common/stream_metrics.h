@@ -0,0 +1,33 @@
+// stream_metrics.h
+/*
+ * 스트림(세션)별 실시간 지표 (stream_metrics.c) 선언
+ */
+#ifndef STREAM_METRICS_H
+#define STREAM_METRICS_H
+
+#include <glib.h>
+
+#define STREAM_METRICS_NAME_LEN 32
+
+typedef struct _StreamMetrics StreamMetrics;
+
+// 모니터가 읽어 가는 한 시점의 값
+typedef struct {
+    gchar name[STREAM_METRICS_NAME_LEN];
+    guint64 bytes, packets, switches, drops, cpu_ns;
+    guint64 last_switch_gap_us, latency_us, queue_bytes;
+    gboolean is_ac3;
+} StreamMetricsSnapshot;
+
+StreamMetrics *stream_metrics_register(const gchar *name);
+void stream_metrics_add_packets(StreamMetrics *m, guint packets, gsize bytes);
+void stream_metrics_record_switch(StreamMetrics *m, guint64 gap_us);
+void stream_metrics_add_drops(StreamMetrics *m, guint drops);
+void stream_metrics_add_cpu(StreamMetrics *m, guint64 cpu_ns);
+void stream_metrics_set_latency(StreamMetrics *m, guint64 latency_us);
+void stream_metrics_set_queue_level(StreamMetrics *m, guint64 bytes);
+void stream_metrics_set_format(StreamMetrics *m, gboolean is_ac3);
+guint64 stream_metrics_thread_cpu_ns(void);
+guint stream_metrics_snapshot(StreamMetricsSnapshot *out, guint max);
+
+#endif // STREAM_METRICS_H
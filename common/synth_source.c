@@ -0,0 +1,189 @@
+// synth_source.c
+/*
+ * 부하 테스트용 합성 신호 생성기 (S16LE interleaved)
+ *
+ *  - sine  : 4096포인트 wavetable + 32비트 위상 누산기 + 선형 보간 (샘플당 libm 호출 없음)
+ *  - sweep : start_hz → end_hz 선형 주파수 스윕 (끝나면 처음부터 반복)
+ *  - noise : xorshift32 백색 잡음
+ *  - ac3   : AC3처럼 보이는 sync frame 연속 (올바른 syncinfo + crc1/crc2, 내용은 잡음)
+ *
+ * 위상/스윕 위치/잡음 상태는 synth_source_fill() 호출 사이에 이어지므로 버퍼 경계에서 클릭이 없다.
+ */
+#include <glib.h>
+#include <math.h>
+#include <string.h>
+
+#include "synth_source.h"
+
+#define WAVETABLE_BITS 12
+#define WAVETABLE_SIZE (1 << WAVETABLE_BITS)
+#define FRAC_BITS (32 - WAVETABLE_BITS)
+
+// AC3 burst: 48kHz, 192kbps (frmsizecod 20) → 768바이트 프레임
+#define SYNTH_AC3_FRMSIZECOD 20
+#define SYNTH_AC3_BSID 8
+#define SYNTH_AC3_ACMOD 2
+
+typedef struct _SynthSource {
+    SynthWaveform waveform;
+    guint rate;
+    guint channels;
+    gint32 gain_q15;      // 진폭 (Q15)
+
+    guint32 phase;        // 위상 누산기 (2^32 = 한 주기)
+    guint32 step;         // 샘플당 위상 증가량
+
+    // sweep: 샘플마다 step이 step_delta만큼 변함
+    guint32 step_start;
+    gint64 step_delta_q16;
+    gint64 step_acc_q16;
+    guint64 sweep_samples, sweep_pos;
+
+    guint32 noise_state;
+} SynthSource;
+
+// wavetable[WAVETABLE_SIZE]는 보간용으로 [0]을 한 번 더 둔다
+static gint16 wavetable[WAVETABLE_SIZE + 1];
+
+// ../common/ac3_frame.c
+guint ac3_frame_size(const guint8 *data, gsize len);
+void ac3_write_frame_crcs(guint8 *frame, guint frame_size);
+
+static void wavetable_init(void) {
+    static gsize initialized = 0;
+
+    if (g_once_init_enter(&initialized)) {
+        // libm은 테이블 만들 때 한 번만
+        for (guint i = 0; i < WAVETABLE_SIZE; i++)
+            wavetable[i] = (gint16)(32767.0 * sin(2 * G_PI * i / WAVETABLE_SIZE));
+        wavetable[WAVETABLE_SIZE] = wavetable[0];
+        g_once_init_leave(&initialized, 1);
+    }
+}
+
+static guint32 freq_to_step(gdouble freq_hz, guint rate) {
+    return (guint32)(freq_hz / rate * 4294967296.0);
+}
+
+// 📌 amplitude: 0.0 ~ 1.0
+SynthSource *synth_source_new(SynthWaveform waveform, guint rate, guint channels,
+                              gdouble freq_hz, gdouble amplitude) {
+    SynthSource *synth = g_new0(SynthSource, 1);
+
+    wavetable_init();
+    synth->waveform = waveform;
+    synth->rate = rate;
+    synth->channels = channels;
+    synth->gain_q15 = (gint32)(CLAMP(amplitude, 0.0, 1.0) * 32768.0);
+    synth->step = synth->step_start = freq_to_step(freq_hz, rate);
+    synth->noise_state = 0x9E3779B9u ^ GPOINTER_TO_UINT(synth);
+    return synth;
+}
+
+// 📌 sweep 설정: seconds 동안 start_hz → end_hz, 이후 반복
+void synth_source_set_sweep(SynthSource *synth, gdouble start_hz, gdouble end_hz, gdouble seconds) {
+    guint32 end_step = freq_to_step(end_hz, synth->rate);
+
+    synth->step = synth->step_start = freq_to_step(start_hz, synth->rate);
+    synth->sweep_samples = MAX((guint64)(seconds * synth->rate), 1);
+    synth->sweep_pos = 0;
+    synth->step_acc_q16 = 0;
+    synth->step_delta_q16 = ((gint64)end_step - (gint64)synth->step_start) * 65536 / (gint64)synth->sweep_samples;
+}
+
+static inline guint32 xorshift32(guint32 *state) {
+    guint32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static inline gint16 wavetable_lookup(guint32 phase) {
+    guint32 index = phase >> FRAC_BITS;
+    gint32 frac = (phase >> (FRAC_BITS - 15)) & 0x7FFF; // 상위 15비트 소수부
+    gint32 a = wavetable[index], b = wavetable[index + 1];
+    return (gint16)(a + (((b - a) * frac) >> 15));
+}
+
+static void fill_pcm(SynthSource *synth, gint16 *out, guint frames) {
+    guint32 phase = synth->phase;
+    const guint channels = synth->channels;
+    const gint32 gain = synth->gain_q15;
+
+    switch (synth->waveform) {
+    case SYNTH_SINE: {
+        const guint32 step = synth->step;
+        for (guint i = 0; i < frames; i++) {
+            gint16 v = (gint16)((wavetable_lookup(phase) * gain) >> 15);
+            for (guint c = 0; c < channels; c++) out[i * channels + c] = v;
+            phase += step;
+        }
+        break;
+    }
+    case SYNTH_SWEEP:
+        for (guint i = 0; i < frames; i++) {
+            gint16 v = (gint16)((wavetable_lookup(phase) * gain) >> 15);
+            for (guint c = 0; c < channels; c++) out[i * channels + c] = v;
+            phase += synth->step;
+
+            synth->step_acc_q16 += synth->step_delta_q16;
+            synth->step = synth->step_start + (guint32)(synth->step_acc_q16 >> 16);
+            if (++synth->sweep_pos >= synth->sweep_samples) {
+                synth->sweep_pos = 0;
+                synth->step_acc_q16 = 0;
+                synth->step = synth->step_start;
+            }
+        }
+        break;
+    case SYNTH_NOISE:
+        for (guint i = 0; i < frames; i++) {
+            gint16 v = (gint16)(((gint32)(gint16)(xorshift32(&synth->noise_state) >> 16) * gain) >> 15);
+            for (guint c = 0; c < channels; c++) out[i * channels + c] = v;
+        }
+        break;
+    default:
+        break;
+    }
+
+    synth->phase = phase;
+}
+
+// 📌 AC3처럼 보이는 프레임으로 채운다 (남는 꼬리는 0). 디코딩 가능한 오디오는 아니다.
+static void fill_ac3_burst(SynthSource *synth, guint8 *data, gsize size) {
+    guint8 header[6] = { 0x0B, 0x77, 0, 0, (0 << 6) | SYNTH_AC3_FRMSIZECOD, SYNTH_AC3_BSID << 3 };
+    guint frame_size = ac3_frame_size(header, sizeof(header));
+    gsize offset = 0;
+
+    while (offset + frame_size <= size) {
+        guint8 *frame = data + offset;
+
+        for (guint i = 6; i + 4 <= frame_size; i += 4) {
+            guint32 r = xorshift32(&synth->noise_state);
+            memcpy(frame + i, &r, 4);
+        }
+        memcpy(frame, header, sizeof(header));
+        frame[6] = SYNTH_AC3_ACMOD << 5;
+        ac3_write_frame_crcs(frame, frame_size);
+        offset += frame_size;
+    }
+    memset(data + offset, 0, size - offset);
+}
+
+// 📌 data를 size 바이트만큼 채운다 (PCM은 프레임 단위, 꼬리 바이트는 0)
+void synth_source_fill(SynthSource *synth, guint8 *data, gsize size) {
+    gsize frame_bytes = synth->channels * sizeof(gint16);
+    guint frames = size / frame_bytes;
+
+    if (synth->waveform == SYNTH_AC3_BURST) {
+        fill_ac3_burst(synth, data, size);
+        return;
+    }
+
+    fill_pcm(synth, (gint16 *)data, frames);
+    memset(data + frames * frame_bytes, 0, size - frames * frame_bytes);
+}
+
+void synth_source_free(SynthSource *synth) {
+    g_free(synth);
+}
@@ -0,0 +1,28 @@
+// synth_source.h
+/*
+ * 부하 테스트용 합성 신호 생성기 (synth_source.c) 선언
+ */
+#ifndef SYNTH_SOURCE_H
+#define SYNTH_SOURCE_H
+
+#include <glib.h>
+
+// SYNTH_AC3_BURST가 만드는 프레임 하나 (48 kHz, 192 kbps → 768바이트, 1536 샘플)
+#define SYNTH_AC3_FRAME_BYTES 768
+
+typedef enum {
+    SYNTH_SINE,
+    SYNTH_SWEEP,
+    SYNTH_NOISE,
+    SYNTH_AC3_BURST
+} SynthWaveform;
+
+typedef struct _SynthSource SynthSource;
+
+SynthSource *synth_source_new(SynthWaveform waveform, guint rate, guint channels,
+                              gdouble freq_hz, gdouble amplitude);
+void synth_source_set_sweep(SynthSource *synth, gdouble start_hz, gdouble end_hz, gdouble seconds);
+void synth_source_fill(SynthSource *synth, guint8 *data, gsize size);
+void synth_source_free(SynthSource *synth);
+
+#endif // SYNTH_SOURCE_H
@@ -0,0 +1,227 @@
+// thread_topology.c
+/*
+ * 송신 pipeline 스레드 구성 (queue 경계) 공용 모듈
+ *
+ * 단계: 입력(capture) → 변환(convert/resample) → 인코딩(encoder/pay) → 송출(sink)
+ * 경계마다 queue를 넣으면 그 뒤 단계는 queue의 스트리밍 스레드에서 돈다.
+ *
+ *  TOPOLOGY_SINGLE_THREAD : queue 없음 (모든 단계가 appsrc 스트리밍 스레드, 기존 동작)
+ *  TOPOLOGY_LOW_LATENCY   : 입력 뒤에만 짧은 leaky queue (20ms). 인코딩이 늦어지면
+ *                           지연을 쌓지 않고 오래된 버퍼를 버린다. 생산자는 막히지 않는다.
+ *  TOPOLOGY_MAX_THROUGHPUT: 세 경계 모두 큰 non-leaky queue. 단계마다 스레드가 따로 돌고,
+ *                           가득 차면 생산자 쪽으로 backpressure (버리지 않음).
+ *
+ * 단계별 queue 채움 정도를 보면 어디서 막히는지 알 수 있다:
+ *   어떤 경계 queue가 늘 차 있으면 그 뒤 단계가 병목, 모두 비어 있으면 입력(생산자)이 병목.
+ *
+ * 사용:
+ *   thread_topology_configure(TOPOLOGY_MAX_THROUGHPUT);  // bin 만들기 전에 한 번
+ *   GstElement *entry = thread_topology_entry(bin, convert);      // ghost pad 대상
+ *   thread_topology_link(bin, resample, encoder, STAGE_ENCODE);
+ *   thread_topology_report();                            // 단계별 queue 채움 / overrun
+ *   thread_topology_get_latency(level_ns);               // 단계별 queue 대기 시간 (모니터용)
+ */
+#include <gst/gst.h>
+#include <string.h>
+
+#include "thread_topology.h"
+
+// ../common/codec_registry.c (factory는 등록부가 미리 찾아 둔다)
+GstElement *codec_registry_make_element(const gchar *factory_name);
+
+#define TOPOLOGY_STAGE_KEY "topology-stage"
+
+typedef struct {
+    gboolean enabled;
+    const gchar *leaky;     // "no" / "upstream" / "downstream"
+    guint64 max_time_ns;
+} StagePolicy;
+
+static const StagePolicy profiles[][STAGE_COUNT] = {
+    [TOPOLOGY_SINGLE_THREAD] = {
+        { FALSE }, { FALSE }, { FALSE }
+    },
+    [TOPOLOGY_LOW_LATENCY] = {
+        { TRUE, "downstream", 20 * GST_MSECOND }, { FALSE }, { FALSE }
+    },
+    [TOPOLOGY_MAX_THROUGHPUT] = {
+        { TRUE, "no", 500 * GST_MSECOND },
+        { TRUE, "no", 200 * GST_MSECOND },
+        { TRUE, "no", 200 * GST_MSECOND }
+    },
+};
+
+static const gchar *profile_names[] = { "single", "low-latency", "throughput" };
+static const gchar *stage_names[STAGE_COUNT] = { "convert", "encode", "send" };
+
+static TopologyProfile current_profile = TOPOLOGY_SINGLE_THREAD;
+
+// 살아 있는 경계 queue 목록 (bin이 교체되면 weak ref로 빠진다)
+static GMutex registry_lock;
+static GPtrArray *registry = NULL;
+
+// 단계별 통계 (스트리밍 스레드에서 증가, 보고할 때 0으로)
+static volatile gint stage_overruns[STAGE_COUNT];
+static volatile gint stage_underruns[STAGE_COUNT];
+
+static void on_queue_finalized(gpointer data, GObject *queue) {
+    g_mutex_lock(&registry_lock);
+    g_ptr_array_remove_fast(registry, queue);
+    g_mutex_unlock(&registry_lock);
+}
+
+static void on_overrun(GstElement *queue, gpointer user_data) {
+    g_atomic_int_inc(&stage_overruns[GPOINTER_TO_INT(user_data)]);
+}
+
+static void on_underrun(GstElement *queue, gpointer user_data) {
+    g_atomic_int_inc(&stage_underruns[GPOINTER_TO_INT(user_data)]);
+}
+
+// 📌 프로필 설정 (bin을 만들기 전에 호출, 이미 만든 bin은 그대로)
+void thread_topology_configure(TopologyProfile profile) {
+    current_profile = profile;
+    g_print("[TOPOLOGY] 스레드 구성: %s\n", profile_names[profile]);
+}
+
+// 📌 "single" / "low-latency" / "throughput" → 프로필
+gboolean thread_topology_parse(const gchar *name, TopologyProfile *profile) {
+    for (guint i = 0; i < G_N_ELEMENTS(profile_names); i++) {
+        if (g_strcmp0(name, profile_names[i]) == 0) {
+            *profile = i;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+// 📌 stage 경계 queue 생성 (현재 프로필에 그 경계가 없으면 NULL)
+static GstElement *make_stage_queue(TopologyStage stage) {
+    const StagePolicy *policy = &profiles[current_profile][stage];
+    GstElement *queue;
+
+    if (!policy->enabled) return NULL;
+
+    queue = codec_registry_make_element("queue");
+    if (!queue) return NULL;
+
+    // 시간으로만 제한 (버퍼 크기는 포맷마다 다르므로 개수/바이트 제한은 끈다)
+    g_object_set(queue,
+                 "max-size-time", policy->max_time_ns,
+                 "max-size-buffers", 0,
+                 "max-size-bytes", 0,
+                 NULL);
+    gst_util_set_object_arg(G_OBJECT(queue), "leaky", policy->leaky);
+
+    g_object_set_data(G_OBJECT(queue), TOPOLOGY_STAGE_KEY, GINT_TO_POINTER(stage));
+    g_signal_connect(queue, "overrun", G_CALLBACK(on_overrun), GINT_TO_POINTER(stage));
+    g_signal_connect(queue, "underrun", G_CALLBACK(on_underrun), GINT_TO_POINTER(stage));
+
+    g_mutex_lock(&registry_lock);
+    if (!registry) registry = g_ptr_array_new();
+    g_ptr_array_add(registry, queue);
+    g_mutex_unlock(&registry_lock);
+    g_object_weak_ref(G_OBJECT(queue), on_queue_finalized, NULL);
+    return queue;
+}
+
+// 📌 src → [stage 경계 queue] → dest 연결 (src/dest는 이미 bin 안에 있어야 함)
+gboolean thread_topology_link(GstBin *bin, GstElement *src, GstElement *dest, TopologyStage stage) {
+    GstElement *queue = make_stage_queue(stage);
+
+    if (!queue) return gst_element_link(src, dest);
+
+    gst_bin_add(bin, queue);
+    return gst_element_link_many(src, queue, dest, NULL);
+}
+
+// 📌 bin 입구 (입력 → 변환 경계). first 앞에 queue가 있으면 queue를, 없으면 first를 돌려준다
+// 돌려받은 element의 sink pad를 bin ghost pad 대상으로 쓴다.
+GstElement *thread_topology_entry(GstBin *bin, GstElement *first) {
+    GstElement *queue = make_stage_queue(STAGE_CONVERT);
+
+    if (!queue) return first;
+
+    gst_bin_add(bin, queue);
+    if (!gst_element_link(queue, first)) {
+        g_printerr("[TOPOLOGY] 입구 queue 연결 실패\n");
+        gst_bin_remove(bin, queue);
+        return first;
+    }
+    return queue;
+}
+
+// 📌 queue 하나의 채움 비율 (0.0 ~ 1.0, 시간 기준)
+static gdouble queue_fill(GstElement *queue) {
+    guint64 level_ns = 0, max_ns = 0;
+
+    g_object_get(queue, "current-level-time", &level_ns, "max-size-time", &max_ns, NULL);
+    if (max_ns == 0) return 0.0;
+    return MIN((gdouble)level_ns / max_ns, 1.0);
+}
+
+// 📌 단계별 queue 대기 시간 (그 경계 queue들의 current-level-time 평균, queue가 없으면 0)
+// 모니터 스레드에서 불러도 된다 (스트리밍 스레드는 registry_lock을 잡지 않음)
+void thread_topology_get_latency(guint64 level_ns[STAGE_COUNT]) {
+    guint count[STAGE_COUNT] = { 0 };
+
+    memset(level_ns, 0, sizeof(guint64) * STAGE_COUNT);
+    g_mutex_lock(&registry_lock);
+    for (guint i = 0; registry && i < registry->len; i++) {
+        GstElement *queue = g_ptr_array_index(registry, i);
+        gint stage = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(queue), TOPOLOGY_STAGE_KEY));
+        guint64 level = 0;
+
+        g_object_get(queue, "current-level-time", &level, NULL);
+        level_ns[stage] += level;
+        count[stage]++;
+    }
+    g_mutex_unlock(&registry_lock);
+
+    for (gint stage = 0; stage < STAGE_COUNT; stage++)
+        if (count[stage]) level_ns[stage] /= count[stage];
+}
+
+// 📌 단계별 queue 채움 (평균/최대)과 지난 보고 이후 overrun/underrun, 병목 추정
+void thread_topology_report(void) {
+    guint count[STAGE_COUNT] = { 0 };
+    gdouble sum[STAGE_COUNT] = { 0 }, peak[STAGE_COUNT] = { 0 };
+    gint bound = -1;
+    gdouble bound_fill = 0.5; // 평균 50% 이상 차 있는 경계만 병목 후보
+
+    if (current_profile == TOPOLOGY_SINGLE_THREAD) return;
+
+    g_mutex_lock(&registry_lock);
+    for (guint i = 0; registry && i < registry->len; i++) {
+        GstElement *queue = g_ptr_array_index(registry, i);
+        gint stage = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(queue), TOPOLOGY_STAGE_KEY));
+        gdouble fill = queue_fill(queue);
+
+        count[stage]++;
+        sum[stage] += fill;
+        peak[stage] = MAX(peak[stage], fill);
+    }
+    g_mutex_unlock(&registry_lock);
+
+    for (gint stage = 0; stage < STAGE_COUNT; stage++) {
+        gint overruns = g_atomic_int_get(&stage_overruns[stage]);
+        gint underruns = g_atomic_int_get(&stage_underruns[stage]);
+        gdouble avg;
+
+        g_atomic_int_add(&stage_overruns[stage], -overruns);
+        g_atomic_int_add(&stage_underruns[stage], -underruns);
+
+        if (!profiles[current_profile][stage].enabled) continue;
+        avg = count[stage] ? sum[stage] / count[stage] : 0.0;
+        g_print("[TOPOLOGY] %-7s 앞 queue %u개: 평균 %3.0f%%, 최대 %3.0f%%, overrun %d, underrun %d\n",
+                stage_names[stage], count[stage], avg * 100.0, peak[stage] * 100.0, overruns, underruns);
+
+        // 가장 뒤쪽의 꽉 찬 경계 바로 뒤 단계가 실제 병목 (그 앞 queue들은 backpressure로 찬다)
+        if (avg >= bound_fill || overruns > 0) bound = stage;
+    }
+
+    if (bound >= 0)
+        g_print("[TOPOLOGY] 병목 추정: %s 단계 (앞 queue가 차 있음)\n", stage_names[bound]);
+    else
+        g_print("[TOPOLOGY] 병목 추정: 입력 (모든 queue 여유)\n");
+}
@@ -0,0 +1,31 @@
+// thread_topology.h
+/*
+ * 송신 pipeline 스레드 구성 (thread_topology.c) 선언
+ */
+#ifndef THREAD_TOPOLOGY_H
+#define THREAD_TOPOLOGY_H
+
+#include <gst/gst.h>
+
+typedef enum {
+    TOPOLOGY_SINGLE_THREAD,
+    TOPOLOGY_LOW_LATENCY,
+    TOPOLOGY_MAX_THROUGHPUT
+} TopologyProfile;
+
+// 각 값은 "그 단계 앞" 경계
+typedef enum {
+    STAGE_CONVERT, // 입력 → 변환
+    STAGE_ENCODE,  // 변환 → 인코딩
+    STAGE_SEND,    // 인코딩/페이로드 → 송출
+    STAGE_COUNT
+} TopologyStage;
+
+void thread_topology_configure(TopologyProfile profile);
+gboolean thread_topology_parse(const gchar *name, TopologyProfile *profile);
+gboolean thread_topology_link(GstBin *bin, GstElement *src, GstElement *dest, TopologyStage stage);
+GstElement *thread_topology_entry(GstBin *bin, GstElement *first);
+void thread_topology_get_latency(guint64 level_ns[STAGE_COUNT]);
+void thread_topology_report(void);
+
+#endif // THREAD_TOPOLOGY_H
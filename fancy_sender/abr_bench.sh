@@ -0,0 +1,90 @@
+#!/bin/bash
+# abr_bench.sh
+# 손실 링크 흉내(receiver --drop-probability)에서 RTCP 기반 Opus bitrate/FEC 조정 확인 (loopback)
+# 손실이 클수록 마지막 bitrate가 낮고 FEC가 켜져 있어야 한다. 손실 0이면 최대로 올라가고 FEC는 꺼진다
+# 그렇지 않으면 (또는 RR을 하나도 못 받으면) 0이 아닌 값으로 끝난다
+#
+# 사용: bash abr_bench.sh [실행 시간 초] [bitrate 범위 kbps] [손실 확률 목록, 오름차순]
+#       bash abr_bench.sh 20 16:128 "0 0.05 0.2"
+
+DURATION=${1:-20}
+RANGE=${2:-16:128}
+LOSSES=${3:-0 0.02 0.05 0.2}
+PORT=5000
+SENDER=./gst_sender
+RECEIVER=./receiver
+
+for BIN in "$SENDER" "$RECEIVER"; do
+    if [ ! -x "$BIN" ]; then
+        echo "$BIN 없음 (make 먼저)" >&2
+        exit 1
+    fi
+done
+
+field() {
+    echo "$1" | tr ' ' '\n' | grep "^$2=" | cut -d= -f2
+}
+
+# 수치 비교 (손실 확률은 소수)
+less_than() {
+    awk -v a="$1" -v b="$2" 'BEGIN { exit !(a < b) }'
+}
+
+printf "%-8s %10s %10s %12s %s\n" "drop" "dropped" "jb_lost" "reports" "마지막 조정"
+
+fail=0
+first_loss= first_rate= first_fec=
+prev_rate=
+
+for LOSS in $LOSSES; do
+    rx_out=$(mktemp)
+    tx_out=$(mktemp)
+    $RECEIVER -p $PORT --null --rtcp --drop-probability "$LOSS" -d "$DURATION" -r 0 > "$rx_out" 2>/dev/null &
+    rx=$!
+    sleep 1
+    # timeout은 SIGTERM: gst_sender가 main loop를 끝내고 정리한다. 파일 출력은 줄 단위로
+    timeout "$((DURATION - 2))" stdbuf -oL $SENDER --dest "127.0.0.1:$PORT" --abr "$RANGE" > "$tx_out" 2>&1
+    wait $rx
+    line=$(grep '^RESULT' "$rx_out")
+    last=$(grep '^\[RTCP\] RR:' "$tx_out" | tail -n 1 | sed 's/^\[RTCP\] RR: //')
+    printf "%-8s %10s %10s %12s %s\n" "$LOSS" "$(field "$line" dropped)" "$(field "$line" lost)" \
+        "$(grep -c '^\[RTCP\] RR:' "$tx_out")" "${last:-(RR 없음)}"
+    rm -f "$rx_out" "$tx_out"
+
+    rate=$(echo "$last" | sed -n 's/.*→ \([0-9]*\) kbps.*/\1/p')
+    fec=$(echo "$last" | grep -oE 'FEC (켬|끔)' | cut -d' ' -f2)
+    if [ -z "$rate" ] || [ -z "$fec" ]; then
+        echo "실패: 손실 $LOSS에서 RR 조정 결과 없음" >&2
+        fail=1
+        continue
+    fi
+    if [ -n "$prev_rate" ] && [ "$rate" -gt "$prev_rate" ]; then
+        echo "실패: 손실 $LOSS에서 bitrate가 올라감 (${prev_rate} → ${rate} kbps)" >&2
+        fail=1
+    fi
+    if [ -z "$first_rate" ]; then
+        first_loss=$LOSS first_rate=$rate first_fec=$fec
+    fi
+    prev_rate=$rate last_loss=$LOSS last_rate=$rate last_fec=$fec
+done
+
+# 가장 낮은 손실 → 가장 높은 손실: bitrate는 내려가고 FEC는 켜져야 한다
+if [ -n "$first_rate" ] && [ -n "$last_rate" ] && less_than "$first_loss" "$last_loss"; then
+    if [ "$last_rate" -ge "$first_rate" ]; then
+        echo "실패: 손실 $first_loss → $last_loss에서 bitrate가 내려가지 않음 (${first_rate} → ${last_rate} kbps)" >&2
+        fail=1
+    fi
+    if [ "$last_fec" != "켬" ]; then
+        echo "실패: 손실 $last_loss에서 FEC가 꺼져 있음" >&2
+        fail=1
+    fi
+    if ! less_than 0 "$first_loss" && [ "$first_fec" != "끔" ]; then
+        echo "실패: 손실 0에서 FEC가 켜져 있음" >&2
+        fail=1
+    fi
+fi
+
+if [ $fail -ne 0 ]; then
+    exit 1
+fi
+echo "OK: 손실이 늘수록 bitrate가 내려가고 FEC가 켜짐"
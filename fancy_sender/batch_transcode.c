@@ -0,0 +1,481 @@
+// batch_transcode.c
+/*
+ * 일괄(오프라인) 변환: PCM 파일을 코덱 프레임 경계로 나눠 여러 코어에서 동시에 인코딩하고,
+ * 순서대로 이어 붙여 하나의 결과(인코딩 파일 또는 RTP dump)로 만든다.
+ * send_from_file.c처럼 UDP로 실시간 송출하지 않으므로 실시간보다 몇 배 빠른지가 그대로 보인다.
+ *
+ *  입력     : 48 kHz stereo S16LE raw (audio_convert.sh로 만든 .pcm). mmap으로 읽고 버퍼는 그 메모리를 감싸기만 한다
+ *  분할     : segment 길이는 코덱 프레임(Opus 960, AC3 1536, AAC 1024 샘플)의 배수.
+ *             각 segment는 앞 PREROLL_FRAMES 프레임을 더 넣어 인코더 상태(look-ahead, 비트 예약)를 데우고
+ *             PTS가 segment 시작보다 앞인 출력은 버린다 (경계마다 인코더가 처음부터 시작하는 잡음 방지)
+ *  인코딩   : segment마다 appsrc ! audioconvert ! audioresample ! encoder(../common/codec_registry.c) ! appsink,
+ *             GThreadPool에서 -j개 동시
+ *  이어 붙임: main 스레드가 segment 0, 1, 2 ... 가 끝나는 대로 appsrc ! [muxer | payloader] 로 흘린다.
+ *             PTS가 입력 위치에서 온 절대 시각이라 이어 붙인 결과도 연속이다
+ *
+ * 보고: 미디어 길이 / 걸린 시간 = 실시간 배수, 코어당 배수, 프로세스 CPU 사용(코어 수)
+ *   RESULT codec=opus jobs=8 segments=60 media_s=600.0 wall_s=9.84 realtime_x=61.0 per_core_x=7.6 cpu_cores=7.7 ...
+ *
+ * 사용:
+ *   ./batch_transcode -i input.pcm -c opus -o out.ogg           # 코어 수만큼 동시에
+ *   ./batch_transcode -i input.pcm -c ac3 -o out.ac3 -j 4
+ *   ./batch_transcode -i input.pcm -c opus --rtp out.rtpdump    # RTP 패킷 (rtpdump 형식, 원래 시각 포함)
+ *   ./batch_transcode -i input.pcm -c aac -o out.m4a --scan     # 1, 2, 4 ... 코어 수별 배속 표
+ */
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+
+#define PCM_RATE 48000
+#define PCM_BYTES_PER_SAMPLE (2 * 2)       // stereo S16LE
+#define PUSH_CHUNK_SAMPLES (PCM_RATE / 10) // appsrc에 넣는 단위 (0.1초, 메모리는 감싸기만)
+#define PREROLL_FRAMES 4
+#define MIN_SEGMENT_FRAMES 50
+#define DEFAULT_SEGMENT_SECONDS 10
+
+// ../common/codec_registry.c
+typedef struct _CodecDescriptor CodecDescriptor;
+void codec_registry_init(void);
+void codec_registry_dump(void);
+const CodecDescriptor *codec_registry_lookup(const gchar *name);
+GstElement *codec_registry_make_encoder(const CodecDescriptor *codec);
+GstElement *codec_registry_make_payloader(const CodecDescriptor *codec);
+const gchar *codec_get_label(const CodecDescriptor *codec);
+gboolean codec_has_encoded_input(const CodecDescriptor *codec);
+GstCaps *codec_get_input_caps(const CodecDescriptor *codec);
+guint codec_get_frame_samples(const CodecDescriptor *codec);
+const gchar *codec_get_container(const CodecDescriptor *codec);
+
+typedef struct {
+    guint index;
+    guint64 start, end;       // 샘플 위치 [start, end)
+    guint64 preroll_start;    // 인코더를 데우기 시작하는 위치
+    GPtrArray *buffers;       // 인코딩된 프레임 (segment 구간만)
+    GstCaps *caps;
+    gboolean done, failed;
+} Segment;
+
+static const CodecDescriptor *codec;
+static const guint8 *input;          // mmap된 PCM
+static guint64 input_samples;
+
+static GMutex done_lock;
+static GCond done_cond;
+
+// RTP dump 출력 (appsink 스트리밍 스레드에서만)
+static FILE *rtp_file;
+static guint64 rtp_packets;
+
+// 명령행 옵션
+static gchar *input_path = NULL;
+static gchar *codec_name = NULL;
+static gchar *output_path = NULL;
+static gchar *rtp_path = NULL;
+static gint jobs = 0;
+static gint segment_seconds = DEFAULT_SEGMENT_SECONDS;
+static gboolean scan = FALSE;
+static gboolean list_codecs = FALSE;
+
+static GOptionEntry entries[] = {
+    { "input", 'i', 0, G_OPTION_ARG_FILENAME, &input_path, "입력 PCM (48 kHz stereo S16LE)", "FILE" },
+    { "codec", 'c', 0, G_OPTION_ARG_STRING, &codec_name, "코덱 (기본 opus, 목록은 --list-codecs)", "NAME" },
+    { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output_path, "인코딩 결과 파일 (Opus는 Ogg, AAC는 MP4, AC3는 그대로)", "FILE" },
+    { "rtp", 0, 0, G_OPTION_ARG_FILENAME, &rtp_path, "RTP 패킷으로 (rtpdump 형식)", "FILE" },
+    { "jobs", 'j', 0, G_OPTION_ARG_INT, &jobs, "동시 인코딩 수 (기본 코어 수)", "N" },
+    { "segment-seconds", 's', 0, G_OPTION_ARG_INT, &segment_seconds, "segment 길이 초 (기본 10)", "SEC" },
+    { "scan", 0, 0, G_OPTION_ARG_NONE, &scan, "1, 2, 4 ... 코어 수까지 각각 실행해서 배속 비교", NULL },
+    { "list-codecs", 0, 0, G_OPTION_ARG_NONE, &list_codecs, "등록된 코덱 목록", NULL },
+    { NULL }
+};
+
+static inline GstClockTime sample_time(guint64 samples) {
+    return gst_util_uint64_scale(samples, GST_SECOND, PCM_RATE);
+}
+
+// 📌 pipeline에 넣기 전에 실패했을 때 만들어 둔 요소 해제
+static void unref_unowned(GstElement *element) {
+    if (element) gst_object_unref(element);
+}
+
+// 📌 worker: segment 하나 인코딩 (appsrc ! audioconvert ! audioresample ! encoder ! appsink)
+// 입력 caps가 인코더 입력 형식과 달라도 송출 bin(codec_registry_make_bin)처럼 변환이 맞춘다
+static void encode_segment(gpointer data, gpointer user_data) {
+    Segment *seg = data;
+    GstElement *pipeline = gst_pipeline_new(NULL);
+    GstElement *src = gst_element_factory_make("appsrc", NULL);
+    GstElement *convert = gst_element_factory_make("audioconvert", NULL);
+    GstElement *resample = gst_element_factory_make("audioresample", NULL);
+    GstElement *encoder = codec_registry_make_encoder(codec);
+    GstElement *sink = gst_element_factory_make("appsink", NULL);
+    GstClockTime keep_from = sample_time(seg->start) - (seg->start ? sample_time(codec_get_frame_samples(codec)) / 2 : 0);
+    GstSample *sample;
+    GstMessage *msg;
+    GstBus *bus;
+
+    seg->buffers = g_ptr_array_new_with_free_func((GDestroyNotify)gst_buffer_unref);
+    if (!pipeline || !src || !convert || !resample || !encoder || !sink) {
+        g_printerr("[BATCH] segment %u 요소 생성 실패\n", seg->index);
+        unref_unowned(src);
+        unref_unowned(convert);
+        unref_unowned(resample);
+        unref_unowned(encoder);
+        unref_unowned(sink);
+        seg->failed = TRUE;
+        goto done;
+    }
+
+    // 입력을 모두 한 번에 넣으므로 appsrc 대기열 제한 없음 (메모리는 mmap을 감싼 것뿐)
+    g_object_set(src,
+                 "caps", codec_get_input_caps(codec),
+                 "format", GST_FORMAT_TIME,
+                 "max-bytes", (guint64)0,
+                 "block", FALSE,
+                 NULL);
+    g_object_set(sink, "sync", FALSE, "max-buffers", 0, NULL);
+
+    gst_bin_add_many(GST_BIN(pipeline), src, convert, resample, encoder, sink, NULL);
+    if (!gst_element_link_many(src, convert, resample, encoder, sink, NULL) ||
+        gst_element_set_state(pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+        g_printerr("[BATCH] segment %u pipeline 시작 실패\n", seg->index);
+        seg->failed = TRUE;
+        goto done;
+    }
+
+    for (guint64 pos = seg->preroll_start; pos < seg->end; pos += PUSH_CHUNK_SAMPLES) {
+        guint64 n = MIN(PUSH_CHUNK_SAMPLES, seg->end - pos);
+        gsize size = n * PCM_BYTES_PER_SAMPLE;
+        GstBuffer *buffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY,
+                                                        (gpointer)(input + pos * PCM_BYTES_PER_SAMPLE),
+                                                        size, 0, size, NULL, NULL);
+
+        GST_BUFFER_PTS(buffer) = sample_time(pos);
+        GST_BUFFER_DURATION(buffer) = sample_time(pos + n) - sample_time(pos);
+        if (gst_app_src_push_buffer(GST_APP_SRC(src), buffer) != GST_FLOW_OK) break;
+    }
+    gst_app_src_end_of_stream(GST_APP_SRC(src));
+
+    // look-ahead로 앞에 넣은 구간의 출력은 버린다 (앞 segment가 이미 냈다)
+    while ((sample = gst_app_sink_pull_sample(GST_APP_SINK(sink)))) {
+        GstBuffer *buffer = gst_sample_get_buffer(sample);
+
+        if (!seg->caps) seg->caps = gst_caps_ref(gst_sample_get_caps(sample));
+        if (!GST_BUFFER_PTS_IS_VALID(buffer) || GST_BUFFER_PTS(buffer) >= keep_from)
+            g_ptr_array_add(seg->buffers, gst_buffer_ref(buffer));
+        gst_sample_unref(sample);
+    }
+
+    bus = gst_element_get_bus(pipeline);
+    msg = gst_bus_pop_filtered(bus, GST_MESSAGE_ERROR);
+    if (msg) {
+        GError *err = NULL;
+        gst_message_parse_error(msg, &err, NULL);
+        g_printerr("[BATCH] segment %u 에러: %s\n", seg->index, err->message);
+        g_error_free(err);
+        gst_message_unref(msg);
+        seg->failed = TRUE;
+    }
+    gst_object_unref(bus);
+
+done:
+    if (pipeline) {
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(pipeline);
+    }
+    g_mutex_lock(&done_lock);
+    seg->done = TRUE;
+    g_cond_broadcast(&done_cond);
+    g_mutex_unlock(&done_lock);
+}
+
+// 📌 RTP 패킷 하나를 rtpdump(rtpplay 1.0) 레코드로: 길이, 패킷 길이, 시작 후 ms, 패킷
+static GstFlowReturn on_rtp_packet(GstAppSink *sink, gpointer user_data) {
+    GstSample *sample = gst_app_sink_pull_sample(sink);
+    GstBuffer *buffer;
+    GstMapInfo map;
+    guint8 header[8];
+    guint32 offset_ms;
+
+    if (!sample) return GST_FLOW_EOS;
+    buffer = gst_sample_get_buffer(sample);
+    if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+        offset_ms = GST_BUFFER_PTS_IS_VALID(buffer) ? GST_BUFFER_PTS(buffer) / GST_MSECOND : 0;
+        GST_WRITE_UINT16_BE(header, map.size + sizeof(header));
+        GST_WRITE_UINT16_BE(header + 2, map.size);
+        GST_WRITE_UINT32_BE(header + 4, offset_ms);
+        fwrite(header, 1, sizeof(header), rtp_file);
+        fwrite(map.data, 1, map.size, rtp_file);
+        gst_buffer_unmap(buffer, &map);
+        rtp_packets++;
+    }
+    gst_sample_unref(sample);
+    return GST_FLOW_OK;
+}
+
+static gboolean write_rtpdump_header(FILE *fp) {
+    guint8 header[16] = { 0 };
+    gint64 now = g_get_real_time();
+
+    // 파일 헤더 + RD_hdr (시작 시각, 원래 송신 주소/포트: 127.0.0.1:5000)
+    fprintf(fp, "#!rtpplay1.0 127.0.0.1/5000\n");
+    GST_WRITE_UINT32_BE(header, now / G_USEC_PER_SEC);
+    GST_WRITE_UINT32_BE(header + 4, now % G_USEC_PER_SEC);
+    GST_WRITE_UINT32_BE(header + 8, 0x7f000001);
+    GST_WRITE_UINT16_BE(header + 12, 5000);
+    return fwrite(header, 1, sizeof(header), fp) == sizeof(header);
+}
+
+// 📌 이어 붙이는 pipeline: appsrc ! [muxer] ! filesink, 또는 appsrc ! payloader ! appsink(rtpdump)
+static GstElement *make_stitch_pipeline(GstCaps *caps, GstElement **out_src) {
+    GstElement *pipeline = gst_pipeline_new("stitch");
+    GstElement *src = gst_element_factory_make("appsrc", NULL);
+    GstElement *middle = NULL, *sink;
+    const gchar *container = codec_get_container(codec);
+
+    if (rtp_path) {
+        GstAppSinkCallbacks callbacks = { NULL, NULL, on_rtp_packet };
+
+        middle = codec_registry_make_payloader(codec);
+        sink = gst_element_factory_make("appsink", NULL);
+        if (sink) {
+            g_object_set(sink, "sync", FALSE, NULL);
+            gst_app_sink_set_callbacks(GST_APP_SINK(sink), &callbacks, NULL, NULL);
+        }
+        rtp_file = fopen(rtp_path, "wb");
+        if (!rtp_file || !write_rtpdump_header(rtp_file)) {
+            g_printerr("[BATCH] %s 쓰기 실패\n", rtp_path);
+            goto unowned;
+        }
+        rtp_packets = 0;
+    } else {
+        if (container) middle = gst_element_factory_make(container, NULL);
+        sink = gst_element_factory_make(output_path ? "filesink" : "fakesink", NULL);
+        if (sink && output_path) g_object_set(sink, "location", output_path, NULL);
+        if (sink) g_object_set(sink, "sync", FALSE, NULL);
+    }
+    if (!pipeline || !src || !sink || ((rtp_path || container) && !middle)) {
+        g_printerr("[BATCH] 이어 붙이기 요소 생성 실패\n");
+        goto unowned;
+    }
+
+    // 이어 붙이기는 순서대로 하나씩: 대기열이 차면 main 스레드가 기다린다
+    g_object_set(src, "caps", caps, "format", GST_FORMAT_TIME, "block", TRUE, NULL);
+    gst_bin_add_many(GST_BIN(pipeline), src, sink, NULL);
+    if (middle) gst_bin_add(GST_BIN(pipeline), middle);
+    if (middle ? !gst_element_link_many(src, middle, sink, NULL) : !gst_element_link(src, sink)) {
+        g_printerr("[BATCH] 이어 붙이기 연결 실패\n");
+        gst_object_unref(pipeline); // 요소들은 pipeline과 함께 해제
+        return NULL;
+    }
+
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    *out_src = src;
+    return pipeline;
+
+unowned:
+    // 아직 pipeline에 넣지 않은 요소들 (rtp_file은 run_transcode 끝에서 닫는다)
+    unref_unowned(src);
+    unref_unowned(middle);
+    unref_unowned(sink);
+    unref_unowned(pipeline);
+    return NULL;
+}
+
+static gdouble process_cpu_seconds(void) {
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// 📌 한 번 실행: n_jobs개 동시 인코딩 → 순서대로 이어 붙임 → RESULT 한 줄
+static gboolean run_transcode(guint n_jobs) {
+    guint frame = MAX(codec_get_frame_samples(codec), 1);
+    guint64 seg_samples = (guint64)segment_seconds * PCM_RATE;
+    guint64 per_job = (input_samples + n_jobs - 1) / n_jobs;
+    guint n_segments, i;
+    Segment *segments;
+    GThreadPool *pool;
+    GstElement *stitch = NULL, *stitch_src = NULL;
+    guint64 frames = 0, bytes = 0;
+    gboolean ok = TRUE;
+    gint64 start_us = g_get_monotonic_time();
+    gdouble start_cpu = process_cpu_seconds();
+    gdouble wall_s, media_s, cpu_s;
+
+    // 코어보다 segment가 적으면 놀게 되므로 짧은 파일은 코어 수로 나눈다 (프레임 배수, 최소 길이 유지)
+    seg_samples = MIN(seg_samples, per_job);
+    seg_samples = MAX(seg_samples / frame, MIN_SEGMENT_FRAMES) * frame;
+    n_segments = (input_samples + seg_samples - 1) / seg_samples;
+
+    segments = g_new0(Segment, n_segments);
+    pool = g_thread_pool_new(encode_segment, NULL, n_jobs, FALSE, NULL);
+    for (i = 0; i < n_segments; i++) {
+        Segment *seg = &segments[i];
+
+        seg->index = i;
+        seg->start = i * seg_samples;
+        seg->end = MIN(seg->start + seg_samples, input_samples);
+        seg->preroll_start = seg->start > (guint64)PREROLL_FRAMES * frame ? seg->start - PREROLL_FRAMES * frame : 0;
+        g_thread_pool_push(pool, seg, NULL);
+    }
+
+    // 끝난 순서가 아니라 segment 순서대로 이어 붙인다 (앞이 끝나기를 기다리는 동안 뒤는 계속 인코딩)
+    for (i = 0; i < n_segments && ok; i++) {
+        Segment *seg = &segments[i];
+
+        g_mutex_lock(&done_lock);
+        while (!seg->done) g_cond_wait(&done_cond, &done_lock);
+        g_mutex_unlock(&done_lock);
+
+        if (seg->failed || !seg->caps) {
+            ok = FALSE;
+            break;
+        }
+        if (!stitch && !(stitch = make_stitch_pipeline(seg->caps, &stitch_src))) {
+            ok = FALSE;
+            break;
+        }
+
+        for (guint b = 0; b < seg->buffers->len; b++) {
+            GstBuffer *buffer = gst_buffer_ref(g_ptr_array_index(seg->buffers, b));
+
+            // segment 경계는 끊긴 것이 아니다
+            if (b == 0 && i > 0 && GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DISCONT)) {
+                buffer = gst_buffer_make_writable(buffer);
+                GST_BUFFER_FLAG_UNSET(buffer, GST_BUFFER_FLAG_DISCONT);
+            }
+            frames++;
+            bytes += gst_buffer_get_size(buffer);
+            if (gst_app_src_push_buffer(GST_APP_SRC(stitch_src), buffer) != GST_FLOW_OK) {
+                ok = FALSE;
+                break;
+            }
+        }
+        g_ptr_array_set_size(seg->buffers, 0); // 이어 붙인 segment는 바로 놓아준다
+    }
+
+    g_thread_pool_free(pool, FALSE, TRUE);
+
+    if (stitch) {
+        GstBus *bus = gst_element_get_bus(stitch);
+        GstMessage *msg;
+
+        gst_app_src_end_of_stream(GST_APP_SRC(stitch_src));
+        msg = gst_bus_timed_pop_filtered(bus, GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+        if (msg && GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
+            GError *err = NULL;
+            gst_message_parse_error(msg, &err, NULL);
+            g_printerr("[BATCH] 이어 붙이기 에러: %s\n", err->message);
+            g_error_free(err);
+            ok = FALSE;
+        }
+        if (msg) gst_message_unref(msg);
+        gst_object_unref(bus);
+        gst_element_set_state(stitch, GST_STATE_NULL);
+        gst_object_unref(stitch);
+    }
+    if (rtp_file) {
+        fclose(rtp_file);
+        rtp_file = NULL;
+    }
+
+    wall_s = (g_get_monotonic_time() - start_us) / 1e6;
+    cpu_s = process_cpu_seconds() - start_cpu;
+    media_s = (gdouble)input_samples / PCM_RATE;
+
+    for (i = 0; i < n_segments; i++) {
+        if (segments[i].buffers) g_ptr_array_free(segments[i].buffers, TRUE);
+        if (segments[i].caps) gst_caps_unref(segments[i].caps);
+    }
+    g_free(segments);
+
+    if (!ok) {
+        g_printerr("[BATCH] %u jobs 실행 실패\n", n_jobs);
+        return FALSE;
+    }
+    g_print("RESULT codec=%s jobs=%u segments=%u segment_s=%.2f media_s=%.1f wall_s=%.3f realtime_x=%.1f "
+            "per_core_x=%.1f cpu_cores=%.2f frames=%" G_GUINT64_FORMAT " bytes=%" G_GUINT64_FORMAT
+            " rtp_packets=%" G_GUINT64_FORMAT "\n",
+            codec_name, n_jobs, n_segments, (gdouble)seg_samples / PCM_RATE, media_s, wall_s,
+            media_s / wall_s, media_s / wall_s / n_jobs, cpu_s / wall_s, frames, bytes,
+            rtp_path ? rtp_packets : 0);
+    return TRUE;
+}
+
+int main(int argc, char *argv[]) {
+    GOptionContext *context;
+    GError *error = NULL;
+    struct stat st;
+    gboolean ok = TRUE;
+    gint fd;
+
+    gst_init(&argc, &argv);
+
+    context = g_option_context_new("- PCM 파일 병렬 일괄 변환");
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("옵션 파싱 실패: %s\n", error->message);
+        g_error_free(error);
+        g_option_context_free(context);
+        return -1;
+    }
+    g_option_context_free(context);
+
+    codec_registry_init();
+    if (list_codecs) {
+        codec_registry_dump();
+        return 0;
+    }
+    if (!input_path) {
+        g_printerr("입력 파일(-i)이 필요합니다\n");
+        return -1;
+    }
+    if (!codec_name) codec_name = g_strdup("opus");
+    codec = codec_registry_lookup(codec_name);
+    if (!codec) return -1;
+    if (!codec_get_frame_samples(codec) || codec_has_encoded_input(codec)) {
+        g_printerr("[BATCH] %s는 인코딩 단계가 없는 코덱 (raw/passthrough)\n", codec_get_label(codec));
+        return -1;
+    }
+    if (jobs <= 0) jobs = g_get_num_processors();
+    if (segment_seconds <= 0) segment_seconds = DEFAULT_SEGMENT_SECONDS;
+
+    fd = open(input_path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < PCM_BYTES_PER_SAMPLE) {
+        g_printerr("입력 파일 열기 실패: %s\n", input_path);
+        return -1;
+    }
+    input = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (input == MAP_FAILED) {
+        g_printerr("mmap 실패: %s\n", input_path);
+        return -1;
+    }
+    madvise((void *)input, st.st_size, MADV_SEQUENTIAL);
+    input_samples = st.st_size / PCM_BYTES_PER_SAMPLE;
+
+    g_print("[BATCH] %s → %s, %.1f초, 코어 %u개\n", input_path, codec_get_label(codec),
+            (gdouble)input_samples / PCM_RATE, g_get_num_processors());
+
+    if (scan) {
+        // 1, 2, 4 ... 그리고 jobs (결과 파일은 매번 덮어쓴다)
+        for (guint n = 1; ok && n < (guint)jobs; n *= 2) ok = run_transcode(n);
+        if (ok) ok = run_transcode(jobs);
+    } else {
+        ok = run_transcode(jobs);
+    }
+
+    munmap((void *)input, st.st_size);
+    g_free(input_path);
+    g_free(codec_name);
+    g_free(output_path);
+    g_free(rtp_path);
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,38 @@
+#!/bin/bash
+# egress_bench.sh
+# 같은 부하에서 udpsink(multiudpsink, render마다 sendmmsg)와 배치 송출(sendmmsg/GSO)의 pps / CPU 비교 (loopback)
+# udpsink의 pkts/syscall은 render 호출 수로 잡은 추정치 (*), 배치 송출은 실제 호출 수
+#
+# 사용: bash egress_bench.sh [실행 시간 초] [세션 수] [latency budget us]
+#       bash egress_bench.sh 30 128 1000
+
+DURATION=${1:-30}
+SESSIONS=${2:-128}
+BUDGET=${3:-1000}
+BASE_PORT=20000
+BIN=./multi_sender
+
+if [ ! -x "$BIN" ]; then
+    echo "$BIN 없음 (make 먼저)" >&2
+    exit 1
+fi
+
+field() {
+    echo "$1" | tr ' ' '\n' | grep "^$2=" | cut -d= -f2
+}
+
+printf "%-8s %12s %10s %14s\n" "egress" "pps" "cpu_%" "pkts/syscall"
+
+for MODE in "" "-b --latency-budget $BUDGET"; do
+    line=$($BIN -n "$SESSIONS" -p $BASE_PORT -i 0 -d "$DURATION" $MODE 2>/dev/null | grep '^RESULT')
+    packets=$(field "$line" packets)
+    syscalls=$(field "$line" syscalls)
+    cpu=$(field "$line" cpu_s)
+    egress=$(field "$line" egress)
+    printf "%-8s %12.0f %10.1f %13.1f%s\n" "$egress" \
+        "$(echo "$packets / $DURATION" | bc -l)" \
+        "$(echo "$cpu * 100 / $DURATION" | bc -l)" \
+        "$(echo "$packets / ($syscalls + 0.000001)" | bc -l)" \
+        "$([ "$egress" = udpsink ] && echo '*' || echo ' ')"
+done
+echo "* 추정치: multiudpsink render 한 번 = sendmmsg 한 번으로 계산"
@@ -0,0 +1,34 @@
+#!/bin/bash
+# fanout_bench.sh
+# 세션당 목적지 수를 늘려가며 CPU 비교 (loopback). 인코딩은 세션당 한 번이므로
+# 목적지가 늘어도 패킷당 CPU는 거의 그대로여야 한다 (늘어나는 건 송출 시스템콜뿐).
+#
+# 사용: bash fanout_bench.sh [실행 시간 초] [세션 수] [추가 옵션]
+#       bash fanout_bench.sh 30 16 -b
+
+DURATION=${1:-30}
+SESSIONS=${2:-16}
+EXTRA=${3:-}
+BASE_PORT=20000
+BIN=./multi_sender
+
+if [ ! -x "$BIN" ]; then
+    echo "$BIN 없음 (make 먼저)" >&2
+    exit 1
+fi
+
+field() {
+    echo "$1" | tr ' ' '\n' | grep "^$2=" | cut -d= -f2
+}
+
+printf "%-8s %12s %10s %16s\n" "fanout" "pps" "cpu_%" "cpu_us/packet"
+
+for F in 1 4 16 64; do
+    line=$($BIN -n "$SESSIONS" -f "$F" -p $BASE_PORT -i 0 -d "$DURATION" $EXTRA 2>/dev/null | grep '^RESULT')
+    packets=$(field "$line" packets)
+    cpu=$(field "$line" cpu_s)
+    printf "%-8s %12.0f %10.1f %16.2f\n" "$F" \
+        "$(echo "$packets / $DURATION" | bc -l)" \
+        "$(echo "$cpu * 100 / $DURATION" | bc -l)" \
+        "$(echo "$cpu * 1000000 / ($packets + 0.000001)" | bc -l)"
+done
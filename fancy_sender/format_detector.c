@@ -0,0 +1,144 @@
+// format_detector.c
+/*
+ * 스트리밍 포맷 감지기 (typefind 대체)
+ *
+ * appsrc src pad의 버퍼 probe로 모든 버퍼를 검사한다.
+ *  1. memchr 기반으로 AC3 syncword(0x0B77) 후보를 찾고
+ *  2. 헤더로 프레임 크기를 구해 crc1을 확인하고, 다음 프레임도 sync로 시작하는지 본다
+ *  3. 현재 포맷과 다른 판정이 hysteresis개 버퍼 연속으로 나올 때만 전환 이벤트를 낸다
+ *     (첫 판정은 뒤집을 상태가 없으므로 바로 낸다)
+ *
+ * 전환 이벤트 콜백은 스트리밍 스레드가 아니라 main loop에서 불린다.
+ *
+ * 사용: format_detector_attach(appsrc, on_format_change, NULL, 2);
+ */
+#include <gst/gst.h>
+
+#define REPORT_INTERVAL_BUFFERS 500
+
+typedef enum {
+    DETECTED_UNKNOWN,
+    DETECTED_PCM,
+    DETECTED_AC3
+} DetectedFormat;
+
+typedef void (*FormatChangeFunc)(gboolean is_ac3, gpointer user_data);
+
+typedef struct _FormatDetector {
+    FormatChangeFunc func;
+    gpointer user_data;
+    guint hysteresis;
+
+    // 스트리밍 스레드에서만 접근
+    DetectedFormat current;
+    DetectedFormat candidate;
+    guint candidate_count;
+
+    guint64 buffers;
+    guint64 bytes_scanned;
+    gint64 scan_time_us;
+} FormatDetector;
+
+typedef struct {
+    FormatDetector *detector;
+    gboolean is_ac3;
+} FormatEvent;
+
+// ../common/ac3_frame.c
+guint ac3_frame_size(const guint8 *data, gsize len);
+const guint8 *ac3_find_sync(const guint8 *data, gsize len);
+gboolean ac3_check_crc1(const guint8 *frame, guint frame_size);
+
+// ../common/ring_logger.c (probe는 스트리밍 스레드에서 돈다)
+void ring_log(const gchar *fmt, ...) G_GNUC_PRINTF(1, 2);
+
+// 📌 버퍼 안에 검증된 AC3 프레임이 있는지
+static gboolean buffer_has_ac3(const guint8 *data, gsize size) {
+    const guint8 *p = data, *end = data + size;
+
+    while ((p = ac3_find_sync(p, end - p)) != NULL) {
+        guint frame_size = ac3_frame_size(p, end - p);
+
+        if (frame_size && p + frame_size <= end && ac3_check_crc1(p, frame_size)) {
+            const guint8 *next = p + frame_size;
+            // 우연히 맞은 패턴을 거르기 위해 다음 프레임 위치도 확인 (버퍼 끝이면 통과)
+            if (next == end || (next + 1 < end && next[0] == 0x0B && next[1] == 0x77))
+                return TRUE;
+        }
+        p++;
+    }
+    return FALSE;
+}
+
+static gboolean dispatch_format_event(gpointer data) {
+    FormatEvent *event = data;
+
+    event->detector->func(event->is_ac3, event->detector->user_data);
+    g_free(event);
+    return G_SOURCE_REMOVE;
+}
+
+static GstPadProbeReturn on_buffer(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    FormatDetector *detector = user_data;
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    DetectedFormat format;
+    GstMapInfo map;
+    gint64 start;
+
+    if (!gst_buffer_map(buffer, &map, GST_MAP_READ)) return GST_PAD_PROBE_OK;
+    start = g_get_monotonic_time();
+    format = buffer_has_ac3(map.data, map.size) ? DETECTED_AC3 : DETECTED_PCM;
+    detector->scan_time_us += g_get_monotonic_time() - start;
+    detector->bytes_scanned += map.size;
+    gst_buffer_unmap(buffer, &map);
+
+    // hysteresis: 다른 판정이 연속으로 쌓여야 전환
+    if (detector->current == DETECTED_UNKNOWN) {
+        detector->candidate = format;
+        detector->candidate_count = detector->hysteresis - 1;
+    }
+    if (format == detector->current) {
+        detector->candidate_count = 0;
+    } else {
+        if (format != detector->candidate) {
+            detector->candidate = format;
+            detector->candidate_count = 0;
+        }
+        if (++detector->candidate_count >= detector->hysteresis) {
+            FormatEvent *event = g_new0(FormatEvent, 1);
+
+            ring_log("[DETECTOR] 포맷 변경 확정: %s -> %s\n",
+                     detector->current == DETECTED_AC3 ? "AC3" :
+                     detector->current == DETECTED_PCM ? "PCM" : "(없음)",
+                     format == DETECTED_AC3 ? "AC3" : "PCM");
+            detector->current = format;
+            detector->candidate_count = 0;
+
+            event->detector = detector;
+            event->is_ac3 = (format == DETECTED_AC3);
+            g_idle_add(dispatch_format_event, event);
+        }
+    }
+
+    if (++detector->buffers % REPORT_INTERVAL_BUFFERS == 0 && detector->scan_time_us > 0) {
+        ring_log("[DETECTOR] 검사 속도 %.1f MB/s (%" G_GUINT64_FORMAT " 버퍼)\n",
+                 detector->bytes_scanned / (gdouble)detector->scan_time_us, detector->buffers);
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+// 📌 element의 src pad에 감지기 연결. hysteresis: 전환 확정에 필요한 연속 버퍼 수 (최소 1)
+FormatDetector *format_detector_attach(GstElement *element, FormatChangeFunc func, gpointer user_data,
+                                       guint hysteresis) {
+    FormatDetector *detector = g_new0(FormatDetector, 1);
+    GstPad *pad = gst_element_get_static_pad(element, "src");
+
+    detector->func = func;
+    detector->user_data = user_data;
+    detector->hysteresis = MAX(hysteresis, 1);
+    detector->current = detector->candidate = DETECTED_UNKNOWN;
+
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, on_buffer, detector, g_free);
+    gst_object_unref(pad);
+    return detector;
+}
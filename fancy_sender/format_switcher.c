@@ -1,52 +1,481 @@
 // format_switcher.c
-
+/*
+ * 전환기 상태는 upstream element(보통 appsrc)마다 따로 둔다 (g_object_set_data).
+ * 한 프로세스에 여러 세션(appsrc)이 있어도 서로 간섭하지 않고, 상태는 upstream과 함께 해제된다.
+ *
+ * 목적지(fan-out) 목록도 이 상태에 있다. 인코딩은 한 번, 송출 sink가 목록의 모든 목적지로 보낸다.
+ * 목적지 추가/삭제는 살아 있는 sink의 목적지만 바꾸고 (bin/인코더는 그대로),
+ * 이후 전환으로 만들어지는 bin에도 같은 목록이 적용된다.
+ */
 #include <gst/gst.h>
 
-// 외부 pipeline 접근을 위한 전역 포인터
-extern GstElement *pipeline;
+#include "../common/latency_profile.h" // 저지연 프로필일 때만 capture 시각 stamp
+#include "../common/stream_metrics.h"
+
+#define SWITCHER_STATE_KEY "format-switcher-state"
+#define LATENCY_SAMPLE_INTERVAL 16 // 종단 지연은 출력 N번에 한 번만 잰다 (running time 조회 비용)
+
+typedef struct _RtpContinuity RtpContinuity;
+typedef struct _CodecDescriptor CodecDescriptor;
+
+// 전환이 실제로 끝난 뒤(새 bin이 연결된 뒤) 알림. live swap이면 IDLE probe 안(스트리밍 스레드)
+typedef void (*FormatSwitchedFunc)(const CodecDescriptor *codec, gpointer user_data);
+
+typedef struct {
+    gchar *name;             // 로그용 (upstream 이름)
+    GPtrArray *destinations; // "host:port" 목록
+    gboolean has_destinations; // FALSE면 목록을 쓰지 않고 bin 기본 목적지
+
+    // 현재 연결된 bin 추적 (live swap은 재연결이 확인된 뒤에 바꾼다, lock)
+    // 목적지 목록 변경과 current_sink 적용도 lock 아래에서 (교체 완료는 스트리밍 스레드)
+    GstElement *current_bin;
+    GstElement *current_sink;
+
+    // 대기(standby) 모드: 두 bin을 시작 시 미리 만들어 두고 output-selector로 경로만 바꾼다
+    GstElement *selector;
+    GstElement *standby_pcm_bin, *standby_ac3_bin;
+    GstPad *standby_pcm_pad, *standby_ac3_pad;
+    GstElement *standby_pcm_sink, *standby_ac3_sink;
+    const CodecDescriptor *standby_pcm_codec, *standby_ac3_codec;
+
+    // 전환 간격 측정 (이전 bin의 마지막 출력 ~ 새 bin의 첫 출력)
+    GMutex lock;
+    gint64 last_output_us;   // 어떤 bin이든 마지막으로 패킷을 내보낸 시각
+    gint64 requested_us;     // 전환 요청 시각
+    GstElement *pending_bin; // 첫 출력을 기다리는 새 bin
+
+    // 모니터용 지표 (../common/stream_metrics.c, upstream 이름으로 등록)
+    StreamMetrics *metrics;
+    GThread *output_thread;  // 마지막으로 출력을 낸 스트리밍 스레드
+    guint64 output_cpu_ns;   // 그 스레드의 CPU 시간 (이전 출력 시점)
+    guint output_count;
+
+    // 전환을 넘어 이어지는 RTP 세션 (SSRC/seqnum/timestamp, ../common/rtp_continuity.c)
+    RtpContinuity *rtp;
+
+    // PCM 입력을 보낼 코덱 (기본 Opus, format_switcher_set_pcm_codec으로 변경)
+    const CodecDescriptor *pcm_codec;
+
+    // 전환 완료 알림 (format_switcher_set_switched_callback)
+    FormatSwitchedFunc switched_func;
+    gpointer switched_data;
+} SwitcherState;
+
+// live swap 하나의 요청 (결과 콜백까지)
+typedef struct {
+    SwitcherState *state;
+    const CodecDescriptor *codec;
+    GstElement *sink;        // 성공하면 current_sink가 된다
+} SwapRequest;
+
+// ../common/codec_registry.c (송출 bin은 전부 등록부에서)
+const CodecDescriptor *codec_registry_lookup(const gchar *name);
+GstElement *codec_registry_make_bin(const CodecDescriptor *codec, GstElement **out_sink);
+const gchar *codec_get_name(const CodecDescriptor *codec);
+const gchar *codec_get_label(const CodecDescriptor *codec);
+
+typedef void (*LiveSwapDoneFunc)(GstElement *new_bin, gboolean ok, gpointer user_data);
+gboolean live_swap_bin(GstElement *upstream, GstElement *new_bin, LiveSwapDoneFunc done, gpointer user_data);
+
+// ../common/ring_logger.c (on_bin_output은 스트리밍 스레드)
+void ring_log(const gchar *fmt, ...) G_GNUC_PRINTF(1, 2);
+
+// ../common/egress.c
+void egress_set_clients(GstElement *sink, const gchar *clients);
+
+// ../common/pipeline_trace.c
+void pipeline_trace_attach(GstElement *bin, const gchar *label);
+
+// ../common/rtp_continuity.c
+RtpContinuity *rtp_continuity_new(void);
+void rtp_continuity_unref(RtpContinuity *c);
+void rtp_continuity_attach(RtpContinuity *c, GstElement *sink);
+
+// ../common/pcap_capture.c (--pcap로 열려 있을 때만 기록)
+void pcap_capture_attach(GstElement *sink);
+
+// ../common/rtcp_feedback.c (--abr로 시작했을 때만 SR용 송출 통계)
+void rtcp_feedback_attach(GstElement *sink);
+
+static void switcher_state_free(gpointer data) {
+    SwitcherState *state = data;
+
+    g_clear_object(&state->standby_pcm_pad);
+    g_clear_object(&state->standby_ac3_pad);
+    rtp_continuity_unref(state->rtp);
+    g_mutex_clear(&state->lock);
+    g_ptr_array_free(state->destinations, TRUE);
+    g_free(state->name);
+    g_free(state);
+}
+
+// 📌 upstream의 전환기 상태 (없으면 만들어서 upstream에 붙인다)
+static SwitcherState *get_state(GstElement *upstream) {
+    SwitcherState *state = g_object_get_data(G_OBJECT(upstream), SWITCHER_STATE_KEY);
+
+    if (!state) {
+        state = g_new0(SwitcherState, 1);
+        state->name = gst_element_get_name(upstream);
+        state->destinations = g_ptr_array_new_with_free_func(g_free);
+        state->metrics = stream_metrics_register(state->name);
+        state->rtp = rtp_continuity_new();
+        g_mutex_init(&state->lock);
+        g_object_set_data_full(G_OBJECT(upstream), SWITCHER_STATE_KEY, state, switcher_state_free);
+    }
+    return state;
+}
+
+// 📌 sink 하나에 목적지 목록 적용
+static void apply_destinations_to(SwitcherState *state, GstElement *sink) {
+    gchar *clients;
+
+    if (!sink || !state->has_destinations) return;
+    g_ptr_array_add(state->destinations, NULL);
+    clients = g_strjoinv(",", (gchar **)state->destinations->pdata);
+    g_ptr_array_remove_index(state->destinations, state->destinations->len - 1);
+
+    egress_set_clients(sink, clients);
+    g_free(clients);
+}
+
+// 📌 살아 있는 sink 전부에 목적지 목록 적용 (bin 재구성 없음, lock 잡은 채로)
+// current_sink는 교체가 확인된 sink라서, 이전 bin이 정리되기 전까지는 살아 있다
+static void apply_destinations(SwitcherState *state) {
+    apply_destinations_to(state, state->current_sink);
+    if (state->standby_pcm_sink != state->current_sink)
+        apply_destinations_to(state, state->standby_pcm_sink);
+    if (state->standby_ac3_sink != state->current_sink)
+        apply_destinations_to(state, state->standby_ac3_sink);
+}
+
+static gint find_destination(SwitcherState *state, const gchar *dest) {
+    for (guint i = 0; i < state->destinations->len; i++) {
+        if (g_strcmp0(g_ptr_array_index(state->destinations, i), dest) == 0) return i;
+    }
+    return -1;
+}
+
+// 📌 목적지를 127.0.0.1:port 하나로 (main loop 스레드에서)
+void format_switcher_set_port(GstElement *upstream, guint port) {
+    SwitcherState *state = get_state(upstream);
+
+    g_mutex_lock(&state->lock);
+    g_ptr_array_set_size(state->destinations, 0);
+    g_ptr_array_add(state->destinations, g_strdup_printf("127.0.0.1:%u", port));
+    state->has_destinations = TRUE;
+    apply_destinations(state);
+    g_mutex_unlock(&state->lock);
+}
+
+// 📌 목적지 추가 (main loop 스레드에서). 인코더/bin은 건드리지 않는다
+gboolean format_switcher_add_destination(GstElement *upstream, const gchar *host, guint port) {
+    SwitcherState *state = get_state(upstream);
+    gchar *dest = g_strdup_printf("%s:%u", host, port);
+
+    if (find_destination(state, dest) >= 0) {
+        g_free(dest);
+        return FALSE;
+    }
+    g_mutex_lock(&state->lock);
+    g_ptr_array_add(state->destinations, dest);
+    state->has_destinations = TRUE;
+    apply_destinations(state);
+    g_mutex_unlock(&state->lock);
+    g_print("[FORMAT_SWITCHER] %s 목적지 추가: %s (총 %u개)\n", state->name, dest, state->destinations->len);
+    return TRUE;
+}
+
+// 📌 목적지 삭제 (main loop 스레드에서). 마지막 목적지가 빠지면 송출만 멈추고 인코딩은 계속된다
+gboolean format_switcher_remove_destination(GstElement *upstream, const gchar *host, guint port) {
+    SwitcherState *state = get_state(upstream);
+    gchar *dest = g_strdup_printf("%s:%u", host, port);
+    gint index = find_destination(state, dest);
+
+    if (index < 0) {
+        g_free(dest);
+        return FALSE;
+    }
+    g_mutex_lock(&state->lock);
+    g_ptr_array_remove_index(state->destinations, index);
+    apply_destinations(state);
+    g_mutex_unlock(&state->lock);
+    g_print("[FORMAT_SWITCHER] %s 목적지 삭제: %s (총 %u개)\n", state->name, dest, state->destinations->len);
+    g_free(dest);
+    return TRUE;
+}
+
+// 📌 bin의 sink로 들어가는 버퍼를 보고 전환 간격을 계산하고 모니터 지표를 올린다
+static GstPadProbeReturn on_bin_output(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    SwitcherState *state = user_data;
+    GstElement *sink = GST_PAD_PARENT(pad);
+    GstElement *bin = GST_ELEMENT(GST_OBJECT_PARENT(sink));
+    GstBuffer *buffer = NULL;
+    GThread *self = g_thread_self();
+    guint64 cpu_ns = stream_metrics_thread_cpu_ns();
+    gint64 now = g_get_monotonic_time();
+
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+        GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST(info);
+        stream_metrics_add_packets(state->metrics, gst_buffer_list_length(list),
+                                   gst_buffer_list_calculate_size(list));
+        if (gst_buffer_list_length(list) > 0) buffer = gst_buffer_list_get(list, 0);
+    } else {
+        buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+        stream_metrics_add_packets(state->metrics, 1, gst_buffer_get_size(buffer));
+    }
+
+    g_mutex_lock(&state->lock);
+    // 송출 스트리밍 스레드의 CPU: 같은 스레드에서 이어서 나온 출력 사이의 증가분만 더한다
+    if (state->output_thread == self && cpu_ns >= state->output_cpu_ns)
+        stream_metrics_add_cpu(state->metrics, cpu_ns - state->output_cpu_ns);
+    state->output_thread = self;
+    state->output_cpu_ns = cpu_ns;
 
-// 현재 연결된 bin 추적
-static GstElement *current_bin = NULL;
+    // appsrc do-timestamp PTS = 넣은 순간의 running time
+    if (++state->output_count % LATENCY_SAMPLE_INTERVAL == 0 && buffer && GST_BUFFER_PTS_IS_VALID(buffer)) {
+        GstClockTime running = gst_element_get_current_running_time(sink);
+        if (GST_CLOCK_TIME_IS_VALID(running) && running >= GST_BUFFER_PTS(buffer))
+            stream_metrics_set_latency(state->metrics, (running - GST_BUFFER_PTS(buffer)) / GST_USECOND);
+    }
+
+    if (state->pending_bin == bin) {
+        gdouble gap_ms = state->last_output_us ?
+            (now - state->last_output_us) / 1000.0 : 0.0;
+        gdouble since_request_ms = (now - state->requested_us) / 1000.0;
+        ring_log("[FORMAT_SWITCHER] %s/%s 전환 간격: %.2f ms (요청 후 첫 패킷까지 %.2f ms)\n",
+                 state->name, GST_ELEMENT_NAME(bin), gap_ms, since_request_ms);
+        state->pending_bin = NULL;
+        stream_metrics_record_switch(state->metrics, state->last_output_us ? now - state->last_output_us : 0);
+    }
+    state->last_output_us = now;
+    g_mutex_unlock(&state->lock);
+
+    return GST_PAD_PROBE_OK;
+}
+
+// 📌 새 bin 공통 처리: 목적지 목록 적용 + RTP 세션 연결 + RTCP 통계 + 캡처 + 출력 감시
+static void watch_bin_output(SwitcherState *state, GstElement *sink) {
+    GstPad *pad = gst_element_get_static_pad(sink, "sink");
+
+    apply_destinations_to(state, sink);
+    rtp_continuity_attach(state->rtp, sink);
+    latency_profile_stamp(sink);
+    rtcp_feedback_attach(sink);
+    pcap_capture_attach(sink); // 헤더를 고쳐 쓴 뒤의 패킷을 기록
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+                      on_bin_output, state, NULL);
+    gst_object_unref(pad);
+}
+
+static void mark_switch_requested(SwitcherState *state, GstElement *new_bin) {
+    g_mutex_lock(&state->lock);
+    state->requested_us = g_get_monotonic_time();
+    state->pending_bin = new_bin;
+    g_mutex_unlock(&state->lock);
+}
+
+// 📌 live swap 결과 (IDLE probe 안, 또는 live_swap_bin 안에서 바로)
+// 실패한 bin은 이미 해제 중이므로 현재 bin/sink로 기억하지 않는다
+static void on_swap_done(GstElement *new_bin, gboolean ok, gpointer user_data) {
+    SwapRequest *request = user_data;
+    SwitcherState *state = request->state;
+
+    g_mutex_lock(&state->lock);
+    if (ok) {
+        state->current_bin = new_bin;
+        state->current_sink = request->sink;
+        // bin을 만든 뒤 교체가 끝나기 전에 목적지가 바뀌었을 수 있다
+        apply_destinations_to(state, request->sink);
+    } else if (state->pending_bin == new_bin) {
+        state->pending_bin = NULL;
+    }
+    g_mutex_unlock(&state->lock);
+
+    if (!ok) g_printerr("[FORMAT_SWITCHER] %s appsrc와 새 pipeline 연결 실패, 이전 bin 유지\n", state->name);
+    else if (state->switched_func) state->switched_func(request->codec, state->switched_data);
+    g_free(request);
+}
+
+// 📌 데이터가 흐르는 채로 bin 교체 (pipeline 상태는 PLAYING 유지)
+static void replace_bin(GstElement *appsrc, SwitcherState *state, GstElement *new_bin, GstElement *new_sink,
+                        const CodecDescriptor *codec) {
+    SwapRequest *request = g_new0(SwapRequest, 1);
+
+    request->state = state;
+    request->codec = codec;
+    request->sink = new_sink;
+    live_swap_bin(appsrc, new_bin, on_swap_done, request);
+}
+
+// 📌 전환 완료 알림 등록 (appsrc caps처럼 새 bin이 연결된 뒤에 바꿔야 하는 것용)
+void format_switcher_set_switched_callback(GstElement *upstream, FormatSwitchedFunc func, gpointer user_data) {
+    SwitcherState *state = get_state(upstream);
+
+    state->switched_func = func;
+    state->switched_data = user_data;
+}
+
+// 📌 PCM 입력용 코덱 (설정이 없으면 Opus)
+static const CodecDescriptor *get_pcm_codec(SwitcherState *state) {
+    if (!state->pcm_codec) state->pcm_codec = codec_registry_lookup("opus");
+    return state->pcm_codec;
+}
+
+// 📌 PCM 입력을 보낼 코덱 변경 (opus, l16, l24, aac, ac3, eac3 ...). 다음 PCM 전환부터 적용
+gboolean format_switcher_set_pcm_codec(GstElement *upstream, const gchar *name) {
+    SwitcherState *state = get_state(upstream);
+    const CodecDescriptor *codec = codec_registry_lookup(name);
+
+    if (!codec) return FALSE;
+    if (state->selector) {
+        g_printerr("[FORMAT_SWITCHER] %s 대기 모드는 준비된 bin만 쓴다. 코덱은 prepare_standby_bins 전에 정할 것\n",
+                   state->name);
+        return FALSE;
+    }
+    state->pcm_codec = codec;
+    return TRUE;
+}
+
+// 📌 대기 모드 준비: upstream → output-selector → {PCM 코덱 bin, AC3 bin}
+// 두 bin 모두 pipeline과 함께 PLAYING 상태로 유지되고, 전환은 active-pad 변경만으로 끝난다.
+// ac3_passthrough: AC3 쪽 입력이 이미 AC3면 TRUE (passthrough bin), PCM을 AC3로 보낼 거면 FALSE (인코딩 bin)
+gboolean prepare_standby_bins(GstElement *upstream, gboolean ac3_passthrough) {
+    GstElement *pipeline = GST_ELEMENT(gst_element_get_parent(upstream));
+    SwitcherState *state = get_state(upstream);
+    GstElement *pcm_sink = NULL, *ac3_sink = NULL;
+    const CodecDescriptor *pcm_codec = get_pcm_codec(state);
+    const CodecDescriptor *ac3_codec = codec_registry_lookup(ac3_passthrough ? "ac3-passthrough" : "ac3");
+    GstPad *sinkpad;
 
-// 외부 생성 함수
-GstElement* create_pcm_pipeline_bin(GstElement **out_sink);
-GstElement* create_ac3_pipeline_bin(GstElement **out_sink);
+    if (!pipeline) {
+        g_printerr("대기 모드: upstream이 pipeline에 속해 있지 않음\n");
+        return FALSE;
+    }
 
-static void replace_bin(GstElement *appsrc, GstElement *new_bin) {
-    // 파이프라인 일시 정지
-    gst_element_set_state(pipeline, GST_STATE_PAUSED);
+    state->selector = gst_element_factory_make("output-selector", "standby_selector");
+    state->standby_pcm_bin = pcm_codec ? codec_registry_make_bin(pcm_codec, &pcm_sink) : NULL;
+    state->standby_ac3_bin = ac3_codec ? codec_registry_make_bin(ac3_codec, &ac3_sink) : NULL;
 
-    if (current_bin) {
-        gst_bin_remove(GST_BIN(pipeline), current_bin);
-        gst_element_set_state(current_bin, GST_STATE_NULL);
-        gst_object_unref(current_bin);
-        current_bin = NULL;
+    if (!state->selector || !state->standby_pcm_bin || !state->standby_ac3_bin) {
+        g_printerr("대기 모드 요소 생성 실패\n");
+        gst_object_unref(pipeline);
+        return FALSE;
     }
 
-    // 새로운 bin 추가 및 연결
-    gst_bin_add(GST_BIN(pipeline), new_bin);
-    gst_element_sync_state_with_parent(new_bin);
+    // 활성 pad 쪽으로만 caps 협상
+    gst_util_set_object_arg(G_OBJECT(state->selector), "pad-negotiation-mode", "active");
 
-    // appsrc → new_bin 연결
-    if (!gst_element_link(appsrc, new_bin)) {
-        g_printerr("appsrc와 새 pipeline 연결 실패\n");
+    gst_bin_add_many(GST_BIN(pipeline), state->selector, state->standby_pcm_bin, state->standby_ac3_bin, NULL);
+    if (!gst_element_link(upstream, state->selector) ||
+        !gst_element_link(state->selector, state->standby_pcm_bin) ||
+        !gst_element_link(state->selector, state->standby_ac3_bin)) {
+        g_printerr("대기 모드 연결 실패\n");
+        gst_object_unref(pipeline);
+        return FALSE;
     }
 
-    current_bin = new_bin;
+    // selector 쪽 src pad 보관 (active-pad 지정용)
+    sinkpad = gst_element_get_static_pad(state->standby_pcm_bin, "sink");
+    state->standby_pcm_pad = gst_pad_get_peer(sinkpad);
+    gst_object_unref(sinkpad);
+    sinkpad = gst_element_get_static_pad(state->standby_ac3_bin, "sink");
+    state->standby_ac3_pad = gst_pad_get_peer(sinkpad);
+    gst_object_unref(sinkpad);
+
+    state->standby_pcm_sink = pcm_sink;
+    state->standby_ac3_sink = ac3_sink;
+    state->standby_pcm_codec = pcm_codec;
+    state->standby_ac3_codec = ac3_codec;
+    watch_bin_output(state, pcm_sink);
+    watch_bin_output(state, ac3_sink);
+    pipeline_trace_attach(state->standby_pcm_bin, codec_get_name(pcm_codec));
+    pipeline_trace_attach(state->standby_ac3_bin, codec_get_name(ac3_codec));
 
-    // 전체 pipeline 재생
-    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    g_object_set(state->selector, "active-pad", state->standby_pcm_pad, NULL);
+    state->current_bin = state->standby_pcm_bin;
+    state->current_sink = pcm_sink;
+
+    gst_element_sync_state_with_parent(state->selector);
+    gst_element_sync_state_with_parent(state->standby_pcm_bin);
+    gst_element_sync_state_with_parent(state->standby_ac3_bin);
+
+    gst_object_unref(pipeline);
+    g_print("[FORMAT_SWITCHER] %s 대기 모드 준비 완료 (%s/%s bin 상시 대기)\n",
+            state->name, codec_get_label(pcm_codec), codec_get_label(ac3_codec));
+    return TRUE;
+}
+
+// 📌 대기 모드 전환: pipeline 상태는 PLAYING 그대로, selector 경로만 변경 (바로 끝난다)
+static void select_standby_bin(SwitcherState *state, GstElement *bin, GstPad *pad, GstElement *sink,
+                               const CodecDescriptor *codec) {
+    if (state->current_bin == bin) return;
+
+    mark_switch_requested(state, bin);
+    g_object_set(state->selector, "active-pad", pad, NULL);
+    g_mutex_lock(&state->lock);
+    state->current_bin = bin;
+    state->current_sink = sink;
+    g_mutex_unlock(&state->lock);
+    if (state->switched_func) state->switched_func(codec, state->switched_data);
+}
+
+// 📌 등록부에서 새 bin을 만들어 live swap
+static void switch_to_new_bin(GstElement *appsrc, SwitcherState *state, const CodecDescriptor *codec) {
+    GstElement *sink = NULL;
+    GstElement *bin = codec ? codec_registry_make_bin(codec, &sink) : NULL;
+
+    if (!bin) return;
+    g_print("[FORMAT_SWITCHER] %s %s pipeline 생성 중...\n", state->name, codec_get_label(codec));
+    watch_bin_output(state, sink);
+    pipeline_trace_attach(bin, codec_get_name(codec)); // PIPELINE_TRACE가 없으면 아무것도 안 함
+    mark_switch_requested(state, bin);
+    replace_bin(appsrc, state, bin, sink, codec);
 }
 
 // 외부에서 호출하는 포맷 전환 함수들
 void switch_to_pcm_pipeline(GstElement *appsrc) {
-    g_print("[FORMAT_SWITCHER] PCM pipeline 생성 중...\n");
-    GstElement *pcm_bin = create_pcm_pipeline_bin(NULL);
-    replace_bin(appsrc, pcm_bin);
+    SwitcherState *state = get_state(appsrc);
+
+    stream_metrics_set_format(state->metrics, FALSE);
+
+    if (state->selector) {
+        g_print("[FORMAT_SWITCHER] %s 대기 중인 PCM bin으로 전환\n", state->name);
+        select_standby_bin(state, state->standby_pcm_bin, state->standby_pcm_pad, state->standby_pcm_sink,
+                           state->standby_pcm_codec);
+        return;
+    }
+
+    switch_to_new_bin(appsrc, state, get_pcm_codec(state));
 }
 
+// 📌 AC3 입력 → passthrough (재인코딩 없음)
 void switch_to_ac3_pipeline(GstElement *appsrc) {
-    g_print("[FORMAT_SWITCHER] AC3 pipeline 생성 중...\n");
-    GstElement *ac3_bin = create_ac3_pipeline_bin(NULL);
-    replace_bin(appsrc, ac3_bin);
+    SwitcherState *state = get_state(appsrc);
+
+    stream_metrics_set_format(state->metrics, TRUE);
+
+    if (state->selector) {
+        g_print("[FORMAT_SWITCHER] %s 대기 중인 AC3 bin으로 전환\n", state->name);
+        select_standby_bin(state, state->standby_ac3_bin, state->standby_ac3_pad, state->standby_ac3_sink,
+                           state->standby_ac3_codec);
+        return;
+    }
+
+    switch_to_new_bin(appsrc, state, codec_registry_lookup("ac3-passthrough"));
+}
+
+// 📌 PCM 입력을 AC3로 인코딩해서 보낼 때
+void switch_to_ac3_encode_pipeline(GstElement *appsrc) {
+    SwitcherState *state = get_state(appsrc);
+
+    stream_metrics_set_format(state->metrics, TRUE);
+
+    if (state->selector) {
+        g_print("[FORMAT_SWITCHER] %s 대기 중인 AC3 bin으로 전환\n", state->name);
+        select_standby_bin(state, state->standby_ac3_bin, state->standby_ac3_pad, state->standby_ac3_sink,
+                           state->standby_ac3_codec);
+        return;
+    }
+
+    switch_to_new_bin(appsrc, state, codec_registry_lookup("ac3"));
 }
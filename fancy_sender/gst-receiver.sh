@@ -1,6 +1,11 @@
 #!/bin/bash
 
-PORT=5000
+PORT=${1:-5000}
+
+# 빌드된 수신기가 있으면 그것을 쓴다: 코덱(Opus/AC3/L16)이 바뀌어도 재시작 없이 branch만 교체
+if [ -x ./receiver ]; then
+    exec ./receiver -p $PORT
+fi
 
 echo "[RECEIVER] Listening on UDP port $PORT ..."
 
@@ -9,6 +14,7 @@ gst-launch-1.0 -v udpsrc port=$PORT caps="application/x-rtp" ! \
     rtpopusdepay ! opusdec ! audioconvert ! audioresample ! autoaudiosink \
     2> >(grep --line-buffered "RTP" >&2) \
     || gst-launch-1.0 -v udpsrc port=$PORT caps="application/x-rtp" ! \
-    application/x-rtp,encoding-name=AC3,payload=96 ! \
+    application/x-rtp,encoding-name=AC3,payload=97 ! \
     rtpac3depay ! avdec_ac3 ! audioconvert ! audioresample ! autoaudiosink
-# If the first pipeline fails, it will try the second one for AC3 audio.
\ No newline at end of file
+# If the first pipeline fails, it will try the second one for AC3 audio (AC3 is sent with PT 97, Opus with 96).
+# (./receiver 를 빌드하면 위 fallback 없이 전환을 따라간다: make receiver)
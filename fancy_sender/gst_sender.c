@@ -2,99 +2,460 @@
 
 #include <gst/gst.h>
 #include <gst/app/gstappsrc.h>
+#include <glib-unix.h>
+#include <signal.h>
 #include <string.h>
+#include <stdio.h>
+
+#include "../common/feed_producer.h"
+#include "../common/latency_profile.h"
+#include "../common/stream_metrics.h"
+#include "../common/synth_source.h"
+#include "../common/thread_topology.h"
 
 // forward declarations
 void switch_to_pcm_pipeline(GstElement *appsrc);
 void switch_to_ac3_pipeline(GstElement *appsrc);
+gboolean prepare_standby_bins(GstElement *upstream, gboolean ac3_passthrough);
+gboolean format_switcher_add_destination(GstElement *upstream, const gchar *host, guint port);
+gboolean format_switcher_set_pcm_codec(GstElement *upstream, const gchar *name);
+typedef struct _CodecDescriptor CodecDescriptor;
+typedef void (*FormatSwitchedFunc)(const CodecDescriptor *codec, gpointer user_data);
+void format_switcher_set_switched_callback(GstElement *upstream, FormatSwitchedFunc func, gpointer user_data);
+
+// format_detector.c
+typedef struct _FormatDetector FormatDetector;
+typedef void (*FormatChangeFunc)(gboolean is_ac3, gpointer user_data);
+FormatDetector *format_detector_attach(GstElement *element, FormatChangeFunc func, gpointer user_data,
+                                       guint hysteresis);
+
+// send_from_file.c (--input: mmap 파일 입력, 속도는 pacer.c)
+void send_from_file_set_max_throughput(gboolean enable);
+void send_audio_file_mmap_to_appsrc(const char *filename, GstElement *appsrc, const char *format,
+                                    guint chunk_frames);
+
+// SYNTH_AC3_FRAME_BYTES 프레임 하나의 길이
+#define AC3_FRAME_DURATION (1536 * GST_SECOND / 48000) // 1536 샘플 (32 ms)
+
+// ../common/pipeline_trace.c
+gboolean pipeline_trace_init(void);
+void pipeline_trace_shutdown(void);
+
+// ../common/ring_logger.c
+void ring_logger_shutdown(void);
+
+// ../common/pcap_capture.c
+gboolean pcap_capture_open(const gchar *path);
+void pcap_capture_close(void);
+
+// ../common/rtcp_feedback.c
+gboolean rtcp_feedback_start(const gchar *host, guint peer_port, guint local_port, guint min_kbps, guint max_kbps);
+void rtcp_feedback_stop(void);
+
+// ../common/codec_registry.c
+void codec_registry_init(void);
+void codec_registry_dump(void);
+GstCaps *codec_registry_get_input_caps(const gchar *name);
+GstCaps *codec_get_input_caps(const CodecDescriptor *codec);
+
+// gui_monitor.c
+gboolean gui_monitor_start(guint refresh_ms, GSourceFunc on_quit, gpointer user_data);
+void gui_monitor_stop(void);
+
+#define DUMMY_BYTES_PER_SECOND (48000 * 2 * 2)
+#define DUMMY_AC3_START (2 * GST_SECOND) // 이 구간은 AC3 패턴 (감지기 시연)
+#define DUMMY_AC3_END (4 * GST_SECOND)
+#define FEED_LATENCY_MS 100 // 버퍼 하나 최대 0.1초 분량 (--feed-latency, 저지연 프로필은 5 ms)
+#define FEED_RING_SLOTS 4
+#define DETECT_HYSTERESIS 2 // 연속 2개 버퍼(기본 0.2초)가 같은 포맷이면 전환
+#define TOPOLOGY_REPORT_INTERVAL_S 5
+#define DEFAULT_DEST_HOST "127.0.0.1"
+#define DEFAULT_DEST_PORT 5000
 
 static GMainLoop *main_loop;
-static GstElement *pipeline, *appsrc, *typefind, *fakesink;
+static GstElement *pipeline, *appsrc;
+
+static gboolean routed_ac3 = FALSE; // 현재 연결된 경로
+static FeedProducer *feed_producer;
+static SynthSource *pcm_synth, *ac3_synth;
+static StreamMetrics *feed_metrics; // 모니터용 (appsrc 이름으로 등록, 전환기와 공유)
+
+// 명령행 옵션
+static gboolean use_standby = FALSE;
+static gchar **destinations = NULL;
+static gchar *topology_name = NULL;
+static gint monitor_ms = 0;
+static gdouble feed_latency_ms = 0.0; // 0이면 프로필 기본
+static gchar *pcm_codec_name = NULL;
+static gboolean list_codecs = FALSE;
+static gchar *pcap_path = NULL;
+static gchar *latency_profile_name = NULL;
+static gchar *abr_range = NULL;
+static gint rtcp_port = 0; // 0이면 첫 목적지 포트 + 3
+static gchar *input_path = NULL;
+static gchar *input_format = NULL;
+static gboolean max_throughput = FALSE;
+
+static GOptionEntry entries[] = {
+    { "standby", 's', 0, G_OPTION_ARG_NONE, &use_standby,
+      "PCM/AC3 bin을 미리 만들어 두고 경로만 전환 (pipeline 정지 없음)", NULL },
+    { "dest", 0, 0, G_OPTION_ARG_STRING_ARRAY, &destinations,
+      "송출 목적지 (여러 번 지정 가능, 인코딩은 한 번). 지정하지 않으면 127.0.0.1:5000", "HOST:PORT" },
+    { "topology", 't', 0, G_OPTION_ARG_STRING, &topology_name,
+      "스레드 구성: single(기본) / low-latency / throughput", "PROFILE" },
+    { "feed-latency", 0, 0, G_OPTION_ARG_DOUBLE, &feed_latency_ms,
+      "push 하나에 담는 최대 오디오 길이 ms (기본 100, 저지연 프로필 5, 2.5 가능)", "MS" },
+    { "latency-profile", 'L', 0, G_OPTION_ARG_STRING, &latency_profile_name,
+      "지연 프로필: default / low (chunk, Opus 프레임, appsrc, sink, 수신기까지 같이)", "PROFILE" },
+    { "monitor", 'm', 0, G_OPTION_ARG_INT, &monitor_ms,
+      "실시간 모니터 갱신 주기 ms (0이면 끔, 로그는 파일로 돌릴 것)", "MS" },
+    { "pcm-codec", 'c', 0, G_OPTION_ARG_STRING, &pcm_codec_name,
+      "PCM 구간을 보낼 코덱 (기본 opus, 목록은 --list-codecs)", "NAME" },
+    { "list-codecs", 0, 0, G_OPTION_ARG_NONE, &list_codecs, "등록된 코덱 목록", NULL },
+    { "pcap", 0, 0, G_OPTION_ARG_FILENAME, &pcap_path,
+      "송출 패킷을 pcap 파일로 기록 (전환 포함, pcap_replay로 재생)", "FILE" },
+    { "abr", 0, 0, G_OPTION_ARG_STRING, &abr_range,
+      "RTCP 수신 보고로 Opus bitrate/FEC 조정, 범위 kbps (예: 16:128, 수신기는 --rtcp)", "MIN:MAX" },
+    { "rtcp-port", 0, 0, G_OPTION_ARG_INT, &rtcp_port,
+      "RR을 받을 로컬 RTCP 포트 (기본: 첫 목적지 포트 + 3)", "PORT" },
+    { "input", 'i', 0, G_OPTION_ARG_FILENAME, &input_path,
+      "테스트 신호 대신 파일을 mmap으로 읽어 보냄 (48 kHz stereo S16LE 또는 AC3), 끝나면 종료", "FILE" },
+    { "input-format", 0, 0, G_OPTION_ARG_STRING, &input_format,
+      "--input 형식: pcm / ac3 (기본: 확장자 .ac3면 ac3, 아니면 pcm)", "FORMAT" },
+    { "max-throughput", 0, 0, G_OPTION_ARG_NONE, &max_throughput,
+      "--input을 실시간 속도 대신 downstream이 받는 만큼 최대한 빨리 보냄 (pacer 벤치마크용)", NULL },
+    { NULL }
+};
+
+// 📌 appsrc caps를 감지된 포맷으로 (AC3는 압축 그대로 passthrough)
+// caps는 등록부가 미리 만들어 둔 것 (raw 입력 caps는 모든 raw 코덱이 같다)
+static void set_appsrc_caps(gboolean is_ac3) {
+    g_object_set(appsrc, "caps", codec_registry_get_input_caps(is_ac3 ? "ac3-passthrough" : "opus"), NULL);
+}
+
+// 📌 전환 뒤 새 caps를 appsrc 출력의 데이터 흐름 안에서 보낸다 (appsrc src pad probe, 스트리밍 스레드)
+//  - caps 이벤트: 새 bin에 다시 보내지는 이전 sticky caps를 새 코덱 입력 caps로 바꿔 보낸다 (receiver.c branch와 같은 방식)
+//  - 첫 버퍼: 그 앞에 새 caps 이벤트를 보내고 probe를 뗀다 (대기 모드 selector 쪽은 다시 보내지는 caps가 없다)
+static GstPadProbeReturn on_switched_output(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    GstCaps *caps = user_data;
 
-static gboolean first_format_detected = FALSE;
+    if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        GstEvent *event = GST_PAD_PROBE_INFO_EVENT(info);
 
-// 📌 typefind 콜백
-static void on_have_type(GstElement *src, guint prob, GstCaps *caps, gpointer user_data) {
-    if (first_format_detected) return; // 첫 포맷 감지 후 무시
-    first_format_detected = TRUE;
+        if (GST_EVENT_TYPE(event) == GST_EVENT_CAPS) {
+            gst_event_unref(event);
+            GST_PAD_PROBE_INFO_DATA(info) = gst_event_new_caps(caps);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    gst_pad_push_event(pad, gst_event_new_caps(caps));
+    return GST_PAD_PROBE_REMOVE;
+}
 
-    gchar *type = gst_caps_to_string(caps);
-    g_print("[TYPEFIND] 감지된 포맷: %s\n", type);
+// 📌 전환 완료 (새 bin이 연결된 뒤, live swap이면 appsrc src pad의 IDLE probe 안)
+// caps는 여기서 바꿔야 이전 bin이 새 포맷 caps를 받지 않는다. appsrc 큐에 남은 버퍼는 감지 이후의
+// 데이터라 이미 새 포맷이므로, 큐 뒤에 들어가는 appsrc caps를 기다리지 않고 다음 버퍼 앞에서 caps 이벤트로 보낸다
+static void on_format_switched(const CodecDescriptor *codec, gpointer user_data) {
+    GstCaps *caps = codec_get_input_caps(codec);
+    GstPad *pad = gst_element_get_static_pad(appsrc, "src");
+
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM | GST_PAD_PROBE_TYPE_BUFFER |
+                      GST_PAD_PROBE_TYPE_BUFFER_LIST,
+                      on_switched_output, gst_caps_ref(caps), (GDestroyNotify)gst_caps_unref);
+    gst_object_unref(pad);
+    gst_app_src_set_caps(GST_APP_SRC(appsrc), caps); // 이후 버퍼용 (appsrc가 같은 caps는 다시 보내지 않는다)
+}
 
-    if (g_str_has_prefix(type, "audio/ac3")) {
+// 📌 포맷 감지기 콜백 (main loop에서 호출됨). appsrc caps는 전환이 끝난 뒤 on_format_switched에서
+static void on_format_change(gboolean is_ac3, gpointer user_data) {
+    g_print("[DETECT] 감지된 포맷: %s\n", is_ac3 ? "AC3" : "PCM");
+    if (is_ac3 == routed_ac3) return; // 이미 해당 경로
+
+    if (is_ac3) {
         g_print("[SWITCH] AC3 pipeline으로 전환합니다.\n");
         switch_to_ac3_pipeline(appsrc);
     } else {
         g_print("[SWITCH] PCM pipeline으로 전환합니다.\n");
         switch_to_pcm_pipeline(appsrc);
     }
+    routed_ac3 = is_ac3;
+}
 
-    g_free(type);
+// 📌 생산자 스레드에서 테스트 데이터 한 chunk 생성 (push는 feed_producer가 need-data에 맞춰서)
+// 2~4초 구간은 AC3 패턴 (0x0B77로 시작하는 sync frame 연속), 나머지는 440Hz PCM
+// AC3는 완전한 프레임만 넣고 길이도 프레임 수로 (프레임당 1536 샘플, PCM 바이트 수로 계산하면 몇 배 빨리 나간다)
+static gsize fill_dummy_chunk(guint8 *data, gsize max_size, GstClockTime max_duration,
+                              GstClockTime *duration, gpointer user_data) {
+    static GstClockTime position = 0;
+    guint64 cpu_start = stream_metrics_thread_cpu_ns();
+    guint64 frames;
+    gsize size;
+
+    if (position >= DUMMY_AC3_START && position < DUMMY_AC3_END) {
+        frames = MIN(max_size / SYNTH_AC3_FRAME_BYTES, max_duration / AC3_FRAME_DURATION);
+        frames = MAX(frames, 1); // 지연 목표가 프레임보다 짧아도 한 프레임은
+        if (frames * SYNTH_AC3_FRAME_BYTES > max_size) return 0;
+        size = frames * SYNTH_AC3_FRAME_BYTES;
+        synth_source_fill(ac3_synth, data, size);
+        *duration = frames * AC3_FRAME_DURATION;
+    } else {
+        frames = MIN(max_size / 4, gst_util_uint64_scale(max_duration, 48000, GST_SECOND));
+        size = frames * 4;
+        if (size == 0) return 0;
+        synth_source_fill(pcm_synth, data, size);
+        *duration = gst_util_uint64_scale(frames, GST_SECOND, 48000);
+    }
+    position += *duration;
+
+    stream_metrics_set_queue_level(feed_metrics, gst_app_src_get_current_level_bytes(GST_APP_SRC(appsrc)));
+    stream_metrics_add_cpu(feed_metrics, stream_metrics_thread_cpu_ns() - cpu_start);
+    return size;
+}
+
+static gboolean on_monitor_quit(gpointer data) {
+    g_main_loop_quit(main_loop);
+    return G_SOURCE_REMOVE;
 }
 
-// 📌 테스트용 데이터 푸시 타이머 (초기에는 0.1초에 한번씩 push)
-static gboolean feed_dummy_data(gpointer data) {
-    static int counter = 0;
-    guint size = 48000 * 2 * 2 / 10; // 0.1초 분량
+// 📌 SIGINT/SIGTERM (Ctrl+C, timeout): main loop를 끝내고 아래 정리 경로로 (출력도 끝까지 남는다)
+static gboolean on_quit_signal(gpointer data) {
+    g_print("[SENDER] 종료 신호 (%s), 정리 후 끝냄\n", (const gchar *)data);
+    g_main_loop_quit(main_loop);
+    return G_SOURCE_CONTINUE;
+}
+
+// 📌 --input: 파일 전송 스레드 (chunk 경계는 send_from_file.c가 PCM period / AC3 프레임으로 맞춘다)
+// 다 보내면 EOS → bus watch가 main loop를 끝낸다. 중간에 종료되면 push가 FLUSHING으로 실패해서 빠져나온다
+static gpointer file_feed_thread(gpointer data) {
+    const gchar *format = data;
+
+    send_audio_file_mmap_to_appsrc(input_path, appsrc, format, 0);
+    gst_app_src_end_of_stream(GST_APP_SRC(appsrc));
+    return NULL;
+}
 
-    GstBuffer *buffer;
-    guint8 *raw_data = g_malloc0(size);
-    GstFlowReturn ret;
+static gboolean on_bus_message(GstBus *bus, GstMessage *msg, gpointer data) {
+    if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS) {
+        g_print("[SENDER] 입력 파일 끝\n");
+        g_main_loop_quit(main_loop);
+    } else if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
+        GError *err = NULL;
 
-    // 샘플값 (AC3 패턴 넣기: 0x0B77)
-    if (counter >= 20 && counter < 40) {
-        raw_data[0] = 0x0B;
-        raw_data[1] = 0x77;
+        gst_message_parse_error(msg, &err, NULL);
+        g_printerr("[SENDER] 에러: %s\n", err->message);
+        g_error_free(err);
+        g_main_loop_quit(main_loop);
     }
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_topology_report(gpointer data) {
+    static guint64 last_dropped = 0;
+    FeedProducerStats stats;
 
-    buffer = gst_buffer_new_wrapped(g_memdup(raw_data, size), size);
-    g_signal_emit_by_name(appsrc, "push-buffer", buffer, &ret);
-    gst_buffer_unref(buffer);
-    g_free(raw_data);
+    thread_topology_report();
+    if (!feed_producer) return G_SOURCE_CONTINUE; // --input: 파일 전송 스레드가 보낸다
+    feed_producer_report(feed_producer);
 
-    counter++;
-    return TRUE;
+    // 생산자가 버린 chunk를 모니터 drop으로
+    feed_producer_get_stats(feed_producer, &stats);
+    stream_metrics_add_drops(feed_metrics, stats.dropped - last_dropped);
+    last_dropped = stats.dropped;
+    return G_SOURCE_CONTINUE;
+}
+
+// 📌 --abr: 첫 목적지의 RTCP 포트(RTP + 1)로 SR, RR은 --rtcp-port(기본 RTP + 3)에서
+static gboolean start_rtcp_feedback(void) {
+    guint min_kbps, max_kbps;
+    guint64 port = DEFAULT_DEST_PORT;
+    gchar *host = g_strdup(DEFAULT_DEST_HOST);
+    gboolean ok;
+
+    if (sscanf(abr_range, "%u:%u", &min_kbps, &max_kbps) != 2 || !min_kbps || !max_kbps) {
+        g_printerr("잘못된 --abr 범위: %s (예: 16:128)\n", abr_range);
+        g_free(host);
+        return FALSE;
+    }
+    if (destinations && destinations[0]) {
+        gchar *colon = strrchr(destinations[0], ':');
+
+        if (colon && g_ascii_string_to_unsigned(colon + 1, 10, 1, 65532, &port, NULL)) {
+            g_free(host);
+            host = g_strndup(destinations[0], colon - destinations[0]);
+        }
+    }
+    ok = rtcp_feedback_start(host, (guint)port + 1, rtcp_port > 0 ? (guint)rtcp_port : (guint)port + 3,
+                             min_kbps, max_kbps);
+    g_free(host);
+    return ok;
 }
 
 int main(int argc, char *argv[]) {
+    GOptionContext *context;
+    GError *error = NULL;
+    GThread *file_thread = NULL;
+    const gchar *file_format = NULL;
+    TopologyProfile topology = TOPOLOGY_SINGLE_THREAD;
+    LatencyProfile latency = LATENCY_DEFAULT;
+    guint chunk_us;
+
     gst_init(&argc, &argv);
+
+    context = g_option_context_new("- PCM/AC3 포맷 전환 송신기");
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("옵션 파싱 실패: %s\n", error->message);
+        g_error_free(error);
+        g_option_context_free(context);
+        return -1;
+    }
+    g_option_context_free(context);
+
+    if (topology_name && !thread_topology_parse(topology_name, &topology)) {
+        g_printerr("알 수 없는 스레드 구성: %s\n", topology_name);
+        return -1;
+    }
+    thread_topology_configure(topology);
+    if (latency_profile_name && !latency_profile_parse(latency_profile_name, &latency)) {
+        g_printerr("알 수 없는 지연 프로필: %s\n", latency_profile_name);
+        return -1;
+    }
+    if (input_path) {
+        if (!input_format) input_format = g_strdup(g_str_has_suffix(input_path, ".ac3") ? "ac3" : "pcm");
+        if (g_ascii_strcasecmp(input_format, "pcm") == 0) file_format = "PCM";
+        else if (g_ascii_strcasecmp(input_format, "ac3") == 0) file_format = "AC3";
+        else {
+            g_printerr("알 수 없는 입력 형식: %s (pcm / ac3)\n", input_format);
+            return -1;
+        }
+        send_from_file_set_max_throughput(max_throughput);
+    } else if (max_throughput) {
+        g_printerr("--max-throughput은 --input과 함께 써야 함\n");
+        return -1;
+    }
+    // 0이면 프로필 기본, 그 밖에는 basic_sender와 같은 범위만 (음수/NaN/큰 값은 guint로 바꾸기 전에 거른다)
+    if (feed_latency_ms != 0.0 && !(feed_latency_ms >= 0.25 && feed_latency_ms <= 1000.0)) {
+        g_printerr("잘못된 --feed-latency: %g ms (0.25~1000)\n", feed_latency_ms);
+        return -1;
+    }
+    // --feed-latency를 주면 저지연 프로필의 chunk도 그 값으로 (2.5~10 ms로 제한)
+    latency_profile_configure(latency, (guint)(feed_latency_ms * 1000));
+    chunk_us = feed_latency_ms > 0 ? (guint)(feed_latency_ms * 1000) : FEED_LATENCY_MS * 1000;
+    chunk_us = latency_profile_chunk_us(chunk_us);
+    codec_registry_init(); // 코덱 factory/caps를 전환 전에 미리
+    if (list_codecs) {
+        codec_registry_dump();
+        return 0;
+    }
+    pipeline_trace_init(); // PIPELINE_TRACE 환경 변수가 있을 때만
+    if (pcap_path && !pcap_capture_open(pcap_path)) return -1; // 첫 bin을 만들기 전에
+    if (abr_range && !start_rtcp_feedback()) return -1;         // 첫 opusenc를 만들기 전에
+
     main_loop = g_main_loop_new(NULL, FALSE);
+    g_unix_signal_add(SIGINT, on_quit_signal, "SIGINT");
+    g_unix_signal_add(SIGTERM, on_quit_signal, "SIGTERM");
 
     pipeline = gst_pipeline_new("detect-pipeline");
     appsrc = gst_element_factory_make("appsrc", "mysrc");
-    typefind = gst_element_factory_make("typefind", "typefinder");
-    fakesink = gst_element_factory_make("fakesink", "fakesink");
+    feed_metrics = stream_metrics_register("mysrc");
 
-    if (!pipeline || !appsrc || !typefind || !fakesink) {
+    if (!pipeline || !appsrc) {
         g_printerr("요소 생성 실패\n");
         return -1;
     }
 
-    // appsrc 설정
+    // appsrc 설정 (타임스탬프: queue 채움/종단 지연 측정의 기준)
     g_object_set(appsrc,
         "format", GST_FORMAT_TIME,
         "is-live", TRUE,
-        "block", TRUE,
+        "do-timestamp", TRUE,
         NULL);
+    set_appsrc_caps(FALSE);
+    latency_profile_tune_appsrc(appsrc, chunk_us); // 저지연 프로필: min-latency = chunk
 
-    // typefind 시그널 연결
-    g_signal_connect(typefind, "have-type", G_CALLBACK(on_have_type), NULL);
+    // 파이프라인 구성 (처음에는 PCM 경로)
+    // 기본: appsrc → PCM 코덱 bin (포맷이 바뀌면 live swap으로 교체)
+    // 대기 모드: appsrc → output-selector → {PCM 코덱 bin, AC3 passthrough bin}
+    gst_bin_add(GST_BIN(pipeline), appsrc);
+    if (pcm_codec_name && !format_switcher_set_pcm_codec(appsrc, pcm_codec_name)) return -1;
+    format_switcher_set_switched_callback(appsrc, on_format_switched, NULL);
+    if (use_standby) {
+        if (!prepare_standby_bins(appsrc, TRUE)) {
+            g_printerr("파이프라인 연결 실패\n");
+            return -1;
+        }
+    } else {
+        switch_to_pcm_pipeline(appsrc);
+    }
 
-    // 파이프라인 구성
-    gst_bin_add_many(GST_BIN(pipeline), appsrc, typefind, fakesink, NULL);
-    if (!gst_element_link_many(appsrc, typefind, fakesink, NULL)) {
-        g_printerr("파이프라인 연결 실패\n");
-        return -1;
+    // 목적지 목록 (전환으로 새로 만드는 bin에도 그대로 적용됨)
+    for (gint i = 0; destinations && destinations[i]; i++) {
+        gchar *colon = strrchr(destinations[i], ':');
+        guint64 port;
+
+        if (!colon || !g_ascii_string_to_unsigned(colon + 1, 10, 1, 65535, &port, NULL)) {
+            g_printerr("잘못된 목적지: %s\n", destinations[i]);
+            continue;
+        }
+        *colon = '\0';
+        format_switcher_add_destination(appsrc, destinations[i], (guint)port);
+    }
+
+    // 모든 버퍼를 검사하는 포맷 감지기 (전환 이벤트는 main loop로)
+    format_detector_attach(appsrc, on_format_change, NULL, DETECT_HYSTERESIS);
+
+    pcm_synth = synth_source_new(SYNTH_SINE, 48000, 2, 440.0, 0.5);
+    ac3_synth = synth_source_new(SYNTH_AC3_BURST, 48000, 2, 0.0, 1.0);
+
+    if (input_path) {
+        // 파일 입력: 전송 스레드는 PLAYING이 된 뒤에 (pacer가 pipeline clock을 쓴다)
+        GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline));
+
+        gst_bus_add_watch(bus, on_bus_message, NULL);
+        gst_object_unref(bus);
+    } else {
+        // 입력 생성은 전용 스레드에서 실시간 속도로, push는 need-data ~ enough-data 사이에만
+        // (appsrc는 block=FALSE, max-bytes = chunk 2개. downstream이 밀리면 chunk를 버림)
+        FeedProducerConfig config = {
+            .ring_slots = FEED_RING_SLOTS,
+            .latency_us = chunk_us,
+            // PCM chunk 크기, 단 AC3 프레임 하나보다 작지 않게
+            .max_chunk = MAX((gsize)DUMMY_BYTES_PER_SECOND * chunk_us / G_USEC_PER_SEC, SYNTH_AC3_FRAME_BYTES),
+            .realtime = TRUE,
+        };
+        feed_producer = feed_producer_start(appsrc, &config, fill_dummy_chunk, NULL);
+        if (!feed_producer) return -1;
     }
 
     gst_element_set_state(pipeline, GST_STATE_PLAYING);
-    g_timeout_add(100, feed_dummy_data, NULL);
+    if (input_path) file_thread = g_thread_new("file-feed", file_feed_thread, (gpointer)file_format);
+    g_timeout_add_seconds(TOPOLOGY_REPORT_INTERVAL_S, on_topology_report, NULL);
+    if (monitor_ms > 0)
+        gui_monitor_start(monitor_ms, on_monitor_quit, NULL); // [q]로 종료
 
     g_main_loop_run(main_loop);
 
+    gui_monitor_stop();
     // 정리
     gst_element_set_state(pipeline, GST_STATE_NULL);
+    if (file_thread) g_thread_join(file_thread);
+    feed_producer_stop(feed_producer);
     gst_object_unref(pipeline);
+    pipeline_trace_shutdown();
+    pcap_capture_close();
+    rtcp_feedback_stop();
+    ring_logger_shutdown(); // 스트리밍 스레드가 남긴 로그 출력
+    synth_source_free(pcm_synth);
+    synth_source_free(ac3_synth);
+    g_strfreev(destinations);
+    g_free(topology_name);
+    g_free(pcm_codec_name);
+    g_free(pcap_path);
+    g_free(latency_profile_name);
+    g_free(abr_range);
+    g_free(input_path);
+    g_free(input_format);
     g_main_loop_unref(main_loop);
     return 0;
 }
@@ -1,38 +1,183 @@
 // gui_monitor.c
-
+/*
+ * 송신 상태 실시간 모니터 (ncurses)
+ *
+ * 모니터는 자기 스레드에서 고정 주기로 ../common/stream_metrics.c 스냅샷을 읽어 그린다.
+ * 스트리밍/생산자 쪽은 원자 카운터만 올리므로 터미널 출력이 늦어져도 송신은 기다리지 않는다.
+ * 화면은 clear() 없이 줄마다 덮어쓰고(clrtoeol) refresh()가 바뀐 부분만 내보낸다.
+ *
+ * 표시: 세션별 포맷, kbps, pps, 전환 횟수/마지막 전환 간격, 종단 지연, appsrc 대기량, drop, CPU%
+ *       + 단계(convert/encode/send) 경계 queue 대기 시간 (../common/thread_topology.c)
+ *
+ * 화면은 /dev/tty에 그리므로 로그는 파일로 돌려 두면 섞이지 않는다:
+ *   ./gst_sender --monitor > sender.log 2>&1
+ *
+ * 사용:
+ *   gui_monitor_start(500, on_quit, loop);   // [q]를 누르면 main loop에서 on_quit 호출
+ *   gui_monitor_stop();
+ */
+#include <gst/gst.h>
 #include <ncurses.h>
-#include <stdlib.h>
+#include <locale.h>
+#include <stdio.h>
 
-static int gui_enabled = 0;
+#include "../common/stream_metrics.h"
+#include "../common/thread_topology.h"
 
-void gui_init() {
-    initscr();
-    cbreak();
-    noecho();
-    timeout(0);
-    gui_enabled = 1;
+#define MONITOR_MAX_STREAMS 256
+#define MONITOR_FIRST_ROW 6
+
+static GThread *monitor_thread = NULL;
+static GMutex monitor_lock;
+static GCond monitor_cond;
+static gboolean monitor_running = FALSE;
+
+static guint refresh_us = 0;
+static GSourceFunc quit_func = NULL;
+static gpointer quit_data = NULL;
+
+// 모니터 스레드 전용
+static StreamMetricsSnapshot snaps[2][MONITOR_MAX_STREAMS];
+
+static void draw_header(void) {
+    attron(A_BOLD);
+    mvprintw(0, 2, "🎧 GStreamer 송신 상태 모니터");
+    attroff(A_BOLD);
+    mvprintw(1, 2, "%u ms마다 갱신, [q]를 누르면 종료됩니다.", refresh_us / 1000);
+    attron(A_REVERSE);
+    mvprintw(MONITOR_FIRST_ROW - 1, 0, "%-20s %-4s %9s %8s %5s %9s %9s %9s %7s %6s",
+             "stream", "fmt", "kbps", "pps", "sw", "gap ms", "e2e ms", "appsrc KB", "drops", "cpu%");
+    attroff(A_REVERSE);
 }
 
-void gui_update(const char *format, int buffer_count) {
-    if (!gui_enabled) return;
+// 📌 한 번 그리기: 이전 스냅샷과의 차이로 속도 계산
+static void draw(const StreamMetricsSnapshot *cur, const StreamMetricsSnapshot *prev,
+                 guint n, guint prev_n, gdouble elapsed_s) {
+    guint64 stage_ns[STAGE_COUNT];
+    guint rows = MAX(LINES - MONITOR_FIRST_ROW - 2, 1);
+    gdouble total_kbps = 0.0, total_pps = 0.0, total_cpu = 0.0;
+    guint64 total_drops = 0;
+    guint shown = MIN(n, rows);
 
-    clear();
-    mvprintw(1, 2, "🎧 GStreamer 송신 상태 모니터");
-    mvprintw(3, 4, "현재 포맷      : %s", format);
-    mvprintw(4, 4, "버퍼 전송 횟수 : %d", buffer_count);
-    mvprintw(6, 2, "[q]를 누르면 종료됩니다.");
-    refresh();
+    thread_topology_get_latency(stage_ns);
+    mvprintw(3, 2, "queue 대기: convert %6.1f ms | encode %6.1f ms | send %6.1f ms",
+             stage_ns[0] / 1e6, stage_ns[1] / 1e6, stage_ns[2] / 1e6);
+    clrtoeol();
 
-    int ch = getch();
-    if (ch == 'q') {
-        endwin();
-        exit(0);
+    for (guint i = 0; i < n; i++) {
+        // 등록 목록은 뒤에 추가만 되므로 같은 위치가 같은 스트림
+        const StreamMetricsSnapshot *s = &cur[i];
+        const StreamMetricsSnapshot *p = i < prev_n ? &prev[i] : s;
+        gdouble kbps = (s->bytes - p->bytes) * 8.0 / 1000.0 / elapsed_s;
+        gdouble pps = (s->packets - p->packets) / elapsed_s;
+        gdouble cpu = (s->cpu_ns - p->cpu_ns) / 1e9 / elapsed_s * 100.0;
+
+        total_kbps += kbps;
+        total_pps += pps;
+        total_cpu += cpu;
+        total_drops += s->drops;
+        if (i >= shown) continue;
+
+        mvprintw(MONITOR_FIRST_ROW + i, 0, "%-20.20s %-4s %9.1f %8.0f %5" G_GUINT64_FORMAT " %9.2f %9.2f %9.1f %7"
+                 G_GUINT64_FORMAT " %6.1f",
+                 s->name, s->is_ac3 ? "AC3" : "PCM", kbps, pps, s->switches,
+                 s->last_switch_gap_us / 1000.0, s->latency_us / 1000.0, s->queue_bytes / 1024.0,
+                 s->drops, cpu);
+        clrtoeol();
     }
+
+    attron(A_BOLD);
+    mvprintw(MONITOR_FIRST_ROW + shown, 0, "%-20s %-4s %9.1f %8.0f %5s %9s %9s %9s %7" G_GUINT64_FORMAT " %6.1f",
+             n > shown ? "합계 (일부만 표시)" : "합계", "", total_kbps, total_pps, "", "", "", "",
+             total_drops, total_cpu);
+    attroff(A_BOLD);
+    clrtobot(); // 세션 수가 줄었을 때 남은 줄
+    refresh();
 }
 
-void gui_close() {
-    if (gui_enabled) {
-        endwin();
-        gui_enabled = 0;
+static gpointer monitor_thread_func(gpointer data) {
+    FILE *tty = fopen("/dev/tty", "r+");
+    SCREEN *screen;
+    guint cur = 0, prev_n = 0;
+    gint64 last_us, deadline;
+    gboolean quit_sent = FALSE;
+
+    if (!tty) {
+        g_printerr("[MONITOR] /dev/tty 열기 실패, 모니터 없이 계속\n");
+        return NULL;
+    }
+    screen = newterm(NULL, tty, tty);
+    if (!screen) {
+        g_printerr("[MONITOR] 터미널 초기화 실패, 모니터 없이 계속\n");
+        fclose(tty);
+        return NULL;
+    }
+    set_term(screen);
+    cbreak();
+    noecho();
+    curs_set(0);
+    nodelay(stdscr, TRUE);
+    draw_header();
+
+    prev_n = stream_metrics_snapshot(snaps[1], MONITOR_MAX_STREAMS);
+    last_us = g_get_monotonic_time();
+    deadline = last_us;
+
+    g_mutex_lock(&monitor_lock);
+    while (monitor_running) {
+        gint64 now;
+        guint n;
+
+        // 고정 주기 (그리기에 걸린 시간만큼 다음 대기를 줄인다)
+        deadline += refresh_us;
+        while (monitor_running && g_cond_wait_until(&monitor_cond, &monitor_lock, deadline))
+            ;
+        if (!monitor_running) break;
+        g_mutex_unlock(&monitor_lock);
+
+        n = stream_metrics_snapshot(snaps[cur], MONITOR_MAX_STREAMS);
+        now = g_get_monotonic_time();
+        draw(snaps[cur], snaps[cur ^ 1], n, prev_n, MAX(now - last_us, 1) / 1e6);
+        last_us = now;
+        prev_n = n;
+        cur ^= 1;
+        if (now > deadline + refresh_us) deadline = now; // 많이 밀렸으면 따라잡지 않고 다시 시작
+
+        if (getch() == 'q' && !quit_sent && quit_func) {
+            g_idle_add(quit_func, quit_data);
+            quit_sent = TRUE;
+        }
+        g_mutex_lock(&monitor_lock);
     }
+    g_mutex_unlock(&monitor_lock);
+
+    endwin();
+    delscreen(screen);
+    fclose(tty);
+    return NULL;
+}
+
+// 📌 모니터 시작. refresh_ms: 갱신 주기, on_quit: [q]를 누르면 main loop에서 한 번 호출
+gboolean gui_monitor_start(guint refresh_ms, GSourceFunc on_quit, gpointer user_data) {
+    if (monitor_thread) return TRUE;
+
+    setlocale(LC_ALL, ""); // 한글 출력 (ncursesw)
+    refresh_us = MAX(refresh_ms, 50) * 1000;
+    quit_func = on_quit;
+    quit_data = user_data;
+    monitor_running = TRUE;
+    monitor_thread = g_thread_new("gui-monitor", monitor_thread_func, NULL);
+    return monitor_thread != NULL;
+}
+
+void gui_monitor_stop(void) {
+    if (!monitor_thread) return;
+
+    g_mutex_lock(&monitor_lock);
+    monitor_running = FALSE;
+    g_cond_signal(&monitor_cond);
+    g_mutex_unlock(&monitor_lock);
+
+    g_thread_join(monitor_thread);
+    monitor_thread = NULL;
 }
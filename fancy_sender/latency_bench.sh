@@ -0,0 +1,41 @@
+#!/bin/bash
+# latency_bench.sh
+# 기본 프로필과 저지연 프로필(-L low)의 glass-to-glass 지연 비교 (같은 호스트, loopback)
+# 송신기 capture 시각은 저지연 프로필에서만 패킷에 붙으므로 기본 프로필 줄은 jitterbuffer 지연만 나온다
+#
+# 사용: bash latency_bench.sh [실행 시간 초] [포트] [receiver 추가 옵션]
+#       bash latency_bench.sh 20 5000 --null      # 오디오 장치 없이 (재생 시각 = sink 도착 시각)
+
+DURATION=${1:-20}
+PORT=${2:-5000}
+shift 2 2>/dev/null
+RX_OPTS="$*"
+SENDER=./gst_sender
+RECEIVER=./receiver
+
+for BIN in "$SENDER" "$RECEIVER"; do
+    if [ ! -x "$BIN" ]; then
+        echo "$BIN 없음 (make 먼저)" >&2
+        exit 1
+    fi
+done
+
+field() {
+    echo "$1" | tr ' ' '\n' | grep "^$2=" | cut -d= -f2
+}
+
+printf "%-8s %14s %14s %12s %12s\n" "profile" "jb_avg_ms" "jb_max_ms" "g2g_avg_ms" "g2g_max_ms"
+
+for PROFILE in default low; do
+    out=$(mktemp)
+    $RECEIVER -p "$PORT" -L $PROFILE -d "$DURATION" -r 0 $RX_OPTS > "$out" 2>/dev/null &
+    rx=$!
+    sleep 1
+    timeout "$((DURATION - 2))" $SENDER --dest "127.0.0.1:$PORT" -L $PROFILE > /dev/null 2>&1
+    wait $rx
+    line=$(grep '^RESULT' "$out")
+    rm -f "$out"
+    printf "%-8s %14s %14s %12s %12s\n" "$PROFILE" \
+        "$(field "$line" jb_avg_ms)" "$(field "$line" jb_max_ms)" \
+        "$(field "$line" g2g_avg_ms)" "$(field "$line" g2g_max_ms)"
+done
@@ -0,0 +1,194 @@
+// live_swap.c
+/*
+ * 데이터가 흐르는 중에 appsrc 뒤의 bin을 교체한다.
+ *
+ * 1. 새 bin을 pipeline에 넣고 PLAYING으로 맞춰 둔다 (아직 연결 안 됨)
+ * 2. appsrc src pad에 IDLE probe → 버퍼가 지나가지 않는 순간에 old → new 재연결
+ *    (old는 그 순간 실제로 연결된 bin. 앞선 교체가 아직 끝나지 않았어도 차례대로 이어진다)
+ * 3. 이전 bin은 백그라운드 스레드에서 EOS로 비운 뒤 NULL 상태로 만들고 제거
+ *
+ * IDLE 시점에 링크만 바꾸므로 경계의 버퍼는 정확히 한쪽 bin으로만 간다 (유실/중복 없음).
+ *
+ * 재연결은 비동기라서 결과는 done 콜백으로 알린다 (성공/실패 모두 정확히 한 번).
+ * 실패하면 new_bin은 pipeline에서 빠지고 해제되므로, 호출자는 성공 콜백을 받은 뒤에만
+ * new_bin을 현재 bin으로 기억해야 한다. 콜백은 IDLE probe 안(스트리밍 스레드)이나
+ * pad가 이미 idle이면 live_swap_bin 안에서 바로 불린다.
+ */
+#include <gst/gst.h>
+
+#define DRAIN_TIMEOUT_US (2 * G_TIME_SPAN_SECOND)
+
+typedef void (*LiveSwapDoneFunc)(GstElement *new_bin, gboolean ok, gpointer user_data);
+
+typedef struct {
+    GstElement *pipeline;
+    GstElement *old_bin;     // IDLE probe에서 정해진다
+    GstElement *new_bin;
+    LiveSwapDoneFunc done;
+    gpointer user_data;
+
+    // 이전 bin의 EOS 도착 대기
+    GMutex lock;
+    GCond cond;
+    gboolean drained;
+} SwapContext;
+
+static GThreadPool *dispose_pool = NULL;
+
+static void swap_context_free(SwapContext *ctx) {
+    gst_object_unref(ctx->pipeline);
+    if (ctx->old_bin) gst_object_unref(ctx->old_bin);
+    gst_object_unref(ctx->new_bin);
+    g_mutex_clear(&ctx->lock);
+    g_cond_clear(&ctx->cond);
+    g_free(ctx);
+}
+
+// 📌 이전 bin 마지막 sink에 EOS가 도착하면 버리고 백그라운드 스레드를 깨운다
+static GstPadProbeReturn on_old_bin_eos(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    SwapContext *ctx = user_data;
+
+    if (GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info)) != GST_EVENT_EOS)
+        return GST_PAD_PROBE_OK;
+
+    g_mutex_lock(&ctx->lock);
+    ctx->drained = TRUE;
+    g_cond_signal(&ctx->cond);
+    g_mutex_unlock(&ctx->lock);
+
+    // pipeline 전체 EOS로 번지지 않도록 버림
+    return GST_PAD_PROBE_DROP;
+}
+
+// 📌 백그라운드 스레드: 이전 bin 비우기 → NULL → 제거
+static void dispose_old_bin(gpointer data, gpointer user_data) {
+    SwapContext *ctx = data;
+    GstPad *bin_sink = gst_element_get_static_pad(ctx->old_bin, "sink");
+    GstIterator *it = gst_bin_iterate_sinks(GST_BIN(ctx->old_bin));
+    GValue item = G_VALUE_INIT;
+    GstPad *last_sink_pad = NULL;
+    gulong probe_id = 0;
+
+    if (gst_iterator_next(it, &item) == GST_ITERATOR_OK) {
+        GstElement *sink = g_value_get_object(&item);
+        last_sink_pad = gst_element_get_static_pad(sink, "sink");
+        probe_id = gst_pad_add_probe(last_sink_pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+                                     on_old_bin_eos, ctx, NULL);
+        g_value_unset(&item);
+    }
+    gst_iterator_free(it);
+
+    // 남아 있는 데이터(인코더 지연분 등)를 EOS로 밀어낸다
+    gst_pad_send_event(bin_sink, gst_event_new_eos());
+    gst_object_unref(bin_sink);
+
+    if (last_sink_pad) {
+        gint64 deadline = g_get_monotonic_time() + DRAIN_TIMEOUT_US;
+
+        g_mutex_lock(&ctx->lock);
+        while (!ctx->drained) {
+            if (!g_cond_wait_until(&ctx->cond, &ctx->lock, deadline)) {
+                g_printerr("[LIVE_SWAP] %s EOS 대기 시간 초과, 강제 제거\n",
+                           GST_ELEMENT_NAME(ctx->old_bin));
+                break;
+            }
+        }
+        g_mutex_unlock(&ctx->lock);
+
+        gst_pad_remove_probe(last_sink_pad, probe_id);
+        gst_object_unref(last_sink_pad);
+    }
+
+    gst_element_set_state(ctx->old_bin, GST_STATE_NULL);
+    gst_bin_remove(GST_BIN(ctx->pipeline), ctx->old_bin);
+    g_print("[LIVE_SWAP] 이전 bin 정리 완료: %s\n", GST_ELEMENT_NAME(ctx->old_bin));
+
+    swap_context_free(ctx);
+}
+
+// 📌 교체 실패: new_bin을 pipeline에서 빼고 알린 뒤 해제 (호출자는 new_bin을 더 쓰지 않는다)
+static void discard_new_bin(SwapContext *ctx) {
+    gst_element_set_state(ctx->new_bin, GST_STATE_NULL);
+    gst_bin_remove(GST_BIN(ctx->pipeline), ctx->new_bin);
+    if (ctx->done) ctx->done(ctx->new_bin, FALSE, ctx->user_data);
+    swap_context_free(ctx);
+}
+
+// 📌 IDLE probe: 흐르는 버퍼가 없는 순간 (지금 연결된) old → new 재연결
+static GstPadProbeReturn on_src_idle(GstPad *srcpad, GstPadProbeInfo *info, gpointer user_data) {
+    SwapContext *ctx = user_data;
+    GstPad *old_sink = gst_pad_get_peer(srcpad);
+    GstPad *new_sink = gst_element_get_static_pad(ctx->new_bin, "sink");
+
+    if (old_sink) {
+        ctx->old_bin = gst_pad_get_parent_element(old_sink);
+        gst_pad_unlink(srcpad, old_sink);
+    }
+    if (GST_PAD_LINK_FAILED(gst_pad_link(srcpad, new_sink))) {
+        // 새 bin 연결 실패 시 이전 bin을 그대로 유지
+        g_printerr("[LIVE_SWAP] 새 bin 연결 실패, 이전 bin 유지\n");
+        if (old_sink) {
+            gst_pad_link(srcpad, old_sink);
+            gst_object_unref(old_sink);
+        }
+        gst_object_unref(new_sink);
+        discard_new_bin(ctx);
+        return GST_PAD_PROBE_REMOVE;
+    }
+
+    if (old_sink) gst_object_unref(old_sink);
+    gst_object_unref(new_sink);
+    if (ctx->done) ctx->done(ctx->new_bin, TRUE, ctx->user_data);
+
+    // 이전 bin의 비우기/정리는 스트리밍 스레드 밖에서
+    if (ctx->old_bin) g_thread_pool_push(dispose_pool, ctx, NULL);
+    else swap_context_free(ctx);
+    return GST_PAD_PROBE_REMOVE;
+}
+
+/*
+ * upstream 뒤에 연결된 bin을 new_bin으로 교체한다 (연결된 것이 없으면 바로 연결).
+ * new_bin은 아직 어떤 bin에도 속하지 않은 상태여야 하고, 소유권은 여기로 넘어온다.
+ * 결과는 done으로 (NULL 가능). 교체를 시작하지도 못하면 FALSE이고 그때도 done(FALSE)가 불린다.
+ */
+gboolean live_swap_bin(GstElement *upstream, GstElement *new_bin, LiveSwapDoneFunc done, gpointer user_data) {
+    GstElement *pipeline = GST_ELEMENT(gst_element_get_parent(upstream));
+    GstPad *srcpad;
+    SwapContext *ctx;
+
+    gst_object_ref_sink(new_bin); // 실패 경로에서도 여기서 해제한다
+    if (!pipeline) {
+        g_printerr("[LIVE_SWAP] upstream이 pipeline에 속해 있지 않음\n");
+        if (done) done(new_bin, FALSE, user_data);
+        gst_object_unref(new_bin);
+        return FALSE;
+    }
+
+    if (!dispose_pool) {
+        dispose_pool = g_thread_pool_new(dispose_old_bin, NULL, 1, FALSE, NULL);
+    }
+
+    // 새 bin을 미리 PLAYING으로 올려 둔다 (같은 이름의 이전 bin이 아직 정리 중이면 실패)
+    if (!gst_bin_add(GST_BIN(pipeline), new_bin)) {
+        g_printerr("[LIVE_SWAP] 새 bin 추가 실패: %s\n", GST_ELEMENT_NAME(new_bin));
+        if (done) done(new_bin, FALSE, user_data);
+        gst_object_unref(new_bin);
+        gst_object_unref(pipeline);
+        return FALSE;
+    }
+    gst_element_sync_state_with_parent(new_bin);
+
+    ctx = g_new0(SwapContext, 1);
+    ctx->pipeline = pipeline;
+    ctx->new_bin = new_bin; // ref_sink로 잡은 참조를 넘긴다
+    ctx->done = done;
+    ctx->user_data = user_data;
+    g_mutex_init(&ctx->lock);
+    g_cond_init(&ctx->cond);
+
+    // pad가 idle이면 probe가 여기서 바로 불린다 (결과는 done으로)
+    srcpad = gst_element_get_static_pad(upstream, "src");
+    gst_pad_add_probe(srcpad, GST_PAD_PROBE_TYPE_IDLE, on_src_idle, ctx, NULL);
+    gst_object_unref(srcpad);
+    return TRUE;
+}
@@ -0,0 +1,236 @@
+// multi_sender.c
+/*
+ * 한 프로세스에서 N개의 독립 스트림을 보내는 송신기 (session.c)
+ *
+ * 사용: ./multi_sender -n 64 -p 6000 -i 5 -d 30
+ *   세션 k는 포트 (base + 2k)로 보낸다 (RTP/RTCP 포트 쌍).
+ *   -i 초마다 모든 세션의 포맷을 PCM <-> AC3로 바꾼다 (세션마다 위상을 엇갈리게).
+ *   종료 시 "RESULT ..." 한 줄로 CPU 시간과 최대 RSS를 출력한다 (session_bench.sh가 읽음).
+ *
+ *   ./multi_sender -n 64 -b --batch 64 --latency-budget 1000
+ *   -b: 모든 세션의 RTP 패킷을 sendmmsg/GSO로 묶어서 송출 (../common/egress.c), 5초마다 pps/CPU 출력
+ *
+ *   ./multi_sender -n 16 -f 8 --fanout-churn 3
+ *   -f: 세션마다 한 번 인코딩한 스트림을 목적지 8곳으로 (목적지 j는 포트 base + 2(k + j*n))
+ *   --fanout-churn: 초마다 세션들의 마지막 목적지를 번갈아 빼고 다시 넣는다 (bin/인코더 재구성 없음)
+ *
+ *   ./multi_sender -n 8 -t throughput
+ *   -t: 세션 bin의 단계 경계 queue 구성 (../common/thread_topology.c), 5초마다 단계별 queue 채움 출력
+ */
+#include <gst/gst.h>
+#include <sys/resource.h>
+
+#include "../common/thread_topology.h"
+
+// session.c
+typedef struct _Session Session;
+gboolean session_system_init(guint workers, guint interval_ms);
+Session *session_new(guint id, guint port, gboolean is_ac3, gboolean standby);
+void session_switch(Session *session, gboolean is_ac3);
+gboolean session_add_destination(Session *session, const gchar *host, guint port);
+gboolean session_remove_destination(Session *session, const gchar *host, guint port);
+void session_get_stats(Session *session, guint64 *pushed, guint64 *skipped);
+void session_system_shutdown(void);
+
+// ../common/egress.c
+typedef enum { EGRESS_UDPSINK, EGRESS_BATCHED } EgressMode;
+void egress_configure(EgressMode mode, guint batch, guint budget_us);
+void egress_report(void);
+void egress_get_stats(guint64 *packets, guint64 *syscalls);
+void egress_shutdown(void);
+
+// ../common/pipeline_trace.c
+gboolean pipeline_trace_init(void);
+void pipeline_trace_shutdown(void);
+
+// ../common/ring_logger.c
+void ring_logger_shutdown(void);
+
+// ../common/pcap_capture.c
+gboolean pcap_capture_open(const gchar *path);
+void pcap_capture_close(void);
+
+// gui_monitor.c
+gboolean gui_monitor_start(guint refresh_ms, GSourceFunc on_quit, gpointer user_data);
+void gui_monitor_stop(void);
+
+#define FEED_INTERVAL_MS 20
+#define EGRESS_REPORT_INTERVAL_S 5
+#define FANOUT_HOST "127.0.0.1"
+
+static GMainLoop *main_loop;
+static Session **session_list;
+
+// 명령행 옵션
+static gint num_sessions = 1;
+static gint base_port = 5000;
+static gint num_workers = 0;
+static gint switch_interval_s = 5;
+static gint duration_s = 0;
+static gboolean use_standby = FALSE;
+static gboolean batched_egress = FALSE;
+static gint egress_batch = 64;
+static gint egress_budget_us = 1000;
+static gint fanout = 1;
+static gint fanout_churn_s = 0;
+static gchar *topology_name = NULL;
+static gint monitor_ms = 0;
+static gchar *pcap_path = NULL;
+
+static GOptionEntry entries[] = {
+    { "sessions", 'n', 0, G_OPTION_ARG_INT, &num_sessions, "동시 세션 수 (기본 1)", "N" },
+    { "base-port", 'p', 0, G_OPTION_ARG_INT, &base_port, "첫 세션 RTP 포트 (기본 5000)", "PORT" },
+    { "workers", 'w', 0, G_OPTION_ARG_INT, &num_workers, "입력 생성 worker 수 (기본: CPU 코어 수)", "N" },
+    { "switch-interval", 'i', 0, G_OPTION_ARG_INT, &switch_interval_s, "포맷 전환 주기 초 (0이면 전환 없음)", "SEC" },
+    { "duration", 'd', 0, G_OPTION_ARG_INT, &duration_s, "실행 시간 초 (0이면 계속)", "SEC" },
+    { "standby", 's', 0, G_OPTION_ARG_NONE, &use_standby, "세션마다 PCM/AC3 bin을 미리 만들어 둠", NULL },
+    { "batched-egress", 'b', 0, G_OPTION_ARG_NONE, &batched_egress, "sendmmsg/GSO 배치 송출", NULL },
+    { "batch", 0, 0, G_OPTION_ARG_INT, &egress_batch, "배치당 최대 패킷 수 (기본 64)", "N" },
+    { "latency-budget", 0, 0, G_OPTION_ARG_INT, &egress_budget_us, "배치 대기 최대 시간 us (기본 1000)", "US" },
+    { "fanout", 'f', 0, G_OPTION_ARG_INT, &fanout, "세션당 목적지 수 (기본 1)", "N" },
+    { "fanout-churn", 0, 0, G_OPTION_ARG_INT, &fanout_churn_s, "목적지 삭제/추가 반복 주기 초 (0이면 고정)", "SEC" },
+    { "topology", 't', 0, G_OPTION_ARG_STRING, &topology_name, "스레드 구성: single(기본) / low-latency / throughput", "PROFILE" },
+    { "pcap", 0, 0, G_OPTION_ARG_FILENAME, &pcap_path, "송출 패킷을 pcap 파일로 기록 (모든 세션)", "FILE" },
+    { "monitor", 'm', 0, G_OPTION_ARG_INT, &monitor_ms, "실시간 모니터 갱신 주기 ms (0이면 끔, 로그는 파일로 돌릴 것)", "MS" },
+    { NULL }
+};
+
+// 📌 전환 주기의 절반씩 엇갈려 두 그룹으로 전환 (모든 세션이 한 순간에 몰리지 않게)
+static gboolean on_switch_timer(gpointer user_data) {
+    static guint tick = 0;
+    gboolean odd_group = tick % 2;
+
+    for (gint i = odd_group; i < num_sessions; i += 2) {
+        if (session_list[i]) session_switch(session_list[i], (tick / 2) % 2 == 0);
+    }
+    tick++;
+    return G_SOURCE_CONTINUE;
+}
+
+// 세션 k의 j번째 목적지 포트
+static guint fanout_port(gint session_index, gint dest_index) {
+    return base_port + 2 * (session_index + dest_index * num_sessions);
+}
+
+// 📌 실행 중 목적지 변경: 마지막 목적지를 빼고, 다음 주기에 다시 넣는다
+static gboolean on_fanout_churn(gpointer user_data) {
+    static gboolean removed = FALSE;
+
+    for (gint i = 0; i < num_sessions; i++) {
+        if (!session_list[i]) continue;
+        if (removed) session_add_destination(session_list[i], FANOUT_HOST, fanout_port(i, fanout - 1));
+        else session_remove_destination(session_list[i], FANOUT_HOST, fanout_port(i, fanout - 1));
+    }
+    removed = !removed;
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_egress_report(gpointer user_data) {
+    egress_report();
+    thread_topology_report();
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_duration_done(gpointer user_data) {
+    g_main_loop_quit(main_loop);
+    return G_SOURCE_REMOVE;
+}
+
+static void print_result(void) {
+    struct rusage usage;
+    guint64 pushed = 0, skipped = 0, packets, syscalls;
+
+    for (gint i = 0; i < num_sessions; i++) {
+        guint64 p, s;
+        if (!session_list[i]) continue;
+        session_get_stats(session_list[i], &p, &s);
+        pushed += p;
+        skipped += s;
+    }
+
+    egress_get_stats(&packets, &syscalls);
+    getrusage(RUSAGE_SELF, &usage);
+    g_print("[MULTI] 세션 %d개, 버퍼 %" G_GUINT64_FORMAT "개 전송, 밀린 tick %" G_GUINT64_FORMAT "개\n",
+            num_sessions, pushed, skipped);
+    g_print("RESULT sessions=%d egress=%s cpu_s=%.3f max_rss_kb=%ld pushed=%" G_GUINT64_FORMAT
+            " skipped=%" G_GUINT64_FORMAT " packets=%" G_GUINT64_FORMAT " syscalls=%" G_GUINT64_FORMAT
+            " fanout=%d\n",
+            num_sessions, batched_egress ? "batched" : "udpsink",
+            usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+                (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6,
+            usage.ru_maxrss, pushed, skipped, packets, syscalls, fanout);
+}
+
+int main(int argc, char *argv[]) {
+    GOptionContext *context;
+    GError *error = NULL;
+    TopologyProfile topology = TOPOLOGY_SINGLE_THREAD;
+
+    gst_init(&argc, &argv);
+
+    context = g_option_context_new("- 다중 세션 PCM/AC3 송신기");
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("옵션 파싱 실패: %s\n", error->message);
+        g_error_free(error);
+        g_option_context_free(context);
+        return -1;
+    }
+    g_option_context_free(context);
+
+    if (num_sessions < 1) num_sessions = 1;
+    if (num_workers <= 0) num_workers = g_get_num_processors();
+    if (fanout < 1) fanout = 1;
+    // 마지막 세션의 마지막 목적지 포트까지 guint16 범위 안이어야 한다 (포트가 넘쳐 돌아가지 않게)
+    if (base_port < 1 || base_port + 2 * ((gint64)num_sessions * fanout - 1) > 65535) {
+        g_printerr("포트 범위 초과: --base-port %d에서 세션 %d개 x 목적지 %d곳이면 마지막 포트가 %" G_GINT64_FORMAT "\n",
+                   base_port, num_sessions, fanout, base_port + 2 * ((gint64)num_sessions * fanout - 1));
+        return -1;
+    }
+    if (topology_name && !thread_topology_parse(topology_name, &topology)) {
+        g_printerr("알 수 없는 스레드 구성: %s\n", topology_name);
+        return -1;
+    }
+    thread_topology_configure(topology);
+    pipeline_trace_init(); // PIPELINE_TRACE=파일 이면 bin 단위 추적 (세션들은 bin 이름별로 합산)
+
+    main_loop = g_main_loop_new(NULL, FALSE);
+    egress_configure(batched_egress ? EGRESS_BATCHED : EGRESS_UDPSINK, egress_batch, egress_budget_us);
+    if (pcap_path && !pcap_capture_open(pcap_path)) return -1;
+    if (!session_system_init(num_workers, FEED_INTERVAL_MS)) return -1;
+
+    session_list = g_new0(Session *, num_sessions);
+    for (gint i = 0; i < num_sessions; i++) {
+        session_list[i] = session_new(i, fanout_port(i, 0), FALSE, use_standby);
+        for (gint j = 1; j < fanout && session_list[i]; j++)
+            session_add_destination(session_list[i], FANOUT_HOST, fanout_port(i, j));
+    }
+    g_print("[MULTI] 세션 %d개 시작 (목적지 %d곳씩, 포트 %d~%u, worker %d개)\n",
+            num_sessions, fanout, base_port, fanout_port(num_sessions - 1, fanout - 1), num_workers);
+
+    if (switch_interval_s > 0)
+        g_timeout_add(switch_interval_s * 1000 / 2, on_switch_timer, NULL);
+    if (fanout_churn_s > 0 && fanout > 1)
+        g_timeout_add_seconds(fanout_churn_s, on_fanout_churn, NULL);
+    if (duration_s > 0)
+        g_timeout_add_seconds(duration_s, on_duration_done, NULL);
+    egress_report(); // 기준점
+    g_timeout_add_seconds(EGRESS_REPORT_INTERVAL_S, on_egress_report, NULL);
+    if (monitor_ms > 0)
+        gui_monitor_start(monitor_ms, on_duration_done, NULL); // [q]로 종료
+
+    g_main_loop_run(main_loop);
+
+    gui_monitor_stop();
+    print_result();
+    session_system_shutdown();
+    pipeline_trace_shutdown();
+    egress_shutdown();
+    pcap_capture_close();
+    ring_logger_shutdown(); // 스트리밍 스레드가 남긴 로그 출력
+    g_free(session_list);
+    g_free(topology_name);
+    g_free(pcap_path);
+    g_main_loop_unref(main_loop);
+    return 0;
+}
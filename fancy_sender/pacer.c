@@ -0,0 +1,98 @@
+// pacer.c
+/*
+ * 파일 송신 속도 조절기
+ *
+ * 실시간 모드: 첫 버퍼 시점을 기준으로 "기준 시각 + (PTS - 첫 PTS)" 라는 절대 시각까지
+ *             pipeline clock으로 기다린다. 매번 절대 시각을 목표로 하므로 sleep 오차가 누적되지 않는다.
+ * 최대 처리량 모드: 기다리지 않고, appsrc block=TRUE로 downstream이 받는 만큼만 밀어 넣는다.
+ *
+ * 사용:
+ *   Pacer *pacer = pacer_new(appsrc, FALSE);
+ *   pacer_wait(pacer, pts, duration, size);  // push 직전마다
+ *   pacer_report(pacer);                     // 달성 속도 / drift 출력
+ *   pacer_free(pacer);
+ */
+#include <gst/gst.h>
+
+// ../common/ring_logger.c (pacer_report는 송신 루프 안에서 불린다)
+void ring_log(const gchar *fmt, ...) G_GNUC_PRINTF(1, 2);
+
+typedef struct _Pacer {
+    GstClock *clock;
+    gboolean max_throughput;
+
+    gboolean started;
+    GstClockTime start_clock;   // 첫 버퍼 때의 clock 시각
+    GstClockTime first_pts;
+
+    GstClockTime media_sent;    // 지금까지 보낸 미디어 길이
+    guint64 bytes_sent;
+    GstClockTimeDiff max_late;  // 목표 시각보다 가장 늦게 깨어난 정도
+} Pacer;
+
+// 📌 element의 pipeline clock을 사용 (아직 없으면 system clock)
+Pacer *pacer_new(GstElement *appsrc, gboolean max_throughput) {
+    Pacer *pacer = g_new0(Pacer, 1);
+
+    pacer->clock = gst_element_get_clock(appsrc);
+    if (!pacer->clock) pacer->clock = gst_system_clock_obtain();
+    pacer->max_throughput = max_throughput;
+
+    // 최대 처리량 모드는 appsrc의 blocking push가 유일한 속도 제한
+    if (max_throughput) g_object_set(appsrc, "block", TRUE, NULL);
+    return pacer;
+}
+
+// 📌 pts 버퍼를 보낼 시각까지 대기
+void pacer_wait(Pacer *pacer, GstClockTime pts, GstClockTime duration, gsize size) {
+    GstClockTime now = gst_clock_get_time(pacer->clock);
+
+    if (!pacer->started) {
+        pacer->started = TRUE;
+        pacer->start_clock = now;
+        pacer->first_pts = GST_CLOCK_TIME_IS_VALID(pts) ? pts : 0;
+    }
+
+    if (!pacer->max_throughput && GST_CLOCK_TIME_IS_VALID(pts) && pts >= pacer->first_pts) {
+        GstClockTime target = pacer->start_clock + (pts - pacer->first_pts);
+
+        if (target > now) {
+            GstClockID id = gst_clock_new_single_shot_id(pacer->clock, target);
+            GstClockTimeDiff jitter = 0;
+
+            gst_clock_id_wait(id, &jitter);
+            gst_clock_id_unref(id);
+            // jitter > 0 : 목표보다 늦게 깨어남
+            if (jitter > pacer->max_late) pacer->max_late = jitter;
+        } else if ((GstClockTimeDiff)(now - target) > pacer->max_late) {
+            pacer->max_late = now - target;
+        }
+    }
+
+    if (GST_CLOCK_TIME_IS_VALID(duration)) pacer->media_sent += duration;
+    pacer->bytes_sent += size;
+}
+
+// 📌 달성 속도와 누적 drift 출력
+// drift = 경과 시간 - 보낸 미디어 길이 (양수: 실시간보다 느림, 음수: 앞서 감)
+void pacer_report(Pacer *pacer) {
+    GstClockTime elapsed;
+    GstClockTimeDiff drift;
+
+    if (!pacer->started) return;
+
+    elapsed = gst_clock_get_time(pacer->clock) - pacer->start_clock;
+    drift = GST_CLOCK_DIFF(pacer->media_sent, elapsed);
+
+    ring_log("  [PACER] %s: %.2f MB/s, 실시간 대비 x%.3f, 누적 drift %+.3f ms, 최대 지연 %.3f ms\n",
+             pacer->max_throughput ? "최대 처리량" : "실시간",
+             elapsed ? pacer->bytes_sent / ((gdouble)elapsed / GST_SECOND) / (1024.0 * 1024.0) : 0.0,
+            elapsed ? (gdouble)pacer->media_sent / elapsed : 0.0,
+            (gdouble)drift / GST_MSECOND,
+            (gdouble)pacer->max_late / GST_MSECOND);
+}
+
+void pacer_free(Pacer *pacer) {
+    gst_object_unref(pacer->clock);
+    g_free(pacer);
+}
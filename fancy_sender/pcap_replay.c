@@ -0,0 +1,345 @@
+// pcap_replay.c
+/*
+ * pcap 재생기: 캡처한 RTP/UDP 패킷을 로컬 포트로 다시 보낸다 (수신기 회귀/부하 시험용).
+ *
+ * 입력은 --pcap으로 남긴 송출 캡처(../common/pcap_capture.c)나 tcpdump -i lo 'udp port 5000' 결과.
+ *  링크 형식 : Ethernet(802.1Q 포함), raw IPv4, Linux cooked(SLL), BSD loopback
+ *  시각      : µs / ns pcap 모두, 바이트 순서 무관
+ *  대상      : IPv4 UDP 중 조각나지 않은 것 (--match-port로 원래 목적지 포트 필터)
+ *
+ * 재생 속도:
+ *   기본       원래 간격 그대로 (패킷마다 절대 시각 예약, 늦어도 간격이 밀려 쌓이지 않는다)
+ *   --speed N  N배 빠르게 (0.5면 절반 속도)
+ *   --max-rate 간격 무시, sendmmsg 배치로 최대한 빠르게
+ * 같은 시각에 보낼 패킷(송출 배치, 늦은 구간)은 sendmmsg 한 번으로 묶는다.
+ *
+ * 파일 전체를 mmap해서 패킷 위치를 먼저 뽑아 두므로 재생 중 파일 I/O나 파싱이 없다.
+ * 매초 진행 상황, 끝에 RESULT 한 줄 (pps, Mbps, 실제 배속, 예약 대비 지연):
+ *   RESULT packets=15000 bytes=... wall_s=10.01 pps=1498.6 mbps=4.1 speed_x=1.00 late_avg_ms=0.06 late_max_ms=0.84 errors=0
+ *
+ * 사용:
+ *   ./pcap_replay -i egress.pcap                    # 127.0.0.1:5000, 원래 속도
+ *   ./pcap_replay -i egress.pcap -p 5002 --speed 4 --loop 3
+ *   ./pcap_replay -i egress.pcap --max-rate --loop 100
+ */
+#define _GNU_SOURCE // sendmmsg
+#include <glib.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PCAP_MAGIC_US 0xa1b2c3d4
+#define PCAP_MAGIC_NS 0xa1b23c4d
+#define LINKTYPE_NULL 0
+#define LINKTYPE_ETHERNET 1
+#define LINKTYPE_RAW 101
+#define LINKTYPE_RAW_ALT 12   // 일부 플랫폼의 DLT_RAW
+#define LINKTYPE_LINUX_SLL 113
+#define REPLAY_MAX_BATCH 64
+#define REPORT_INTERVAL_US G_USEC_PER_SEC
+
+typedef struct {
+    gint64 ts_us;             // 캡처 시각 (첫 패킷 기준)
+    const guint8 *payload;    // UDP payload (mmap 안)
+    guint16 len;
+} ReplayPacket;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+// 명령행 옵션
+static gchar *input_path = NULL;
+static gchar *host = NULL;
+static gint port = 5000;
+static gdouble speed = 1.0;
+static gboolean max_rate = FALSE;
+static gint loops = 1;
+static gint match_port = 0;
+static gint batch = 32;
+
+static GOptionEntry entries[] = {
+    { "input", 'i', 0, G_OPTION_ARG_FILENAME, &input_path, "재생할 pcap 파일", "FILE" },
+    { "host", 0, 0, G_OPTION_ARG_STRING, &host, "보낼 주소 (기본 127.0.0.1)", "ADDR" },
+    { "port", 'p', 0, G_OPTION_ARG_INT, &port, "보낼 포트 (기본 5000)", "PORT" },
+    { "speed", 's', 0, G_OPTION_ARG_DOUBLE, &speed, "재생 배속 (기본 1.0 = 원래 간격)", "X" },
+    { "max-rate", 'm', 0, G_OPTION_ARG_NONE, &max_rate, "간격 무시, 최대 속도", NULL },
+    { "loop", 'l', 0, G_OPTION_ARG_INT, &loops, "반복 횟수 (기본 1)", "N" },
+    { "match-port", 0, 0, G_OPTION_ARG_INT, &match_port, "원래 목적지 포트가 이것인 패킷만 (0이면 전부)", "PORT" },
+    { "batch", 'b', 0, G_OPTION_ARG_INT, &batch, "sendmmsg 한 번에 보낼 최대 패킷 수 (기본 32)", "N" },
+    { NULL }
+};
+
+static void on_signal(int signum) {
+    stop_requested = 1;
+}
+
+// pcap 레코드는 정렬되어 있지 않다
+static inline guint32 read_u32(const guint8 *p, gboolean swapped) {
+    guint32 v;
+
+    memcpy(&v, p, sizeof(v));
+    return swapped ? GUINT32_SWAP_LE_BE(v) : v;
+}
+
+// 📌 링크 계층 헤더를 건너뛰고 IPv4 시작 위치 (IPv4가 아니면 -1)
+static gint ipv4_offset(guint32 linktype, const guint8 *frame, guint32 caplen) {
+    guint off;
+    guint16 ethertype;
+
+    switch (linktype) {
+    case LINKTYPE_RAW:
+    case LINKTYPE_RAW_ALT:
+        return 0;
+    case LINKTYPE_NULL:
+        return caplen >= 4 ? 4 : -1; // family는 호스트 바이트 순서, IPv4만 아래에서 버전으로 확인
+    case LINKTYPE_LINUX_SLL:
+        if (caplen < 16) return -1;
+        return (frame[14] << 8 | frame[15]) == 0x0800 ? 16 : -1;
+    case LINKTYPE_ETHERNET:
+        off = 12;
+        if (caplen < off + 2) return -1;
+        ethertype = frame[off] << 8 | frame[off + 1];
+        while (ethertype == 0x8100 || ethertype == 0x88a8) { // VLAN tag
+            off += 4;
+            if (caplen < off + 2) return -1;
+            ethertype = frame[off] << 8 | frame[off + 1];
+        }
+        return ethertype == 0x0800 ? (gint)off + 2 : -1;
+    default:
+        return -1;
+    }
+}
+
+// 📌 pcap 전체에서 재생할 UDP payload 목록을 뽑는다
+static GArray *load_packets(const guint8 *data, gsize size, guint *skipped) {
+    GArray *packets = g_array_new(FALSE, FALSE, sizeof(ReplayPacket));
+    guint32 magic, linktype;
+    gboolean swapped, nanos;
+    gint64 first_us = -1;
+    gsize pos = 24;
+
+    *skipped = 0;
+    if (size < 24) return packets;
+    magic = read_u32(data, FALSE);
+    swapped = magic == GUINT32_SWAP_LE_BE(PCAP_MAGIC_US) || magic == GUINT32_SWAP_LE_BE(PCAP_MAGIC_NS);
+    nanos = magic == PCAP_MAGIC_NS || magic == GUINT32_SWAP_LE_BE(PCAP_MAGIC_NS);
+    if (!swapped && magic != PCAP_MAGIC_US && magic != PCAP_MAGIC_NS) {
+        g_printerr("[REPLAY] pcap 파일이 아님 (pcapng는 editcap -F pcap으로 변환)\n");
+        return packets;
+    }
+    linktype = read_u32(data + 20, swapped) & 0xffff;
+
+    while (pos + 16 <= size) {
+        guint32 sec = read_u32(data + pos, swapped);
+        guint32 frac = read_u32(data + pos + 4, swapped);
+        guint32 caplen = read_u32(data + pos + 8, swapped);
+        const guint8 *frame = data + pos + 16;
+        const guint8 *ip, *udp;
+        gint ip_off;
+        guint ihl;
+        ReplayPacket pkt;
+
+        if (pos + 16 + caplen > size) break; // 잘린 마지막 레코드
+        pos += 16 + caplen;
+
+        ip_off = ipv4_offset(linktype, frame, caplen);
+        ip = frame + ip_off;
+        if (ip_off < 0 || caplen < (guint32)ip_off + 20 || (ip[0] >> 4) != 4 || ip[9] != 17 ||
+            ((ip[6] & 0x3f) | ip[7]) != 0) { // IPv4 UDP, 조각 아님 (MF 플래그/offset 0)
+            (*skipped)++;
+            continue;
+        }
+        ihl = (ip[0] & 0x0f) * 4;
+        udp = ip + ihl;
+        if (caplen < (guint32)ip_off + ihl + 8 ||
+            (match_port && (udp[2] << 8 | udp[3]) != match_port)) {
+            (*skipped)++;
+            continue;
+        }
+
+        pkt.payload = udp + 8;
+        pkt.len = MIN((guint)(udp[4] << 8 | udp[5]) - 8, (guint)(frame + caplen - pkt.payload));
+        pkt.ts_us = (gint64)sec * G_USEC_PER_SEC + (nanos ? frac / 1000 : frac);
+        if (first_us < 0) first_us = pkt.ts_us;
+        pkt.ts_us -= first_us;
+        g_array_append_val(packets, pkt);
+    }
+    return packets;
+}
+
+static inline gint64 monotonic_us(void) {
+    return g_get_monotonic_time();
+}
+
+// 📌 절대 시각까지 잠든다 (CLOCK_MONOTONIC, g_get_monotonic_time과 같은 시계)
+static void sleep_until_us(gint64 target_us) {
+    struct timespec ts = { target_us / G_USEC_PER_SEC, (target_us % G_USEC_PER_SEC) * 1000 };
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR && !stop_requested);
+}
+
+int main(int argc, char *argv[]) {
+    GOptionContext *context;
+    GError *error = NULL;
+    struct sockaddr_in dest = { 0 };
+    struct mmsghdr msgs[REPLAY_MAX_BATCH];
+    struct iovec iovs[REPLAY_MAX_BATCH];
+    struct stat st;
+    GArray *packets;
+    const guint8 *data;
+    guint skipped;
+    gint fd, sock;
+    gint64 capture_us, start_us, last_report_us, now;
+    guint64 sent = 0, bytes = 0, errors = 0, late_count = 0, report_sent = 0;
+    gint64 late_sum_us = 0, late_max_us = 0;
+    gdouble wall_s;
+
+    context = g_option_context_new("- pcap RTP/UDP 재생기");
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("옵션 파싱 실패: %s\n", error->message);
+        g_error_free(error);
+        g_option_context_free(context);
+        return -1;
+    }
+    g_option_context_free(context);
+
+    if (!input_path) {
+        g_printerr("재생할 파일(-i)이 필요합니다\n");
+        return -1;
+    }
+    if (speed <= 0.0) speed = 1.0;
+    if (loops < 1) loops = 1;
+    batch = CLAMP(batch, 1, REPLAY_MAX_BATCH);
+
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons((guint16)port);
+    if (inet_pton(AF_INET, host ? host : "127.0.0.1", &dest.sin_addr) != 1) {
+        g_printerr("잘못된 주소: %s\n", host);
+        return -1;
+    }
+
+    fd = open(input_path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        g_printerr("파일 열기 실패: %s\n", input_path);
+        return -1;
+    }
+    data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        g_printerr("mmap 실패: %s\n", input_path);
+        return -1;
+    }
+
+    packets = load_packets(data, st.st_size, &skipped);
+    if (packets->len == 0) {
+        g_printerr("[REPLAY] 재생할 UDP 패킷이 없음 (건너뜀 %u개)\n", skipped);
+        return -1;
+    }
+    capture_us = g_array_index(packets, ReplayPacket, packets->len - 1).ts_us;
+    g_print("[REPLAY] %s: 패킷 %u개 (건너뜀 %u개), 캡처 길이 %.3f초 → %s:%d, %s, %d회\n",
+            input_path, packets->len, skipped, capture_us / 1e6, host ? host : "127.0.0.1", port,
+            max_rate ? "최대 속도" : speed == 1.0 ? "원래 속도" : "배속", loops);
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        g_printerr("소켓 생성 실패: %s\n", g_strerror(errno));
+        return -1;
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    memset(msgs, 0, sizeof(msgs));
+    for (gint i = 0; i < REPLAY_MAX_BATCH; i++) {
+        msgs[i].msg_hdr.msg_name = &dest;
+        msgs[i].msg_hdr.msg_namelen = sizeof(dest);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    start_us = last_report_us = monotonic_us();
+    for (gint loop = 0; loop < loops && !stop_requested; loop++) {
+        // 반복마다 캡처 길이 + 마지막 패킷 간격 하나만큼 뒤로 (경계에서 몰리지 않게)
+        gint64 loop_offset_us = (gint64)(loop * (capture_us + capture_us / MAX(packets->len - 1, 1)) / speed);
+        guint i = 0;
+
+        while (i < packets->len && !stop_requested) {
+            guint n = 0, done = 0;
+
+            if (!max_rate) {
+                gint64 due = start_us + loop_offset_us +
+                             (gint64)(g_array_index(packets, ReplayPacket, i).ts_us / speed);
+
+                now = monotonic_us();
+                if (due > now) {
+                    sleep_until_us(due);
+                    now = monotonic_us();
+                }
+                // 예약 시각이 지난 패킷은 한 배치로 (지연 통계는 패킷마다)
+                while (i + n < packets->len && n < (guint)batch) {
+                    gint64 pkt_due = start_us + loop_offset_us +
+                                     (gint64)(g_array_index(packets, ReplayPacket, i + n).ts_us / speed);
+                    if (pkt_due > now) break;
+                    late_sum_us += now - pkt_due;
+                    late_max_us = MAX(late_max_us, now - pkt_due);
+                    late_count++;
+                    n++;
+                }
+            } else {
+                n = MIN((guint)batch, packets->len - i);
+            }
+
+            for (guint k = 0; k < n; k++) {
+                ReplayPacket *pkt = &g_array_index(packets, ReplayPacket, i + k);
+                iovs[k].iov_base = (void *)pkt->payload;
+                iovs[k].iov_len = pkt->len;
+                bytes += pkt->len;
+            }
+            while (done < n) {
+                gint r = sendmmsg(sock, msgs + done, n - done, 0);
+                if (r < 0) {
+                    if (errno == EINTR && !stop_requested) continue;
+                    if (errno == ENOBUFS || errno == EAGAIN) { // 송신 버퍼가 가득 (최대 속도에서)
+                        g_usleep(50);
+                        continue;
+                    }
+                    errors += n - done;
+                    break;
+                }
+                done += r;
+            }
+            sent += done;
+            i += n;
+
+            now = monotonic_us();
+            if (now - last_report_us >= REPORT_INTERVAL_US) {
+                g_print("[REPLAY] %.1f초: %.0f pps (누적 %" G_GUINT64_FORMAT "개)\n",
+                        (now - start_us) / 1e6, (sent - report_sent) * 1e6 / (now - last_report_us), sent);
+                report_sent = sent;
+                last_report_us = now;
+            }
+        }
+    }
+
+    wall_s = MAX(monotonic_us() - start_us, 1) / 1e6;
+    g_print("RESULT packets=%" G_GUINT64_FORMAT " bytes=%" G_GUINT64_FORMAT " wall_s=%.3f pps=%.1f mbps=%.2f "
+            "speed_x=%.2f late_avg_ms=%.3f late_max_ms=%.3f errors=%" G_GUINT64_FORMAT "%s\n",
+            sent, bytes, wall_s, sent / wall_s, bytes * 8 / wall_s / 1e6,
+            capture_us > 0 ? (gdouble)sent / packets->len * capture_us / 1e6 / wall_s : 0.0,
+            late_count ? late_sum_us / 1000.0 / late_count : 0.0, late_max_us / 1000.0, errors,
+            stop_requested ? " (중단)" : "");
+
+    close(sock);
+    g_array_free(packets, TRUE);
+    munmap((void *)data, st.st_size);
+    g_free(input_path);
+    g_free(host);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,722 @@
+// receiver.c
+/*
+ * RTP 오디오 수신기 (코덱 전환을 재시작 없이 따라간다)
+ *
+ *  udpsrc → rtpjitterbuffer → [branch: depay → decoder] → audioconvert → audioresample → sink
+ *                           ▲ 패킷마다 payload type(+AC3 sync) 확인, 코덱이 바뀌면 branch만 교체
+ *
+ *  --rtcp: udpsrc → rtpsession → rtpjitterbuffer ... (rtpbin의 수신 쪽과 같은 배치)
+ *          rtpsession이 손실/jitter를 세서 RR을 송신기 RTCP 포트(기본 port + 3)로 보내고,
+ *          송신기 SR은 port + 1에서 받는다 (RR의 LSR/DLSR → 송신기가 RTT 계산).
+ *          송신기 gst_sender --abr가 이 RR로 Opus bitrate/FEC를 조정한다 (../common/rtcp_feedback.c)
+ *  --drop-probability: rtpsession 앞에서 RTP 패킷을 무작위로 버린다 (손실 링크 흉내, RR에 그대로 반영)
+ *
+ *  - branch는 코덱마다 한 번 만들어 pipeline 안에 두고, 전환 때는 링크만 바꾼다 (요소 생성 없음).
+ *    교체는 jitterbuffer src pad의 probe 안(그 pad의 스트리밍 스레드)에서 하므로 경계 패킷은
+ *    정확히 한쪽 branch로만 간다.
+ *  - 송신기 bin이 모두 PT 96을 쓰던 때와 호환: PT가 같아도 payload가 AC3 sync(0x0B77)로
+ *    시작하면 AC3로 본다. 잘못된 판정으로 왔다갔다 하지 않게 연속 SWITCH_HYSTERESIS개가 같아야 전환.
+ *  - branch 입력의 caps 이벤트는 그 branch 코덱의 caps로 바꿔 넣는다 (PT가 같아도 depay가 맞는 caps를 받음).
+ *  - 코덱과 PT는 송신 코덱 등록부(../common/codec_registry.c)와 같다:
+ *      Opus 96, AC3 97, L16 98, L24 99, E-AC3 100 (rtpgstpay, 90 kHz), AAC 101 (MP4A-LATM)
+ *
+ * 보고 (주기적으로, 종료 시 RESULT 한 줄):
+ *   전환 간격: 이전 decoder의 마지막 출력 ~ 새 decoder의 첫 출력
+ *   jitterbuffer 지연: 같은 seqnum 패킷이 jitterbuffer에 들어가서 나올 때까지 (평균/최대)
+ *   jitterbuffer 통계: pushed / lost / late / 평균 jitter
+ *   glass-to-glass: 송신기가 저지연 프로필로 붙인 capture 시각 ~ 이 수신기의 재생 시각
+ *                   (같은 호스트에서만, ../common/latency_profile.c). 재생 시각은 sink가 clock에 맞춰
+ *                   내보낼 시각(base time + running time + pipeline 지연), --null이면 sink 도착 시각
+ *
+ * 사용:
+ *   ./receiver -p 5000 -l 50                 # 스피커로 재생, jitterbuffer 50ms
+ *   ./receiver -p 5000 --null -d 30          # 성능 시험용 (fakesink, 동기화 없음), 30초 후 RESULT
+ *   ./receiver --ac3-pt 96 --l16-pt 98       # payload type 배정 변경 (--l24-pt, --eac3-pt, --aac-pt도)
+ *   ./receiver -L low                        # 저지연: jitterbuffer 10ms, audio sink buffer 20ms, glass-to-glass 보고
+ *   ./receiver --rtcp --drop-probability 0.1 # RR 보내기 + 10% 손실 (송신기: gst_sender --abr 16:128)
+ */
+#include <gst/gst.h>
+#include <gst/rtp/gstrtpbuffer.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "../common/latency_profile.h"
+
+#define CLOCK_RATE 48000
+#define GST_PAY_CLOCK_RATE 90000     // rtpgstpay (E-AC3)
+// AAC: 송신기 avenc_aac 48 kHz stereo AAC-LC의 StreamMuxConfig (rtpmp4apay가 SDP로 주는 값, 수신기는 미리 안다)
+#define AAC_LATM_CONFIG "400023203fc0"
+#define SWITCH_HYSTERESIS 3          // 연속으로 같은 코덱이어야 전환
+#define AC3_FT_CONTINUATION 3        // RFC 4184 payload header FT: 첫 조각이 아닌 조각
+#define DEFAULT_LATENCY_MS 50
+#define STAMP_RING 256               // jitterbuffer 출력 PTS ↔ 송신 capture 시각 (최근 것만)
+#define RTCP_MIN_INTERVAL_MS 1000    // RR 주기 (rtpsession 기본 5초는 조정에 너무 느림)
+
+typedef enum {
+    CODEC_NONE = -1,
+    CODEC_OPUS,
+    CODEC_AC3,
+    CODEC_L16,
+    CODEC_L24,
+    CODEC_EAC3,
+    CODEC_AAC,
+    CODEC_COUNT
+} RxCodec;
+
+typedef struct {
+    const gchar *name;
+    const gchar *encoding;       // RTP encoding-name
+    const gchar *depay;
+    const gchar *decoder;        // NULL이면 depay 출력이 이미 raw
+    gint pt;
+    GstCaps *caps;               // branch 입력 caps (시작 시 한 번 만듦)
+    GstElement *branch;
+} RxCodecInfo;
+
+typedef struct {
+    GstClockTime pts;
+    gint64 capture_us;
+} CaptureStamp;
+
+static RxCodecInfo codecs[CODEC_COUNT] = {
+    [CODEC_OPUS] = { "Opus", "OPUS", "rtpopusdepay", "opusdec", 96 },
+    [CODEC_AC3] = { "AC3", "AC3", "rtpac3depay", "avdec_ac3", 97 },
+    [CODEC_L16] = { "L16", "L16", "rtpL16depay", NULL, 98 },
+    [CODEC_L24] = { "L24", "L24", "rtpL24depay", NULL, 99 },
+    [CODEC_EAC3] = { "E-AC3", "X-GST", "rtpgstdepay", "avdec_eac3", 100 },
+    [CODEC_AAC] = { "AAC", "MP4A-LATM", "rtpmp4adepay", "avdec_aac", 101 },
+};
+
+static GMainLoop *main_loop;
+static GstElement *pipeline, *jitterbuffer, *tail;
+
+// 스트리밍 스레드(jitterbuffer src) 전용
+static RxCodec current_codec = CODEC_NONE;
+static RxCodec candidate_codec = CODEC_NONE;
+static guint candidate_count = 0;
+
+// 전환 간격 측정 (tail 입력 probe와 jitterbuffer src probe가 같이 씀)
+static GMutex switch_lock;
+static gint64 last_output_us = 0;
+static gint64 switch_requested_us = 0;
+static gboolean switch_pending = FALSE;
+static guint switches = 0;
+static gdouble last_gap_ms = 0.0, max_gap_ms = 0.0;
+
+// jitterbuffer 체류 시간 (seqnum별 도착 시각)
+static volatile gsize arrival_us[65536];
+static volatile gsize residence_sum_us = 0, residence_count = 0, residence_max_us = 0;
+static volatile gsize received = 0;
+static volatile gsize dropped = 0; // --drop-probability로 버린 패킷
+static gdouble total_residence_ms = 0.0, peak_residence_ms = 0.0;
+static guint64 total_residence_count = 0;
+
+// glass-to-glass: stamp ring은 jitterbuffer src와 sink 입력이 같은 스트리밍 스레드라 락 없음
+static CaptureStamp stamps[STAMP_RING];
+static guint stamp_head = 0;
+static volatile gsize g2g_sum_us = 0, g2g_count = 0, g2g_max_us = 0;
+static volatile gsize pipeline_latency_ns = 0;
+static gdouble total_g2g_ms = 0.0, peak_g2g_ms = 0.0;
+static guint64 total_g2g_count = 0;
+
+// 명령행 옵션
+static gint port = 5000;
+static gint latency_ms = -1; // 지정하지 않으면 지연 프로필 기본
+static gboolean drop_on_latency = FALSE;
+static gchar *jb_mode = NULL;
+static gchar *sink_name = NULL;
+static gboolean null_sink = FALSE;
+static gint duration_s = 0;
+static gint report_interval_s = 5;
+static gchar *latency_profile_name = NULL;
+static gboolean use_rtcp = FALSE;
+static gchar *rtcp_dest = NULL;
+static gdouble drop_probability = 0.0;
+
+static GOptionEntry entries[] = {
+    { "port", 'p', 0, G_OPTION_ARG_INT, &port, "수신 UDP 포트 (기본 5000)", "PORT" },
+    { "latency", 'l', 0, G_OPTION_ARG_INT, &latency_ms, "jitterbuffer 지연 ms (기본 50, 저지연 프로필 10)", "MS" },
+    { "drop-on-latency", 0, 0, G_OPTION_ARG_NONE, &drop_on_latency, "지연을 넘긴 패킷은 버림", NULL },
+    { "mode", 0, 0, G_OPTION_ARG_STRING, &jb_mode, "jitterbuffer mode: none / slave / buffer / synced", "MODE" },
+    { "opus-pt", 0, 0, G_OPTION_ARG_INT, &codecs[CODEC_OPUS].pt, "Opus payload type (기본 96)", "PT" },
+    { "ac3-pt", 0, 0, G_OPTION_ARG_INT, &codecs[CODEC_AC3].pt, "AC3 payload type (기본 97)", "PT" },
+    { "l16-pt", 0, 0, G_OPTION_ARG_INT, &codecs[CODEC_L16].pt, "L16 payload type (기본 98)", "PT" },
+    { "l24-pt", 0, 0, G_OPTION_ARG_INT, &codecs[CODEC_L24].pt, "L24 payload type (기본 99)", "PT" },
+    { "eac3-pt", 0, 0, G_OPTION_ARG_INT, &codecs[CODEC_EAC3].pt, "E-AC3 payload type (기본 100)", "PT" },
+    { "aac-pt", 0, 0, G_OPTION_ARG_INT, &codecs[CODEC_AAC].pt, "AAC payload type (기본 101)", "PT" },
+    { "sink", 0, 0, G_OPTION_ARG_STRING, &sink_name, "출력 sink (기본 autoaudiosink)", "ELEMENT" },
+    { "null", 'n', 0, G_OPTION_ARG_NONE, &null_sink, "fakesink sync=false (성능 시험용)", NULL },
+    { "duration", 'd', 0, G_OPTION_ARG_INT, &duration_s, "실행 시간 초 (0이면 계속)", "SEC" },
+    { "report-interval", 'r', 0, G_OPTION_ARG_INT, &report_interval_s, "보고 주기 초 (기본 5)", "SEC" },
+    { "latency-profile", 'L', 0, G_OPTION_ARG_STRING, &latency_profile_name,
+      "지연 프로필: default / low (jitterbuffer, audio sink 버퍼)", "PROFILE" },
+    { "rtcp", 0, 0, G_OPTION_ARG_NONE, &use_rtcp, "RTCP 세션 (RR 송신, SR은 port + 1에서 수신)", NULL },
+    { "rtcp-dest", 0, 0, G_OPTION_ARG_STRING, &rtcp_dest,
+      "RR 목적지 (기본 127.0.0.1:<port + 3>, 송신기 --rtcp-port)", "HOST:PORT" },
+    { "drop-probability", 0, 0, G_OPTION_ARG_DOUBLE, &drop_probability,
+      "수신 RTP 패킷을 이 확률로 버림 (0~1, 손실 링크 흉내)", "P" },
+    { NULL }
+};
+
+static void atomic_max(volatile gsize *target, gsize value) {
+    gsize current = g_atomic_pointer_get(target);
+
+    while (value > current && !g_atomic_pointer_compare_and_exchange(target, (gpointer)current, (gpointer)value))
+        current = g_atomic_pointer_get(target);
+}
+
+// 📌 branch 입력 caps 이벤트를 branch 코덱 caps로 바꾼다
+static GstPadProbeReturn on_branch_event(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    RxCodecInfo *codec = user_data;
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT(info);
+
+    if (GST_EVENT_TYPE(event) != GST_EVENT_CAPS) return GST_PAD_PROBE_OK;
+
+    gst_event_unref(event);
+    GST_PAD_PROBE_INFO_DATA(info) = gst_event_new_caps(codec->caps);
+    return GST_PAD_PROBE_OK;
+}
+
+// 📌 코덱 하나의 branch (depay ! decoder), ghost pad로 감싼다
+static GstElement *make_branch(RxCodecInfo *codec) {
+    gchar *name = g_strdup_printf("%s-branch", codec->name);
+    GstElement *bin = gst_bin_new(name);
+    GstElement *depay = gst_element_factory_make(codec->depay, NULL);
+    GstElement *decoder = codec->decoder ? gst_element_factory_make(codec->decoder, NULL) : NULL;
+    GstElement *last = decoder ? decoder : depay;
+    GstPad *pad, *ghost;
+
+    g_free(name);
+    if (!depay || (codec->decoder && !decoder)) {
+        g_printerr("[RECEIVER] %s branch 생성 실패 (%s / %s 없음?)\n", codec->name, codec->depay,
+                   codec->decoder ? codec->decoder : "-");
+        if (depay) gst_object_unref(depay);
+        if (decoder) gst_object_unref(decoder);
+        gst_object_unref(bin);
+        return NULL;
+    }
+
+    gst_bin_add(GST_BIN(bin), depay);
+    if (decoder) {
+        gst_bin_add(GST_BIN(bin), decoder);
+        gst_element_link(depay, decoder);
+    }
+
+    pad = gst_element_get_static_pad(depay, "sink");
+    ghost = gst_ghost_pad_new("sink", pad);
+    gst_pad_add_probe(ghost, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, on_branch_event, codec, NULL);
+    gst_element_add_pad(bin, ghost);
+    gst_object_unref(pad);
+
+    pad = gst_element_get_static_pad(last, "src");
+    gst_element_add_pad(bin, gst_ghost_pad_new("src", pad));
+    gst_object_unref(pad);
+    return bin;
+}
+
+static GstCaps *make_codec_caps(RxCodec id) {
+    // rtpgstdepay는 media=application만 받는다 (E-AC3 caps는 송신기 rtpgstpay가 주기적으로 in-band로 보냄)
+    GstCaps *caps = gst_caps_new_simple("application/x-rtp",
+                                        "media", G_TYPE_STRING, id == CODEC_EAC3 ? "application" : "audio",
+                                        "clock-rate", G_TYPE_INT, id == CODEC_EAC3 ? GST_PAY_CLOCK_RATE : CLOCK_RATE,
+                                        "encoding-name", G_TYPE_STRING, codecs[id].encoding,
+                                        "payload", G_TYPE_INT, codecs[id].pt,
+                                        NULL);
+    if (id == CODEC_L16 || id == CODEC_L24)
+        gst_caps_set_simple(caps, "encoding-params", G_TYPE_STRING, "2", "channels", G_TYPE_INT, 2, NULL);
+    else if (id == CODEC_AAC)
+        gst_caps_set_simple(caps, "config", G_TYPE_STRING, AAC_LATM_CONFIG, "cpresent", G_TYPE_STRING, "0", NULL);
+    return caps;
+}
+
+// 📌 jitterbuffer가 모르는 PT를 만나면 caps를 묻는다
+static GstCaps *on_request_pt_map(GstElement *jb, guint pt, gpointer user_data) {
+    for (gint i = 0; i < CODEC_COUNT; i++)
+        if (codecs[i].pt == (gint)pt) return gst_caps_ref(codecs[i].caps);
+    g_printerr("[RECEIVER] 모르는 payload type %u\n", pt);
+    return NULL;
+}
+
+// 📌 패킷 하나의 코덱 판정 (모호하면 CODEC_NONE)
+static RxCodec classify_packet(GstBuffer *buffer) {
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+    RxCodec codec = CODEC_NONE;
+    const guint8 *payload;
+    guint len, pt;
+
+    if (!gst_rtp_buffer_map(buffer, GST_MAP_READ, &rtp)) return CODEC_NONE;
+    pt = gst_rtp_buffer_get_payload_type(&rtp);
+    payload = gst_rtp_buffer_get_payload(&rtp);
+    len = gst_rtp_buffer_get_payload_len(&rtp);
+
+    // PT를 다른 코덱과 나눠 쓴 적이 없는 코덱은 payload를 보지 않는다 (raw 오디오가 우연히 0x0B77일 수 있음)
+    if ((gint)pt == codecs[CODEC_AC3].pt) {
+        codec = CODEC_AC3;
+    } else if ((gint)pt == codecs[CODEC_L24].pt) {
+        codec = CODEC_L24;
+    } else if ((gint)pt == codecs[CODEC_EAC3].pt) {
+        codec = CODEC_EAC3;
+    } else if ((gint)pt == codecs[CODEC_AAC].pt) {
+        codec = CODEC_AAC;
+    } else if (len >= 4 && payload[2] == 0x0B && payload[3] == 0x77) {
+        codec = CODEC_AC3; // 같은 PT를 쓰는 송신기: AC3 프레임(또는 첫 조각)
+    } else if (len >= 1 && (payload[0] & 0x03) == AC3_FT_CONTINUATION && current_codec == CODEC_AC3) {
+        codec = CODEC_NONE; // AC3 이어지는 조각일 수 있음
+    } else if ((gint)pt == codecs[CODEC_L16].pt) {
+        codec = CODEC_L16;
+    } else if ((gint)pt == codecs[CODEC_OPUS].pt) {
+        codec = CODEC_OPUS;
+    }
+    gst_rtp_buffer_unmap(&rtp);
+    return codec;
+}
+
+// 📌 branch 교체 (jitterbuffer src의 스트리밍 스레드에서, 데이터가 이 pad를 지나지 않는 순간)
+static gboolean swap_branch(GstPad *jb_src, RxCodec codec) {
+    GstElement *next = codecs[codec].branch;
+    GstPad *tail_sink = gst_element_get_static_pad(tail, "sink");
+    GstPad *next_sink, *next_src;
+    gboolean ok;
+
+    if (!next) {
+        gst_object_unref(tail_sink);
+        return FALSE;
+    }
+
+    if (current_codec != CODEC_NONE) {
+        GstElement *prev = codecs[current_codec].branch;
+        GstPad *prev_sink = gst_element_get_static_pad(prev, "sink");
+        GstPad *prev_src = gst_element_get_static_pad(prev, "src");
+
+        gst_pad_unlink(jb_src, prev_sink);
+        gst_pad_unlink(prev_src, tail_sink);
+        gst_object_unref(prev_sink);
+        gst_object_unref(prev_src);
+    }
+
+    // 링크하면 jitterbuffer/branch의 sticky 이벤트(stream-start, caps, segment)가 다음 버퍼 앞에 다시 간다
+    next_sink = gst_element_get_static_pad(next, "sink");
+    next_src = gst_element_get_static_pad(next, "src");
+    ok = GST_PAD_LINK_SUCCESSFUL(gst_pad_link(jb_src, next_sink)) &&
+         GST_PAD_LINK_SUCCESSFUL(gst_pad_link(next_src, tail_sink));
+    gst_object_unref(next_sink);
+    gst_object_unref(next_src);
+    gst_object_unref(tail_sink);
+
+    g_mutex_lock(&switch_lock);
+    switch_requested_us = g_get_monotonic_time();
+    switch_pending = last_output_us != 0; // 첫 연결은 전환이 아님
+    g_mutex_unlock(&switch_lock);
+
+    g_print("[RECEIVER] %s → %s branch%s\n",
+            current_codec == CODEC_NONE ? "(없음)" : codecs[current_codec].name, codecs[codec].name,
+            ok ? "" : " 연결 실패");
+    current_codec = codec;
+    return ok;
+}
+
+// 📌 손실 링크 흉내: 세션/jitterbuffer가 보기 전에 버린다 (seqnum 구멍 → RR fraction lost)
+static GstPadProbeReturn on_network_input(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    if (g_random_double() >= drop_probability) return GST_PAD_PROBE_OK;
+    g_atomic_pointer_add(&dropped, 1);
+    return GST_PAD_PROBE_DROP;
+}
+
+// 📌 RTCP 세션: udpsrc → rtpsession → jitterbuffer, RR → 송신기, SR ← port + 1
+static gboolean add_rtcp_session(GstElement *udpsrc) {
+    GstElement *session = gst_element_factory_make("rtpsession", NULL);
+    GstElement *rtcp_src = gst_element_factory_make("udpsrc", NULL);
+    GstElement *rtcp_sink = gst_element_factory_make("udpsink", NULL);
+    GstElement *sync_sink = gst_element_factory_make("fakesink", NULL);
+    gchar *host = g_strdup("127.0.0.1");
+    guint64 dest_port = port + 3;
+    GstCaps *caps;
+
+    if (!session || !rtcp_src || !rtcp_sink || !sync_sink) {
+        g_printerr("[RECEIVER] RTCP 요소 생성 실패\n");
+        g_free(host);
+        return FALSE;
+    }
+    if (rtcp_dest) {
+        gchar *colon = strrchr(rtcp_dest, ':');
+
+        if (!colon || !g_ascii_string_to_unsigned(colon + 1, 10, 1, 65535, &dest_port, NULL)) {
+            g_printerr("[RECEIVER] 잘못된 RTCP 목적지: %s\n", rtcp_dest);
+            g_free(host);
+            return FALSE;
+        }
+        g_free(host);
+        host = g_strndup(rtcp_dest, colon - rtcp_dest);
+    }
+
+    g_object_set(session, "rtcp-min-interval", (guint64)RTCP_MIN_INTERVAL_MS * GST_MSECOND, NULL);
+    g_signal_connect(session, "request-pt-map", G_CALLBACK(on_request_pt_map), NULL);
+    caps = gst_caps_new_empty_simple("application/x-rtcp");
+    g_object_set(rtcp_src, "port", port + 1, "caps", caps, NULL);
+    gst_caps_unref(caps);
+    g_object_set(rtcp_sink, "host", host, "port", (gint)dest_port, "sync", FALSE, "async", FALSE, NULL);
+    g_object_set(sync_sink, "sync", FALSE, "async", FALSE, NULL);
+
+    gst_bin_add_many(GST_BIN(pipeline), session, rtcp_src, rtcp_sink, sync_sink, NULL);
+    // 요청 pad(recv_rtp_sink 등)는 gst_element_link_pads가 만들고, 짝이 되는 src pad도 같이 생긴다
+    if (!gst_element_link_pads(udpsrc, "src", session, "recv_rtp_sink") ||
+        !gst_element_link_pads(session, "recv_rtp_src", jitterbuffer, "sink") ||
+        !gst_element_link_pads(rtcp_src, "src", session, "recv_rtcp_sink") ||
+        !gst_element_link_pads(session, "sync_src", sync_sink, "sink") ||
+        !gst_element_link_pads(session, "send_rtcp_src", rtcp_sink, "sink")) {
+        g_printerr("[RECEIVER] RTCP 세션 연결 실패\n");
+        g_free(host);
+        return FALSE;
+    }
+
+    g_print("[RECEIVER] RTCP: SR ← :%d, RR → %s:%" G_GUINT64_FORMAT " (%d ms 주기)\n",
+            port + 1, host, dest_port, RTCP_MIN_INTERVAL_MS);
+    g_free(host);
+    return TRUE;
+}
+
+// 📌 jitterbuffer 출력: 코덱 판정 → 필요하면 branch 교체, 체류 시간 계산
+static GstPadProbeReturn on_jitterbuffer_output(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+    RxCodec codec = classify_packet(buffer);
+    gint64 capture_us;
+
+    if (latency_profile_read_stamp(buffer, &capture_us) && GST_BUFFER_PTS_IS_VALID(buffer)) {
+        stamps[stamp_head % STAMP_RING].pts = GST_BUFFER_PTS(buffer);
+        stamps[stamp_head % STAMP_RING].capture_us = capture_us;
+        stamp_head++;
+    }
+
+    if (gst_rtp_buffer_map(buffer, GST_MAP_READ, &rtp)) {
+        gsize arrived = g_atomic_pointer_get(&arrival_us[gst_rtp_buffer_get_seq(&rtp)]);
+        gst_rtp_buffer_unmap(&rtp);
+        if (arrived) {
+            gsize residence = g_get_monotonic_time() - arrived;
+            g_atomic_pointer_add(&residence_sum_us, residence);
+            g_atomic_pointer_add(&residence_count, 1);
+            atomic_max(&residence_max_us, residence);
+        }
+    }
+
+    if (codec == CODEC_NONE || codec == current_codec) {
+        candidate_count = 0;
+        return GST_PAD_PROBE_OK;
+    }
+    if (codec != candidate_codec) {
+        candidate_codec = codec;
+        candidate_count = 0;
+    }
+    // 첫 패킷은 바로, 이후 전환은 연속 SWITCH_HYSTERESIS개가 같을 때
+    if (current_codec != CODEC_NONE && ++candidate_count < SWITCH_HYSTERESIS)
+        return GST_PAD_PROBE_DROP; // 판정 중인 패킷은 지금 branch가 해석할 수 없다
+
+    candidate_count = 0;
+    if (!swap_branch(pad, codec)) return GST_PAD_PROBE_DROP;
+    return GST_PAD_PROBE_OK;
+}
+
+// 📌 jitterbuffer 입력: seqnum별 도착 시각
+static GstPadProbeReturn on_jitterbuffer_input(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+
+    if (gst_rtp_buffer_map(GST_PAD_PROBE_INFO_BUFFER(info), GST_MAP_READ, &rtp)) {
+        g_atomic_pointer_set(&arrival_us[gst_rtp_buffer_get_seq(&rtp)], (gsize)g_get_monotonic_time());
+        gst_rtp_buffer_unmap(&rtp);
+        g_atomic_pointer_add(&received, 1);
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+// 📌 decoder 출력 (tail 입력): 전환 간격
+static GstPadProbeReturn on_decoded(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    gint64 now = g_get_monotonic_time();
+
+    g_mutex_lock(&switch_lock);
+    if (switch_pending) {
+        last_gap_ms = (now - last_output_us) / 1000.0;
+        max_gap_ms = MAX(max_gap_ms, last_gap_ms);
+        switches++;
+        switch_pending = FALSE;
+        g_print("[RECEIVER] 전환 간격 %.2f ms (판정 후 첫 출력까지 %.2f ms)\n",
+                last_gap_ms, (now - switch_requested_us) / 1000.0);
+    }
+    last_output_us = now;
+    g_mutex_unlock(&switch_lock);
+    return GST_PAD_PROBE_OK;
+}
+
+// 📌 sink 입력: 재생 시각 - 송신 capture 시각 (decoder는 PTS를 유지하므로 가장 가까운 앞 stamp에서 보간)
+static GstPadProbeReturn on_sink_input(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstClockTime pts = GST_BUFFER_PTS(buffer);
+    gint64 play_us, g2g_us;
+
+    if (!GST_CLOCK_TIME_IS_VALID(pts) || stamp_head == 0) return GST_PAD_PROBE_OK;
+
+    for (guint i = 1; i <= MIN(stamp_head, STAMP_RING); i++) {
+        CaptureStamp *stamp = &stamps[(stamp_head - i) % STAMP_RING];
+
+        if (stamp->pts > pts) continue;
+        play_us = null_sink ? g_get_monotonic_time()
+                            : latency_profile_pts_to_monotonic(pad, pts, (gsize)g_atomic_pointer_get(&pipeline_latency_ns));
+        if (play_us < 0) break;
+        g2g_us = play_us - (stamp->capture_us + (gint64)((pts - stamp->pts) / GST_USECOND));
+        if (g2g_us < 0) break; // 다른 호스트의 stamp
+        g_atomic_pointer_add(&g2g_sum_us, g2g_us);
+        g_atomic_pointer_add(&g2g_count, 1);
+        atomic_max(&g2g_max_us, g2g_us);
+        break;
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+// 📌 pipeline 지연 (sink가 버퍼를 내보내는 시각 = running time + 이 값)
+static void update_pipeline_latency(void) {
+    GstQuery *query = gst_query_new_latency();
+
+    if (gst_element_query(pipeline, query)) {
+        GstClockTime min_latency;
+        gst_query_parse_latency(query, NULL, &min_latency, NULL);
+        if (GST_CLOCK_TIME_IS_VALID(min_latency)) g_atomic_pointer_set(&pipeline_latency_ns, (gpointer)(gsize)min_latency);
+    }
+    gst_query_unref(query);
+}
+
+static void on_deep_element_added(GstBin *bin, GstBin *sub_bin, GstElement *element, gpointer user_data) {
+    latency_profile_tune_element(element);
+}
+
+static void read_jitterbuffer_stats(guint64 *pushed, guint64 *lost, guint64 *late, guint64 *avg_jitter_ns) {
+    GstStructure *stats = NULL;
+
+    *pushed = *lost = *late = *avg_jitter_ns = 0;
+    g_object_get(jitterbuffer, "stats", &stats, NULL);
+    if (!stats) return;
+    gst_structure_get_uint64(stats, "num-pushed", pushed);
+    gst_structure_get_uint64(stats, "num-lost", lost);
+    gst_structure_get_uint64(stats, "num-late", late);
+    gst_structure_get_uint64(stats, "avg-jitter", avg_jitter_ns);
+    gst_structure_free(stats);
+}
+
+static gboolean on_report(gpointer user_data) {
+    static gsize last_received = 0;
+    static gint64 last_us = 0;
+    gint64 now = g_get_monotonic_time();
+    gsize rx = g_atomic_pointer_get(&received);
+    gsize sum = g_atomic_pointer_get(&residence_sum_us);
+    gsize count = g_atomic_pointer_get(&residence_count);
+    gsize max = g_atomic_pointer_get(&residence_max_us);
+    guint64 pushed, lost, late, jitter;
+    gsize g2g_sum = g_atomic_pointer_get(&g2g_sum_us);
+    gsize g2g_n = g_atomic_pointer_get(&g2g_count);
+    gsize g2g_max = g_atomic_pointer_get(&g2g_max_us);
+
+    // 구간 값으로 만들고 0으로 (누적은 RESULT용으로 따로)
+    g_atomic_pointer_add(&residence_sum_us, -(gssize)sum);
+    g_atomic_pointer_add(&residence_count, -(gssize)count);
+    g_atomic_pointer_set(&residence_max_us, 0);
+    total_residence_ms += sum / 1000.0;
+    total_residence_count += count;
+    peak_residence_ms = MAX(peak_residence_ms, max / 1000.0);
+    g_atomic_pointer_add(&g2g_sum_us, -(gssize)g2g_sum);
+    g_atomic_pointer_add(&g2g_count, -(gssize)g2g_n);
+    g_atomic_pointer_set(&g2g_max_us, 0);
+    total_g2g_ms += g2g_sum / 1000.0;
+    total_g2g_count += g2g_n;
+    peak_g2g_ms = MAX(peak_g2g_ms, g2g_max / 1000.0);
+
+    read_jitterbuffer_stats(&pushed, &lost, &late, &jitter);
+    g_print("[RECEIVER] %s, %.0f pps, jitterbuffer 체류 평균 %.2f ms / 최대 %.2f ms (설정 %d ms), "
+            "lost %" G_GUINT64_FORMAT ", late %" G_GUINT64_FORMAT ", jitter %.2f ms, 전환 %u회 (마지막 %.2f ms)\n",
+            current_codec == CODEC_NONE ? "(수신 대기)" : codecs[current_codec].name,
+            last_us ? (rx - last_received) / ((now - last_us) / 1e6) : 0.0,
+            count ? sum / 1000.0 / count : 0.0, max / 1000.0, latency_ms,
+            lost, late, jitter / 1e6, switches, last_gap_ms);
+
+    if (g2g_n)
+        g_print("[RECEIVER] glass-to-glass 평균 %.2f ms / 최대 %.2f ms (pipeline 지연 %.2f ms 포함)\n",
+                g2g_sum / 1000.0 / g2g_n, g2g_max / 1000.0,
+                (gsize)g_atomic_pointer_get(&pipeline_latency_ns) / 1e6);
+
+    last_received = rx;
+    last_us = now;
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_duration_done(gpointer user_data) {
+    g_main_loop_quit(main_loop);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean bus_call(GstBus *bus, GstMessage *msg, gpointer data) {
+    switch (GST_MESSAGE_TYPE(msg)) {
+    case GST_MESSAGE_ERROR: {
+        GError *err = NULL;
+        gst_message_parse_error(msg, &err, NULL);
+        g_printerr("[RECEIVER] 에러 (%s): %s\n", GST_OBJECT_NAME(msg->src), err->message);
+        g_error_free(err);
+        g_main_loop_quit(main_loop);
+        break;
+    }
+    case GST_MESSAGE_EOS:
+        g_main_loop_quit(main_loop);
+        break;
+    case GST_MESSAGE_LATENCY:
+        gst_bin_recalculate_latency(GST_BIN(pipeline));
+        update_pipeline_latency();
+        break;
+    case GST_MESSAGE_ASYNC_DONE:
+        update_pipeline_latency();
+        break;
+    default:
+        break;
+    }
+    return TRUE;
+}
+
+static void print_result(void) {
+    struct rusage usage;
+    guint64 pushed, lost, late, jitter;
+
+    on_report(NULL); // 마지막 구간
+    read_jitterbuffer_stats(&pushed, &lost, &late, &jitter);
+    getrusage(RUSAGE_SELF, &usage);
+    g_print("RESULT received=%" G_GSIZE_FORMAT " dropped=%" G_GSIZE_FORMAT " pushed=%" G_GUINT64_FORMAT
+            " lost=%" G_GUINT64_FORMAT " late=%" G_GUINT64_FORMAT " switches=%u max_gap_ms=%.2f jb_avg_ms=%.2f"
+            " jb_max_ms=%.2f jitter_ms=%.2f g2g_avg_ms=%.2f g2g_max_ms=%.2f cpu_s=%.3f\n",
+            (gsize)g_atomic_pointer_get(&received), (gsize)g_atomic_pointer_get(&dropped), pushed, lost, late,
+            switches, max_gap_ms,
+            total_residence_count ? total_residence_ms / total_residence_count : 0.0, peak_residence_ms,
+            jitter / 1e6, total_g2g_count ? total_g2g_ms / total_g2g_count : 0.0, peak_g2g_ms,
+            usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+                (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6);
+}
+
+int main(int argc, char *argv[]) {
+    GOptionContext *context;
+    GError *error = NULL;
+    GstElement *udpsrc, *resample, *sink;
+    GstCaps *caps;
+    GstPad *pad;
+    GstBus *bus;
+    LatencyProfile latency = LATENCY_DEFAULT;
+
+    gst_init(&argc, &argv);
+
+    context = g_option_context_new("- PCM/AC3/Opus RTP 수신기 (코덱 전환 자동)");
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("옵션 파싱 실패: %s\n", error->message);
+        g_error_free(error);
+        g_option_context_free(context);
+        return -1;
+    }
+    g_option_context_free(context);
+    if (latency_profile_name && !latency_profile_parse(latency_profile_name, &latency)) {
+        g_printerr("알 수 없는 지연 프로필: %s (default / low)\n", latency_profile_name);
+        return -1;
+    }
+    latency_profile_configure(latency, 0);
+    if (drop_probability < 0 || drop_probability > 1) {
+        g_printerr("--drop-probability는 0~1\n");
+        return -1;
+    }
+    if (latency_ms < 0) latency_ms = latency_profile_jitterbuffer_ms(DEFAULT_LATENCY_MS);
+
+    main_loop = g_main_loop_new(NULL, FALSE);
+    pipeline = gst_pipeline_new("receiver");
+    udpsrc = gst_element_factory_make("udpsrc", NULL);
+    jitterbuffer = gst_element_factory_make("rtpjitterbuffer", NULL);
+    tail = gst_element_factory_make("audioconvert", NULL);
+    resample = gst_element_factory_make("audioresample", NULL);
+    if (null_sink) {
+        sink = gst_element_factory_make("fakesink", NULL);
+        if (sink) g_object_set(sink, "sync", FALSE, NULL);
+    } else {
+        sink = gst_element_factory_make(sink_name ? sink_name : "autoaudiosink", NULL);
+    }
+    if (!pipeline || !udpsrc || !jitterbuffer || !tail || !resample || !sink) {
+        g_printerr("[RECEIVER] 요소 생성 실패\n");
+        return -1;
+    }
+
+    // 시작 caps는 Opus로 두고, 다른 PT는 request-pt-map으로
+    for (gint i = 0; i < CODEC_COUNT; i++) codecs[i].caps = make_codec_caps(i);
+    caps = gst_caps_new_simple("application/x-rtp",
+                               "media", G_TYPE_STRING, "audio",
+                               "clock-rate", G_TYPE_INT, CLOCK_RATE,
+                               NULL);
+    g_object_set(udpsrc, "port", port, "caps", caps, NULL);
+    gst_caps_unref(caps);
+
+    g_object_set(jitterbuffer,
+                 "latency", (guint)latency_ms,
+                 "drop-on-latency", drop_on_latency,
+                 "do-lost", TRUE,
+                 NULL);
+    if (jb_mode) gst_util_set_object_arg(G_OBJECT(jitterbuffer), "mode", jb_mode);
+    g_signal_connect(jitterbuffer, "request-pt-map", G_CALLBACK(on_request_pt_map), NULL);
+
+    gst_bin_add_many(GST_BIN(pipeline), udpsrc, jitterbuffer, tail, resample, sink, NULL);
+    if (!(use_rtcp ? add_rtcp_session(udpsrc) : gst_element_link(udpsrc, jitterbuffer)) ||
+        !gst_element_link_many(tail, resample, sink, NULL)) {
+        g_printerr("[RECEIVER] 연결 실패\n");
+        return -1;
+    }
+    if (drop_probability > 0) {
+        pad = gst_element_get_static_pad(udpsrc, "src");
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, on_network_input, NULL, NULL);
+        gst_object_unref(pad);
+    }
+
+    // 코덱별 branch를 미리 만들어 둔다 (전환 때는 링크만 바꿈)
+    for (gint i = 0; i < CODEC_COUNT; i++) {
+        codecs[i].branch = make_branch(&codecs[i]);
+        if (codecs[i].branch) gst_bin_add(GST_BIN(pipeline), codecs[i].branch);
+    }
+
+    pad = gst_element_get_static_pad(jitterbuffer, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, on_jitterbuffer_input, NULL, NULL);
+    gst_object_unref(pad);
+    pad = gst_element_get_static_pad(jitterbuffer, "src");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, on_jitterbuffer_output, NULL, NULL);
+    gst_object_unref(pad);
+    pad = gst_element_get_static_pad(tail, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, on_decoded, NULL, NULL);
+    gst_object_unref(pad);
+    pad = gst_element_get_static_pad(sink, "sink");
+    if (pad) {
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, on_sink_input, NULL, NULL);
+        gst_object_unref(pad);
+    }
+
+    // audio sink는 autoaudiosink 안에서 나중에 생기므로 추가될 때 조정한다
+    latency_profile_tune_element(sink);
+    g_signal_connect(pipeline, "deep-element-added", G_CALLBACK(on_deep_element_added), NULL);
+
+    bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline));
+    gst_bus_add_watch(bus, bus_call, NULL);
+    gst_object_unref(bus);
+
+    g_print("[RECEIVER] UDP %d 수신 (jitterbuffer %d ms, PT Opus=%d AC3=%d L16=%d L24=%d E-AC3=%d AAC=%d)\n",
+            port, latency_ms, codecs[CODEC_OPUS].pt, codecs[CODEC_AC3].pt, codecs[CODEC_L16].pt,
+            codecs[CODEC_L24].pt, codecs[CODEC_EAC3].pt, codecs[CODEC_AAC].pt);
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+    if (report_interval_s > 0) g_timeout_add_seconds(report_interval_s, on_report, NULL);
+    if (duration_s > 0) g_timeout_add_seconds(duration_s, on_duration_done, NULL);
+    g_main_loop_run(main_loop);
+
+    print_result();
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+    for (gint i = 0; i < CODEC_COUNT; i++) gst_caps_unref(codecs[i].caps);
+    g_free(jb_mode);
+    g_free(sink_name);
+    g_free(latency_profile_name);
+    g_free(rtcp_dest);
+    g_main_loop_unref(main_loop);
+    return 0;
+}
@@ -1,12 +1,58 @@
 // send_from_file.c
 /*
 * 사용 시: send_audio_file_to_appsrc("sample.pcm", appsrc, "PCM");
+*         send_audio_file_mmap_to_appsrc("sample.ac3", appsrc, "AC3", 0);  // mmap, 복사 없음
+*         (mmap 모드는 ../common/ac3_frame.c, 버퍼 모드는 ../common/producer_pool.c, 둘 다 pacer.c 필요)
+*
+* 속도: 기본은 pipeline clock 기준 실시간. send_from_file_set_max_throughput(TRUE)이면
+*       downstream이 받는 만큼 최대 속도로 보낸다 (일괄 변환/부하 테스트용).
 */
 #include <gst/gst.h>
 #include <gst/app/gstappsrc.h>
+#include <sys/mman.h>
 
 #define BUFFER_SIZE 4096
 
+// PCM 입력: 48kHz, 2ch, S16LE
+#define PCM_RATE 48000
+#define PCM_BYTES_PER_FRAME (2 * 2)
+
+// mmap 모드 기본 chunk 크기
+#define DEFAULT_PCM_PERIOD_FRAMES 960  // 20ms (Opus 프레임 한 개 분량)
+#define DEFAULT_AC3_FRAMES_PER_CHUNK 4 // AC3 프레임(1536 샘플) 4개 = 128ms @48kHz
+#define AC3_SAMPLES_PER_FRAME 1536
+
+// ../common/ac3_frame.c
+guint ac3_frame_size(const guint8 *data, gsize len);
+guint ac3_sample_rate(const guint8 *data, gsize len);
+const guint8 *ac3_find_sync(const guint8 *data, gsize len);
+
+// ../common/ring_logger.c (fmt는 문자열 리터럴, 스트리밍 스레드에서 막히지 않음)
+void ring_log(const gchar *fmt, ...) G_GNUC_PRINTF(1, 2);
+void ring_log_error(const gchar *fmt, ...) G_GNUC_PRINTF(1, 2);
+
+// pacer.c
+typedef struct _Pacer Pacer;
+Pacer *pacer_new(GstElement *appsrc, gboolean max_throughput);
+void pacer_wait(Pacer *pacer, GstClockTime pts, GstClockTime duration, gsize size);
+void pacer_report(Pacer *pacer);
+void pacer_free(Pacer *pacer);
+
+// ../common/producer_pool.c
+typedef struct _ProducerPool ProducerPool;
+ProducerPool *producer_pool_new(guint buffer_size, guint max_buffers);
+GstBuffer *producer_pool_acquire(ProducerPool *pp);
+void producer_pool_get_stats(ProducerPool *pp, guint64 *hits, guint64 *misses);
+void producer_pool_free(ProducerPool *pp);
+
+#define FILE_POOL_BUFFERS 32
+
+static gboolean max_throughput = FALSE;
+
+void send_from_file_set_max_throughput(gboolean enable) {
+    max_throughput = enable;
+}
+
 void send_audio_file_to_appsrc(const char *filename, GstElement *appsrc, const char *format) {
     FILE *fp = fopen(filename, "rb");
     if (!fp) {
@@ -14,30 +60,160 @@ void send_audio_file_to_appsrc(const char *filename, GstElement *appsrc, const c
         return;
     }
 
-    guint8 buffer_data[BUFFER_SIZE];
+    ProducerPool *pool = producer_pool_new(BUFFER_SIZE, FILE_POOL_BUFFERS);
     GstBuffer *buffer;
     GstFlowReturn ret;
+    GstMapInfo map;
     size_t bytes_read;
     GstClockTime timestamp = 0;
     int count = 0;
+    guint64 hits, misses;
+    Pacer *pacer = pacer_new(appsrc, max_throughput);
+
+    while (TRUE) {
+        // 풀 버퍼에 바로 읽어 들인다 (중간 스택 버퍼/g_memdup 없음)
+        buffer = producer_pool_acquire(pool);
+        gst_buffer_map(buffer, &map, GST_MAP_WRITE);
+        bytes_read = fread(map.data, 1, BUFFER_SIZE, fp);
+        gst_buffer_unmap(buffer, &map);
+        if (bytes_read == 0) {
+            gst_buffer_unref(buffer);
+            break;
+        }
+        if (bytes_read < BUFFER_SIZE) gst_buffer_set_size(buffer, bytes_read);
 
-    while ((bytes_read = fread(buffer_data, 1, BUFFER_SIZE, fp)) > 0) {
-        buffer = gst_buffer_new_wrapped(g_memdup(buffer_data, bytes_read), bytes_read);
         GST_BUFFER_PTS(buffer) = timestamp;
         GST_BUFFER_DURATION(buffer) = gst_util_uint64_scale(bytes_read, GST_SECOND, 48000 * 2 * 2);
         timestamp += GST_BUFFER_DURATION(buffer);
 
+        pacer_wait(pacer, GST_BUFFER_PTS(buffer), GST_BUFFER_DURATION(buffer), bytes_read);
         g_signal_emit_by_name(appsrc, "push-buffer", buffer, &ret);
         gst_buffer_unref(buffer);
+        if (ret != GST_FLOW_OK) {
+            // 파이프라인이 멈췄다 (종료 중이면 FLUSHING)
+            g_printerr("파일 전송 중단: %s\n", gst_flow_get_name(ret));
+            break;
+        }
         count++;
 
-        g_usleep(10000); // 10ms
-
         if (count % 100 == 0) {
-            g_print("  [FILE->appsrc] %d번째 버퍼 전송됨\n", count);
+            ring_log("  [FILE->appsrc] %d번째 버퍼 전송됨\n", count);
+            pacer_report(pacer);
         }
     }
 
     fclose(fp);
-    g_print("📁 파일 전송 완료 (%d개 버퍼)\n", count);
+    producer_pool_get_stats(pool, &hits, &misses);
+    g_print("📁 파일 전송 완료 (%d개 버퍼, 풀 hit %" G_GUINT64_FORMAT " / miss %" G_GUINT64_FORMAT ")\n",
+            count, hits, misses);
+    pacer_report(pacer);
+    pacer_free(pacer);
+    producer_pool_free(pool);
+}
+
+// 📌 AC3 프레임 경계에 맞춘 chunk 길이 계산 (프레임 수/재생 시간도 돌려줌)
+// 시작 위치가 sync가 아니면 0을 돌려준다.
+static gsize ac3_chunk_size(const guint8 *data, gsize len, guint max_frames, GstClockTime *duration) {
+    gsize chunk = 0;
+    guint frames = 0;
+    guint rate = ac3_sample_rate(data, len);
+
+    while (frames < max_frames) {
+        guint frame_size = ac3_frame_size(data + chunk, len - chunk);
+        if (frame_size == 0 || chunk + frame_size > len) break; // sync 아님 또는 잘린 마지막 프레임
+        chunk += frame_size;
+        frames++;
+    }
+
+    *duration = frames ? gst_util_uint64_scale(frames * AC3_SAMPLES_PER_FRAME, GST_SECOND, rate) : 0;
+    return chunk;
+}
+
+/*
+ * mmap 모드: 파일을 한 번 매핑하고, 각 chunk를 매핑된 영역을 직접 가리키는 GstMemory로 감싸서 전송.
+ * fread/g_memdup 복사와 chunk마다의 malloc이 없다. 매핑은 마지막 버퍼가 해제될 때 풀린다.
+ *
+ * chunk_frames: PCM이면 period 길이(샘플 프레임 수), AC3면 chunk당 AC3 프레임 수. 0이면 기본값.
+ */
+void send_audio_file_mmap_to_appsrc(const char *filename, GstElement *appsrc, const char *format,
+                                    guint chunk_frames) {
+    GError *error = NULL;
+    GMappedFile *mapped = g_mapped_file_new(filename, FALSE, &error);
+    gboolean is_ac3 = (g_strcmp0(format, "AC3") == 0);
+    const guint8 *data;
+    gsize size, offset = 0;
+    GstClockTime timestamp = 0;
+    GstFlowReturn ret;
+    int count = 0;
+    Pacer *pacer;
+
+    if (!mapped) {
+        g_printerr("파일 매핑 실패: %s (%s)\n", filename, error->message);
+        g_error_free(error);
+        return;
+    }
+
+    data = (const guint8 *)g_mapped_file_get_contents(mapped);
+    size = g_mapped_file_get_length(mapped);
+    if (chunk_frames == 0)
+        chunk_frames = is_ac3 ? DEFAULT_AC3_FRAMES_PER_CHUNK : DEFAULT_PCM_PERIOD_FRAMES;
+
+    pacer = pacer_new(appsrc, max_throughput);
+
+    // 순차 읽기 힌트 (커널 readahead 확대)
+    if (size > 0)
+        posix_madvise((void *)data, size, POSIX_MADV_SEQUENTIAL);
+
+    while (offset < size) {
+        GstClockTime duration;
+        gsize chunk;
+        GstBuffer *buffer;
+
+        if (is_ac3) {
+            chunk = ac3_chunk_size(data + offset, size - offset, chunk_frames, &duration);
+            if (chunk == 0) {
+                // 프레임 경계가 아니면 다음 syncword로 재동기화
+                const guint8 *next = ac3_find_sync(data + offset + 1, size - offset - 1);
+                if (!next) break;
+                ring_log_error("  [FILE->appsrc] AC3 재동기화: %" G_GSIZE_FORMAT " 바이트 건너뜀\n",
+                               (gsize)(next - (data + offset)));
+                offset = next - data;
+                continue;
+            }
+        } else {
+            chunk = MIN((gsize)chunk_frames * PCM_BYTES_PER_FRAME, size - offset);
+            chunk -= chunk % PCM_BYTES_PER_FRAME;
+            if (chunk == 0) break; // 프레임 단위가 아닌 꼬리 바이트
+            duration = gst_util_uint64_scale(chunk, GST_SECOND, PCM_RATE * PCM_BYTES_PER_FRAME);
+        }
+
+        // 매핑 영역을 그대로 감싼다 (버퍼마다 매핑 참조 하나)
+        buffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY, (gpointer)data, size,
+                                             offset, chunk, g_mapped_file_ref(mapped),
+                                             (GDestroyNotify)g_mapped_file_unref);
+        GST_BUFFER_PTS(buffer) = timestamp;
+        GST_BUFFER_DURATION(buffer) = duration;
+        timestamp += duration;
+        offset += chunk;
+
+        pacer_wait(pacer, GST_BUFFER_PTS(buffer), duration, chunk);
+        g_signal_emit_by_name(appsrc, "push-buffer", buffer, &ret);
+        gst_buffer_unref(buffer);
+        if (ret != GST_FLOW_OK) {
+            // 파이프라인이 멈췄다 (종료 중이면 FLUSHING)
+            g_printerr("파일 전송 중단: %s\n", gst_flow_get_name(ret));
+            break;
+        }
+        count++;
+
+        if (count % 100 == 0) {
+            ring_log("  [FILE->appsrc] %d번째 버퍼 전송됨 (mmap)\n", count);
+            pacer_report(pacer);
+        }
+    }
+
+    g_mapped_file_unref(mapped);
+    g_print("📁 파일 전송 완료 (mmap, %d개 버퍼)\n", count);
+    pacer_report(pacer);
+    pacer_free(pacer);
 }
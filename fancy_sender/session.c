@@ -0,0 +1,307 @@
+// session.c
+/*
+ * 한 프로세스에서 여러 스트림(세션)을 보내기 위한 세션 컨텍스트
+ *
+ *  세션 = pipeline + appsrc + 전환기 상태(appsrc에 붙음) + 입력 생성기 + 포트/포맷
+ *  공유 = main loop(전환/bus), 입력 생성 worker pool, live_swap 정리 스레드
+ *
+ * 입력 생성은 세션마다 타이머/스레드를 두지 않고, 하나의 타이머가 모든 세션의 작업을
+ * 공유 GThreadPool에 넣는다. 이전 작업이 아직 끝나지 않은 세션은 그 tick을 건너뛴다.
+ * (인코딩은 세션 pipeline의 appsrc 스트리밍 스레드에서 돈다)
+ *
+ * 사용:
+ *   session_system_init(4, 20);
+ *   Session *s = session_new(0, 5000, FALSE, FALSE);
+ *   session_switch(s, TRUE);
+ *   session_add_destination(s, "10.0.0.7", 5000);   // 같은 인코딩 출력을 한 곳 더
+ *   session_free(s);
+ *   session_system_shutdown();
+ */
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+
+#include "../common/stream_metrics.h" // 전환기와 같은 이름(appsrc 이름)으로 등록해 같은 지표를 쓴다
+#include "../common/synth_source.h"
+
+#define SESSION_RATE 48000
+#define SESSION_CHANNELS 2
+#define SESSION_POOL_BUFFERS 8
+#define AC3_FRAME_BYTES 768      // synth AC3 burst 프레임 (48kHz, 192kbps)
+#define AC3_FRAME_US 32000       // 1536 샘플 @48kHz
+
+// format_switcher.c
+void switch_to_pcm_pipeline(GstElement *appsrc);
+void switch_to_ac3_pipeline(GstElement *appsrc);
+gboolean prepare_standby_bins(GstElement *upstream, gboolean ac3_passthrough);
+void format_switcher_set_port(GstElement *upstream, guint port);
+gboolean format_switcher_add_destination(GstElement *upstream, const gchar *host, guint port);
+gboolean format_switcher_remove_destination(GstElement *upstream, const gchar *host, guint port);
+
+// ../common/codec_registry.c (raw 입력은 48 kHz stereo S16LE = SESSION_RATE/SESSION_CHANNELS)
+void codec_registry_init(void);
+GstCaps *codec_registry_get_input_caps(const gchar *name);
+
+// ../common/producer_pool.c
+typedef struct _ProducerPool ProducerPool;
+ProducerPool *producer_pool_new(guint buffer_size, guint max_buffers);
+GstBuffer *producer_pool_acquire(ProducerPool *pp);
+void producer_pool_free(ProducerPool *pp);
+
+typedef struct _Session {
+    guint id;
+    guint port;
+    GstElement *pipeline, *appsrc;
+    guint bus_watch_id;
+
+    gboolean is_ac3;          // main loop에서만 변경
+    volatile gint ac3_input;  // worker가 읽는 입력 포맷
+    volatile gint busy;       // worker가 처리 중이면 1
+    GMutex busy_lock;         // busy가 0이 되는 것을 session_free가 기다린다
+    GCond idle_cond;
+
+    // 입력 생성 (worker 스레드에서만 접근, busy로 직렬화)
+    ProducerPool *pool;
+    SynthSource *pcm_synth, *ac3_synth;
+    gint64 ac3_credit_us;     // 아직 보내지 않은 AC3 재생 시간
+    gboolean caps_ac3;        // appsrc에 마지막으로 넣은 caps의 포맷
+
+    volatile gsize pushed;
+    volatile gsize skipped;   // worker가 밀려서 건너뛴 tick
+
+    StreamMetrics *metrics;   // 모니터용 (생산자 CPU, appsrc 대기량, drop)
+} Session;
+
+// 공유 자원 (main loop에서만 변경)
+static GThreadPool *feed_workers = NULL;
+static GPtrArray *sessions = NULL;
+static guint feed_interval_ms = 0;
+static guint feed_timer_id = 0;
+
+// 입력 caps는 등록부가 미리 만들어 둔 것 (세션마다/전환마다 새로 만들지 않는다)
+static GstCaps *input_caps(gboolean is_ac3) {
+    return codec_registry_get_input_caps(is_ac3 ? "ac3-passthrough" : "opus");
+}
+
+// 📌 worker 스레드: 세션 하나의 입력 한 tick 분량을 만들어 appsrc로
+// 포맷이 바뀐 뒤 첫 버퍼는 새 caps와 함께 sample로 넣어서 caps 변경이 버퍼 순서 안에 들어가게 한다
+static void feed_session(gpointer data, gpointer user_data) {
+    Session *session = data;
+    gsize pcm_bytes = (gsize)SESSION_RATE * SESSION_CHANNELS * 2 * feed_interval_ms / 1000;
+    gboolean ac3 = g_atomic_int_get(&session->ac3_input);
+    guint64 cpu_start = stream_metrics_thread_cpu_ns();
+    GstBuffer *buffer;
+    GstMapInfo map;
+    gsize size;
+
+    if (ac3) {
+        // AC3는 프레임 단위로만 보낼 수 있으므로 쌓인 시간만큼 프레임을 보낸다
+        guint frames;
+
+        session->ac3_credit_us += (gint64)feed_interval_ms * 1000;
+        frames = MIN(session->ac3_credit_us / AC3_FRAME_US, pcm_bytes / AC3_FRAME_BYTES);
+        session->ac3_credit_us -= (gint64)frames * AC3_FRAME_US;
+        size = frames * AC3_FRAME_BYTES;
+    } else {
+        session->ac3_credit_us = 0;
+        size = pcm_bytes;
+    }
+
+    if (size > 0) {
+        buffer = producer_pool_acquire(session->pool);
+        gst_buffer_map(buffer, &map, GST_MAP_WRITE);
+        synth_source_fill(ac3 ? session->ac3_synth : session->pcm_synth, map.data, size);
+        gst_buffer_unmap(buffer, &map);
+        if (size < pcm_bytes) gst_buffer_set_size(buffer, size);
+
+        if (ac3 != session->caps_ac3) {
+            GstSample *sample = gst_sample_new(buffer, input_caps(ac3), NULL, NULL);
+
+            gst_app_src_push_sample(GST_APP_SRC(session->appsrc), sample); // 버퍼에 ref를 잡는다
+            gst_sample_unref(sample);
+            gst_buffer_unref(buffer);
+            session->caps_ac3 = ac3;
+        } else {
+            gst_app_src_push_buffer(GST_APP_SRC(session->appsrc), buffer); // 소유권 이전
+        }
+        g_atomic_pointer_add(&session->pushed, 1);
+    }
+
+    stream_metrics_set_queue_level(session->metrics, gst_app_src_get_current_level_bytes(GST_APP_SRC(session->appsrc)));
+    stream_metrics_add_cpu(session->metrics, stream_metrics_thread_cpu_ns() - cpu_start);
+
+    g_mutex_lock(&session->busy_lock);
+    g_atomic_int_set(&session->busy, 0);
+    g_cond_broadcast(&session->idle_cond);
+    g_mutex_unlock(&session->busy_lock);
+}
+
+// 📌 공유 타이머: 모든 세션의 tick 작업을 worker pool에 넣는다
+static gboolean on_feed_tick(gpointer user_data) {
+    for (guint i = 0; i < sessions->len; i++) {
+        Session *session = g_ptr_array_index(sessions, i);
+
+        if (!g_atomic_int_compare_and_exchange(&session->busy, 0, 1)) {
+            g_atomic_pointer_add(&session->skipped, 1);
+            stream_metrics_add_drops(session->metrics, 1);
+            continue;
+        }
+        g_thread_pool_push(feed_workers, session, NULL);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean session_bus_call(GstBus *bus, GstMessage *msg, gpointer data) {
+    Session *session = data;
+
+    if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
+        GError *err = NULL;
+        gst_message_parse_error(msg, &err, NULL);
+        g_printerr("[SESSION %u] 에러 (%s): %s\n", session->id, GST_OBJECT_NAME(msg->src), err->message);
+        g_error_free(err);
+    }
+    return TRUE;
+}
+
+// 📌 공유 자원 준비. workers: 입력 생성 스레드 수, interval_ms: 입력 tick 간격
+gboolean session_system_init(guint workers, guint interval_ms) {
+    GError *error = NULL;
+
+    codec_registry_init(); // 첫 세션 생성 전에 factory/caps 준비
+    feed_workers = g_thread_pool_new(feed_session, NULL, MAX(workers, 1), TRUE, &error);
+    if (!feed_workers) {
+        g_printerr("[SESSION] worker pool 생성 실패: %s\n", error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+
+    sessions = g_ptr_array_new();
+    feed_interval_ms = MAX(interval_ms, 1);
+    feed_timer_id = g_timeout_add(feed_interval_ms, on_feed_tick, NULL);
+    return TRUE;
+}
+
+// 📌 세션 생성 (main loop 스레드에서). port로 RTP를 보내고, is_ac3면 AC3 passthrough로 시작
+Session *session_new(guint id, guint port, gboolean is_ac3, gboolean standby) {
+    Session *session = g_new0(Session, 1);
+    gchar *name;
+    GstBus *bus;
+    gsize pcm_bytes = (gsize)SESSION_RATE * SESSION_CHANNELS * 2 * feed_interval_ms / 1000;
+
+    session->id = id;
+    session->port = port;
+    g_mutex_init(&session->busy_lock);
+    g_cond_init(&session->idle_cond);
+
+    name = g_strdup_printf("session-%u", id);
+    session->pipeline = gst_pipeline_new(name);
+    g_free(name);
+    name = g_strdup_printf("session-%u-src", id);
+    session->appsrc = gst_element_factory_make("appsrc", name);
+    session->metrics = stream_metrics_register(name);
+    g_free(name);
+
+    session->pool = producer_pool_new(pcm_bytes, SESSION_POOL_BUFFERS);
+    session->pcm_synth = synth_source_new(SYNTH_SINE, SESSION_RATE, SESSION_CHANNELS,
+                                          220.0 + 10.0 * (id % 64), 0.5);
+    session->ac3_synth = synth_source_new(SYNTH_AC3_BURST, SESSION_RATE, SESSION_CHANNELS, 0.0, 1.0);
+
+    if (!session->pipeline || !session->appsrc || !session->pool) {
+        g_printerr("[SESSION %u] 생성 실패\n", id);
+        if (session->appsrc) gst_object_unref(session->appsrc);
+        if (session->pipeline) gst_object_unref(session->pipeline);
+        producer_pool_free(session->pool);
+        synth_source_free(session->pcm_synth);
+        synth_source_free(session->ac3_synth);
+        g_mutex_clear(&session->busy_lock);
+        g_cond_clear(&session->idle_cond);
+        g_free(session);
+        return NULL;
+    }
+
+    g_object_set(session->appsrc,
+                 "format", GST_FORMAT_TIME,
+                 "is-live", TRUE,
+                 "do-timestamp", TRUE,
+                 NULL);
+    gst_bin_add(GST_BIN(session->pipeline), session->appsrc);
+    format_switcher_set_port(session->appsrc, port);
+
+    // 시작 포맷의 경로를 바로 연결 (대기 모드는 active-pad만 지정)
+    session->is_ac3 = is_ac3;
+    session->ac3_input = is_ac3;
+    session->caps_ac3 = is_ac3;
+    g_object_set(session->appsrc, "caps", input_caps(is_ac3), NULL);
+    if (standby && !prepare_standby_bins(session->appsrc, TRUE)) {
+        g_printerr("[SESSION %u] 대기 모드 준비 실패\n", id);
+    } else if (is_ac3) {
+        switch_to_ac3_pipeline(session->appsrc);
+    } else if (!standby) {
+        switch_to_pcm_pipeline(session->appsrc);
+    }
+
+    bus = gst_pipeline_get_bus(GST_PIPELINE(session->pipeline));
+    session->bus_watch_id = gst_bus_add_watch(bus, session_bus_call, session);
+    gst_object_unref(bus);
+
+    gst_element_set_state(session->pipeline, GST_STATE_PLAYING);
+    g_ptr_array_add(sessions, session);
+    return session;
+}
+
+// 📌 세션 입력/경로 전환 (main loop 스레드에서)
+// appsrc caps는 여기서 바꾸지 않는다: worker가 새 포맷 첫 버퍼와 함께 넣는다 (feed_session)
+void session_switch(Session *session, gboolean is_ac3) {
+    if (session->is_ac3 == is_ac3) return;
+    session->is_ac3 = is_ac3;
+
+    g_atomic_int_set(&session->ac3_input, is_ac3);
+    if (is_ac3) switch_to_ac3_pipeline(session->appsrc);
+    else switch_to_pcm_pipeline(session->appsrc);
+}
+
+// 📌 송출 목적지 추가/삭제 (main loop 스레드에서). 인코딩은 세션당 한 번 그대로
+gboolean session_add_destination(Session *session, const gchar *host, guint port) {
+    return format_switcher_add_destination(session->appsrc, host, port);
+}
+
+gboolean session_remove_destination(Session *session, const gchar *host, guint port) {
+    return format_switcher_remove_destination(session->appsrc, host, port);
+}
+
+void session_get_stats(Session *session, guint64 *pushed, guint64 *skipped) {
+    if (pushed) *pushed = g_atomic_pointer_get(&session->pushed);
+    if (skipped) *skipped = g_atomic_pointer_get(&session->skipped);
+}
+
+// 📌 세션 정리 (main loop 스레드에서)
+void session_free(Session *session) {
+    if (!session) return;
+
+    // 더 이상 작업이 들어가지 않게 한 뒤, 진행 중인 작업이 끝나길 기다린다
+    g_ptr_array_remove(sessions, session);
+    g_mutex_lock(&session->busy_lock);
+    while (g_atomic_int_get(&session->busy)) g_cond_wait(&session->idle_cond, &session->busy_lock);
+    g_mutex_unlock(&session->busy_lock);
+
+    g_source_remove(session->bus_watch_id);
+    gst_element_set_state(session->pipeline, GST_STATE_NULL);
+    gst_object_unref(session->pipeline); // 전환기 상태도 appsrc와 함께 해제됨
+
+    producer_pool_free(session->pool);
+    synth_source_free(session->pcm_synth);
+    synth_source_free(session->ac3_synth);
+    g_mutex_clear(&session->busy_lock);
+    g_cond_clear(&session->idle_cond);
+    g_free(session);
+}
+
+void session_system_shutdown(void) {
+    if (feed_timer_id) g_source_remove(feed_timer_id);
+    feed_timer_id = 0;
+    while (sessions && sessions->len > 0)
+        session_free(g_ptr_array_index(sessions, sessions->len - 1));
+    if (feed_workers) g_thread_pool_free(feed_workers, FALSE, TRUE);
+    feed_workers = NULL;
+    if (sessions) g_ptr_array_free(sessions, TRUE);
+    sessions = NULL;
+}
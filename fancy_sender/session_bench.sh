@@ -0,0 +1,49 @@
+#!/bin/bash
+# session_bench.sh
+# 세션 N개를 한 프로세스(multi_sender -n N)로 돌릴 때와 프로세스 N개(-n 1)로 돌릴 때의
+# CPU 시간 / RSS 비교. 결과는 각 프로세스가 종료 시 찍는 "RESULT ..." 줄을 합산한다.
+#
+# 사용: bash session_bench.sh [실행 시간 초] [세션 수...]
+#       bash session_bench.sh 30 1 64 512
+
+DURATION=${1:-30}
+shift
+COUNTS=${@:-"1 64 512"}
+BASE_PORT=20000
+BIN=./multi_sender
+
+if [ ! -x "$BIN" ]; then
+    echo "$BIN 없음 (make 먼저)" >&2
+    exit 1
+fi
+
+# 512개 프로세스 + 세션당 소켓
+ulimit -n 65536 2>/dev/null
+
+# RESULT 줄에서 key=value 값 꺼내기
+field() {
+    echo "$1" | tr ' ' '\n' | grep "^$2=" | cut -d= -f2
+}
+
+printf "%-8s %-10s %12s %14s %12s\n" "sessions" "mode" "cpu_s" "rss_total_mb" "cpu_%"
+
+for N in $COUNTS; do
+    # 1) 한 프로세스에 N 세션
+    line=$($BIN -n "$N" -p $BASE_PORT -d "$DURATION" 2>/dev/null | grep '^RESULT')
+    cpu=$(field "$line" cpu_s)
+    rss=$(field "$line" max_rss_kb)
+    printf "%-8s %-10s %12.2f %14.1f %12.1f\n" "$N" "shared" "$cpu" \
+        "$(echo "$rss / 1024" | bc -l)" "$(echo "$cpu * 100 / $DURATION" | bc -l)"
+
+    # 2) 프로세스 N개에 1 세션씩
+    tmp=$(mktemp -d)
+    for i in $(seq 0 $((N - 1))); do
+        $BIN -n 1 -p $((BASE_PORT + 2 * i)) -d "$DURATION" 2>/dev/null | grep '^RESULT' > "$tmp/$i" &
+    done
+    wait
+    cpu=$(cat "$tmp"/* | tr ' ' '\n' | grep '^cpu_s=' | cut -d= -f2 | paste -sd+ | bc -l)
+    rss=$(cat "$tmp"/* | tr ' ' '\n' | grep '^max_rss_kb=' | cut -d= -f2 | paste -sd+ | bc -l)
+    rm -rf "$tmp"
+    printf "%-8s %-10s %12.2f %14.1f %12.1f\n" "$N" "processes" "$cpu" \
+        "$(echo "$rss / 1024" | bc -l)" "$(echo "$cpu * 100 / $DURATION" | bc -l)"
+done
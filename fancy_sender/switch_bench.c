@@ -0,0 +1,466 @@
+// switch_bench.c
+/*
+ * 코덱 전환 시 오디오가 끊기는 시간을 측정하는 벤치마크
+ *
+ * 전략별로 N번 PCM <-> AC3 전환을 일으키고, 로컬 udpsrc(5000)로 RTP를 받아서
+ *   - 이전 코덱의 마지막 패킷 ~ 새 코덱의 첫 패킷 간격 (p50/p99/max)
+ *   - 전환 요청 ~ 첫 디코딩 가능 프레임까지의 시간
+ *   - 유실 패킷 수 (sequence 번호 구멍, SSRC/seqnum은 전환을 넘어 이어진다)
+ * 를 CSV(기본) 또는 JSON lines로 출력한다.
+ *
+ * 전략: standby (format_switcher 대기 bin), live-swap (format_switcher 기본),
+ *       basic-rebuild, basic-incremental (basic_sender/sender.c)
+ *
+ * 사용: ./switch_bench -n 20 -i 500 [--json] [--strategy live-swap] [-o result.csv]
+ */
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define UDP_PORT 5000
+#define SAMPLE_RATE 48000
+#define CHANNELS 2
+#define FEED_INTERVAL_MS 10
+#define WARMUP_MS 1000
+#define COOLDOWN_MS 1000
+
+// format_switcher.c
+void switch_to_pcm_pipeline(GstElement *appsrc);
+void switch_to_ac3_encode_pipeline(GstElement *appsrc);
+gboolean prepare_standby_bins(GstElement *upstream, gboolean ac3_passthrough);
+
+// basic_sender/sender.c (SENDER_NO_MAIN으로 빌드)
+void handle_audio_format_change(const char *new_format);
+void init_audio_data_params(const char *format);
+void teardown_pipeline(void);
+extern gboolean incremental_mode;
+extern GMainLoop *main_loop;
+
+typedef enum {
+    STRATEGY_STANDBY,
+    STRATEGY_LIVE_SWAP,
+    STRATEGY_BASIC_REBUILD,
+    STRATEGY_BASIC_INCREMENTAL,
+    N_STRATEGIES
+} Strategy;
+
+static const char *strategy_names[N_STRATEGIES] = {
+    "standby", "live-swap", "basic-rebuild", "basic-incremental"
+};
+
+// 명령행 옵션
+static gint n_switches = 20;
+static gint interval_ms = 500;
+static gboolean json_output = FALSE;
+static gchar *only_strategy = NULL;
+static gchar *output_path = NULL;
+
+static GOptionEntry entries[] = {
+    { "switches", 'n', 0, G_OPTION_ARG_INT, &n_switches, "전략별 전환 횟수 (기본 20)", "N" },
+    { "interval-ms", 'i', 0, G_OPTION_ARG_INT, &interval_ms, "전환 간격 ms (기본 500)", "MS" },
+    { "json", 'j', 0, G_OPTION_ARG_NONE, &json_output, "CSV 대신 JSON lines 출력", NULL },
+    { "strategy", 's', 0, G_OPTION_ARG_STRING, &only_strategy, "하나의 전략만 실행", "NAME" },
+    { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output_path, "결과 파일 (기본 stdout)", "FILE" },
+    { NULL }
+};
+
+// 📌 수신 측 측정 상태 (udpsrc 스트리밍 스레드와 main loop가 공유)
+static struct {
+    GMutex lock;
+
+    gboolean have_pt;
+    guint8 pt;             // 마지막 패킷의 payload type (코덱마다 다름: 96 Opus, 97 AC3, 98 L16)
+    guint16 last_seq;
+    gint64 last_packet_us;
+    guint64 lost;
+
+    // 진행 중인 전환
+    gboolean pending;
+    gboolean gap_recorded;
+    gboolean target_ac3;
+    gint64 request_us;
+
+    GArray *gaps_ms;       // 이전 코덱 마지막 패킷 ~ 새 코덱 첫 패킷
+    GArray *decodable_ms;  // 전환 요청 ~ 첫 디코딩 가능 프레임
+} rx;
+
+static GstElement *recv_pipeline;
+static GstElement *bench_pipeline, *bench_appsrc;
+static guint feed_id;
+static guint64 feed_samples;
+
+static Strategy run_list[N_STRATEGIES];
+static guint run_count, run_index;
+static gint switches_done;
+static FILE *out;
+
+// RTP 헤더 파싱 (RFC 3550)
+static gboolean parse_rtp(const guint8 *d, gsize len, guint16 *seq, guint8 *pt,
+                          const guint8 **payload, gsize *payload_len) {
+    gsize hlen;
+
+    if (len < 12 || (d[0] >> 6) != 2) return FALSE;
+    hlen = 12 + 4 * (d[0] & 0x0F);
+    if (d[0] & 0x10) {
+        if (len < hlen + 4) return FALSE;
+        hlen += 4 + 4 * GST_READ_UINT16_BE(d + hlen + 2);
+    }
+    if (len < hlen) return FALSE;
+
+    *seq = GST_READ_UINT16_BE(d + 2);
+    *pt = d[1] & 0x7F;
+    *payload = d + hlen;
+    *payload_len = len - hlen;
+    if ((d[0] & 0x20) && *payload_len > 0)
+        *payload_len -= MIN(d[len - 1], *payload_len);
+    return TRUE;
+}
+
+// Opus/L16 패킷은 각각 독립적으로 디코딩 가능.
+// AC3 (RFC 4184)는 2바이트 헤더 뒤가 프레임 시작(0x0B77)이어야 하고 FT=3(중간 조각)은 안 됨.
+static gboolean is_decodable(gboolean ac3, const guint8 *payload, gsize len) {
+    if (len == 0) return FALSE;
+    if (!ac3) return TRUE;
+    return len >= 4 && (payload[0] & 0x03) != 3 && payload[2] == 0x0B && payload[3] == 0x77;
+}
+
+static GstPadProbeReturn on_rtp_packet(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    gint64 now = g_get_monotonic_time();
+    const guint8 *payload;
+    gsize payload_len;
+    guint16 seq;
+    guint8 pt;
+    GstMapInfo map;
+
+    if (!gst_buffer_map(buffer, &map, GST_MAP_READ)) return GST_PAD_PROBE_OK;
+    if (!parse_rtp(map.data, map.size, &seq, &pt, &payload, &payload_len)) {
+        gst_buffer_unmap(buffer, &map);
+        return GST_PAD_PROBE_OK;
+    }
+
+    g_mutex_lock(&rx.lock);
+    if (rx.have_pt) {
+        // seqnum은 전환을 넘어 이어지므로 경계의 유실도 센다
+        guint16 gap_seq = seq - (guint16)(rx.last_seq + 1);
+        if (gap_seq != 0 && gap_seq < 1000) rx.lost += gap_seq;
+    }
+    if (!rx.have_pt || pt != rx.pt) {
+        // SSRC는 전환해도 그대로라서 코덱이 바뀐 것은 payload type으로 안다
+        if (rx.have_pt && rx.pending && !rx.gap_recorded) {
+            gdouble gap = (now - rx.last_packet_us) / 1000.0;
+            g_array_append_val(rx.gaps_ms, gap);
+            rx.gap_recorded = TRUE;
+        }
+        rx.pt = pt;
+        rx.have_pt = TRUE;
+    }
+    rx.last_seq = seq;
+    rx.last_packet_us = now;
+
+    if (rx.pending && rx.gap_recorded && is_decodable(rx.target_ac3, payload, payload_len)) {
+        gdouble t = (now - rx.request_us) / 1000.0;
+        g_array_append_val(rx.decodable_ms, t);
+        rx.pending = FALSE;
+    }
+    g_mutex_unlock(&rx.lock);
+
+    gst_buffer_unmap(buffer, &map);
+    return GST_PAD_PROBE_OK;
+}
+
+static void receiver_reset(void) {
+    g_mutex_lock(&rx.lock);
+    rx.have_pt = FALSE;
+    rx.lost = 0;
+    rx.pending = FALSE;
+    g_array_set_size(rx.gaps_ms, 0);
+    g_array_set_size(rx.decodable_ms, 0);
+    g_mutex_unlock(&rx.lock);
+}
+
+static gboolean start_receiver(void) {
+    GError *error = NULL;
+    GstElement *sink;
+    GstPad *pad;
+    gchar *desc = g_strdup_printf(
+        "udpsrc port=%d caps=application/x-rtp ! fakesink name=rtpsink sync=false", UDP_PORT);
+
+    recv_pipeline = gst_parse_launch(desc, &error);
+    g_free(desc);
+    if (!recv_pipeline) {
+        g_printerr("수신 pipeline 생성 실패: %s\n", error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+
+    sink = gst_bin_get_by_name(GST_BIN(recv_pipeline), "rtpsink");
+    pad = gst_element_get_static_pad(sink, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, on_rtp_packet, NULL, NULL);
+    gst_object_unref(pad);
+    gst_object_unref(sink);
+
+    gst_element_set_state(recv_pipeline, GST_STATE_PLAYING);
+    return TRUE;
+}
+
+// 📌 fancy 전략용 입력: 10ms마다 440Hz 사인파 PCM (AC3 전환은 인코딩 경로를 쓴다)
+static gboolean feed_sine(gpointer data) {
+    guint frames = SAMPLE_RATE * FEED_INTERVAL_MS / 1000;
+    GstBuffer *buffer = gst_buffer_new_allocate(NULL, frames * CHANNELS * sizeof(gint16), NULL);
+    GstMapInfo map;
+
+    gst_buffer_map(buffer, &map, GST_MAP_WRITE);
+    gint16 *samples = (gint16 *)map.data;
+    for (guint i = 0; i < frames; i++) {
+        gint16 v = (gint16)(8000 * sin(2 * G_PI * 440 * (gdouble)(feed_samples + i) / SAMPLE_RATE));
+        samples[i * CHANNELS] = samples[i * CHANNELS + 1] = v;
+    }
+    gst_buffer_unmap(buffer, &map);
+    feed_samples += frames;
+
+    gst_app_src_push_buffer(GST_APP_SRC(bench_appsrc), buffer);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean start_fancy_sender(Strategy strategy) {
+    GstCaps *caps;
+
+    bench_pipeline = gst_pipeline_new("bench-sender");
+    bench_appsrc = gst_element_factory_make("appsrc", "bench-src");
+    caps = gst_caps_new_simple("audio/x-raw",
+                               "format", G_TYPE_STRING, "S16LE",
+                               "rate", G_TYPE_INT, SAMPLE_RATE,
+                               "channels", G_TYPE_INT, CHANNELS,
+                               "layout", G_TYPE_STRING, "interleaved",
+                               NULL);
+    g_object_set(bench_appsrc,
+                 "caps", caps,
+                 "format", GST_FORMAT_TIME,
+                 "is-live", TRUE,
+                 "do-timestamp", TRUE,
+                 NULL);
+    gst_caps_unref(caps);
+    gst_bin_add(GST_BIN(bench_pipeline), bench_appsrc);
+
+    if (strategy == STRATEGY_STANDBY) {
+        if (!prepare_standby_bins(bench_appsrc, FALSE)) return FALSE;
+    } else {
+        switch_to_pcm_pipeline(bench_appsrc);
+    }
+
+    gst_element_set_state(bench_pipeline, GST_STATE_PLAYING);
+    feed_samples = 0;
+    feed_id = g_timeout_add(FEED_INTERVAL_MS, feed_sine, NULL);
+    return TRUE;
+}
+
+static gboolean start_strategy(Strategy strategy) {
+    switch (strategy) {
+    case STRATEGY_STANDBY:
+    case STRATEGY_LIVE_SWAP:
+        return start_fancy_sender(strategy);
+    case STRATEGY_BASIC_REBUILD:
+    case STRATEGY_BASIC_INCREMENTAL:
+        incremental_mode = (strategy == STRATEGY_BASIC_INCREMENTAL);
+        init_audio_data_params("PCM");
+        handle_audio_format_change("PCM");
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+static void stop_strategy(Strategy strategy) {
+    if (strategy == STRATEGY_STANDBY || strategy == STRATEGY_LIVE_SWAP) {
+        g_source_remove(feed_id);
+        feed_id = 0;
+        gst_element_set_state(bench_pipeline, GST_STATE_NULL);
+        gst_object_unref(bench_pipeline);
+        bench_pipeline = bench_appsrc = NULL; // 전환기 상태도 appsrc와 함께 해제됨
+    } else {
+        teardown_pipeline();
+    }
+}
+
+static void request_switch(Strategy strategy, gboolean to_ac3) {
+    const char *format = to_ac3 ? "AC3" : "PCM";
+
+    g_mutex_lock(&rx.lock);
+    rx.pending = TRUE;
+    rx.gap_recorded = FALSE;
+    rx.target_ac3 = to_ac3;
+    rx.request_us = g_get_monotonic_time();
+    g_mutex_unlock(&rx.lock);
+
+    switch (strategy) {
+    case STRATEGY_STANDBY:
+    case STRATEGY_LIVE_SWAP:
+        if (to_ac3) switch_to_ac3_encode_pipeline(bench_appsrc);
+        else switch_to_pcm_pipeline(bench_appsrc);
+        break;
+    default:
+        init_audio_data_params(format);
+        handle_audio_format_change(format);
+        break;
+    }
+}
+
+static gint compare_double(gconstpointer a, gconstpointer b) {
+    gdouble x = *(const gdouble *)a, y = *(const gdouble *)b;
+    return (x > y) - (x < y);
+}
+
+// nearest-rank 백분위수 (값이 없으면 NAN)
+static gdouble percentile(GArray *values, gdouble p) {
+    guint rank;
+
+    if (values->len == 0) return NAN;
+    g_array_sort(values, compare_double);
+    rank = (guint)ceil(p / 100.0 * values->len);
+    rank = CLAMP(rank, 1, values->len);
+    return g_array_index(values, gdouble, rank - 1);
+}
+
+static void print_number(const char *sep, gdouble v) {
+    if (isnan(v)) fprintf(out, "%s%s", sep, json_output ? "null" : "");
+    else fprintf(out, "%s%.3f", sep, v);
+}
+
+static void report(Strategy strategy) {
+    gdouble stats[6];
+    guint completed;
+    guint64 lost;
+
+    g_mutex_lock(&rx.lock);
+    completed = rx.gaps_ms->len;
+    lost = rx.lost;
+    stats[0] = percentile(rx.gaps_ms, 50);
+    stats[1] = percentile(rx.gaps_ms, 99);
+    stats[2] = percentile(rx.gaps_ms, 100);
+    stats[3] = percentile(rx.decodable_ms, 50);
+    stats[4] = percentile(rx.decodable_ms, 99);
+    stats[5] = percentile(rx.decodable_ms, 100);
+    g_mutex_unlock(&rx.lock);
+
+    if (json_output) {
+        static const char *keys[6] = {
+            "gap_p50_ms", "gap_p99_ms", "gap_max_ms",
+            "first_decodable_p50_ms", "first_decodable_p99_ms", "first_decodable_max_ms"
+        };
+        fprintf(out, "{\"strategy\":\"%s\",\"switches\":%d,\"completed\":%u",
+                strategy_names[strategy], n_switches, completed);
+        for (int i = 0; i < 6; i++) {
+            fprintf(out, ",\"%s\":", keys[i]);
+            print_number("", stats[i]);
+        }
+        fprintf(out, ",\"packets_lost\":%" G_GUINT64_FORMAT "}\n", lost);
+    } else {
+        fprintf(out, "%s,%d,%u", strategy_names[strategy], n_switches, completed);
+        for (int i = 0; i < 6; i++) print_number(",", stats[i]);
+        fprintf(out, ",%" G_GUINT64_FORMAT "\n", lost);
+    }
+    fflush(out);
+}
+
+static void run_strategy(guint index);
+
+static gboolean on_strategy_done(gpointer data) {
+    Strategy strategy = run_list[run_index];
+
+    report(strategy);
+    stop_strategy(strategy);
+
+    if (++run_index < run_count) run_strategy(run_index);
+    else g_main_loop_quit(main_loop);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean on_switch_tick(gpointer data) {
+    if (switches_done >= n_switches) {
+        // 마지막 전환이 수신될 시간을 준 뒤 결과 출력
+        g_timeout_add(COOLDOWN_MS, on_strategy_done, NULL);
+        return G_SOURCE_REMOVE;
+    }
+
+    // 시작 포맷이 PCM이므로 AC3부터 번갈아 전환
+    request_switch(run_list[run_index], switches_done % 2 == 0);
+    switches_done++;
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_warmup_done(gpointer data) {
+    g_timeout_add(interval_ms, on_switch_tick, NULL);
+    return G_SOURCE_REMOVE;
+}
+
+static void run_strategy(guint index) {
+    Strategy strategy = run_list[index];
+
+    g_printerr("[BENCH] %s: %d회 전환, 간격 %d ms\n", strategy_names[strategy], n_switches, interval_ms);
+    receiver_reset();
+    switches_done = 0;
+
+    if (!start_strategy(strategy)) {
+        g_printerr("[BENCH] %s 시작 실패\n", strategy_names[strategy]);
+        g_timeout_add(0, on_strategy_done, NULL);
+        return;
+    }
+    g_timeout_add(WARMUP_MS, on_warmup_done, NULL);
+}
+
+int main(int argc, char *argv[]) {
+    GOptionContext *context;
+    GError *error = NULL;
+
+    gst_init(&argc, &argv);
+
+    context = g_option_context_new("- 코덱 전환 간격 벤치마크");
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("옵션 파싱 실패: %s\n", error->message);
+        g_error_free(error);
+        g_option_context_free(context);
+        return -1;
+    }
+    g_option_context_free(context);
+
+    for (int i = 0; i < N_STRATEGIES; i++) {
+        if (!only_strategy || g_strcmp0(only_strategy, strategy_names[i]) == 0)
+            run_list[run_count++] = (Strategy)i;
+    }
+    if (run_count == 0) {
+        g_printerr("알 수 없는 전략: %s\n", only_strategy);
+        return -1;
+    }
+
+    out = output_path ? fopen(output_path, "w") : stdout;
+    if (!out) {
+        g_printerr("결과 파일 열기 실패: %s\n", output_path);
+        return -1;
+    }
+    if (!json_output) {
+        fprintf(out, "strategy,switches,completed,gap_p50_ms,gap_p99_ms,gap_max_ms,"
+                     "first_decodable_p50_ms,first_decodable_p99_ms,first_decodable_max_ms,packets_lost\n");
+    }
+
+    rx.gaps_ms = g_array_new(FALSE, FALSE, sizeof(gdouble));
+    rx.decodable_ms = g_array_new(FALSE, FALSE, sizeof(gdouble));
+
+    // sender.c의 bus watch도 이 loop를 쓴다
+    main_loop = g_main_loop_new(NULL, FALSE);
+    if (!start_receiver()) return -1;
+
+    run_strategy(0);
+    g_main_loop_run(main_loop);
+
+    gst_element_set_state(recv_pipeline, GST_STATE_NULL);
+    gst_object_unref(recv_pipeline);
+    g_array_free(rx.gaps_ms, TRUE);
+    g_array_free(rx.decodable_ms, TRUE);
+    if (out != stdout) fclose(out);
+    g_main_loop_unref(main_loop);
+    return 0;
+}